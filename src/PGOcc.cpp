@@ -93,7 +93,8 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0;
-    int sPost = 0;  
+    int saveIter = 0;
+    R_xlen_t sPost = 0;  
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -195,10 +196,10 @@ extern "C" {
     /********************************************************************
       Some constants and temporary variables to be used later
     ********************************************************************/
-    int JpOcc = J * pOcc; 
-    int JpOccRE = J * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
+    int JpOcc = intProd(J, pOcc); 
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -288,9 +289,12 @@ extern "C" {
       /********************************************************************
        *Update Occupancy Auxiliary Variables 
        *******************************************************************/
+      // Linear predictors for all sites, then the PG draws in one batch. 
+      F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
       for (j = 0; j < J; j++) {
-        omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + betaStarSites[j]);
+        omegaOcc[j] += betaStarSites[j];
       } // j
+      rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
 
       /********************************************************************
        *Update Detection Auxiliary Variables 
@@ -499,6 +503,8 @@ extern "C" {
           }
         }
       }
+      // Likelihood values for WAIC are only needed on iterations that are saved.
+      saveIter = (s >= nBurn) && (thinIndx + 1 == nThin);
       /********************************************************************
        *Update Latent Occupancy
        *******************************************************************/
@@ -508,8 +514,10 @@ extern "C" {
           detProb[i] = logitInv(F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i], zero, one);
           psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + betaStarSites[zLongIndx[i]], zero, one); 
           piProd[zLongIndx[i]] = pow(1.0 - detProb[i], K[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	  if (saveIter) {
+	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	  }
           ySum[zLongIndx[i]] = y[i]; 	
         } // i
       } else {
@@ -519,8 +527,10 @@ extern "C" {
             psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + betaStarSites[zLongIndx[i]], zero, one); 
           }
           piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  if (saveIter) {
+	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  }
           ySum[zLongIndx[i]] += y[i]; 	
           tmp_J[zLongIndx[i]]++;
         } // i
@@ -531,10 +541,14 @@ extern "C" {
         psiNum = psi[j] * piProd[j]; 
         if (ySum[j] == zero) {
           z[j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j])));          
-	  yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j]; 
+	  if (saveIter) {
+	    yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j];
+	  }
         } else {
           z[j] = one; 
-	  yWAIC[j] = psi[j] * piProdWAIC[j];
+	  if (saveIter) {
+	    yWAIC[j] = psi[j] * piProdWAIC[j];
+	  }
         }
         piProd[j] = one;
 	piProdWAIC[j] = one;
@@ -7,7 +7,8 @@
 static const R_CallMethodDef CallEntries[] = {
     {"PGOcc", (DL_FUNC) &PGOcc, 35},
     {"spPGOcc", (DL_FUNC) &spPGOcc, 52}, 
-    {"spPGOccNNGP", (DL_FUNC) &spPGOccNNGP, 58},
+    {"spPGOccNNGP", (DL_FUNC) &spPGOccNNGP, 60},
+    {"spPGOccNNGPInit", (DL_FUNC) &spPGOccNNGPInit, 48},
     {"spPGOccPredict", (DL_FUNC) &spPGOccPredict, 15},
     {"spPGOccNNGPPredict", (DL_FUNC) &spPGOccNNGPPredict, 17},
     {"msPGOcc", (DL_FUNC) &msPGOcc, 43},
@@ -17,15 +18,15 @@ static const R_CallMethodDef CallEntries[] = {
     {"spMsPGOccNNGPPredict", (DL_FUNC) &spMsPGOccNNGPPredict, 18},
     {"intPGOcc", (DL_FUNC) &intPGOcc, 31},
     {"spIntPGOcc", (DL_FUNC) &spIntPGOcc, 48},
-    {"spIntPGOccNNGP", (DL_FUNC) &spIntPGOccNNGP, 54},
+    {"spIntPGOccNNGP", (DL_FUNC) &spIntPGOccNNGP, 55},
     {"lfMsPGOcc", (DL_FUNC) &lfMsPGOcc, 44},
     {"sfMsPGOccNNGP", (DL_FUNC) &sfMsPGOccNNGP, 61},
-    {"sfMsPGOccNNGPPredict", (DL_FUNC) &sfMsPGOccNNGPPredict, 20},
+    {"sfMsPGOccNNGPPredict", (DL_FUNC) &sfMsPGOccNNGPPredict, 21},
     {"lfJSDM", (DL_FUNC) &lfJSDM, 25},
     {"sfJSDMNNGP", (DL_FUNC) &sfJSDMNNGP, 44},
     {"tPGOcc", (DL_FUNC) &tPGOcc, 46},
-    {"stPGOccNNGP", (DL_FUNC) &stPGOccNNGP, 64},
-    {"stPGOccNNGPPredict", (DL_FUNC) &stPGOccNNGPPredict, 19},
+    {"stPGOccNNGP", (DL_FUNC) &stPGOccNNGP, 65},
+    {"stPGOccNNGPPredict", (DL_FUNC) &stPGOccNNGPPredict, 20},
     {"svcPGBinomNNGP", (DL_FUNC) &svcPGBinomNNGP, 45},
     {"svcPGOccNNGPPredict", (DL_FUNC) &svcPGOccNNGPPredict, 20},
     {"svcPGOccNNGP", (DL_FUNC) &svcPGOccNNGP, 59},
@@ -33,6 +34,18 @@ static const R_CallMethodDef CallEntries[] = {
     {"svcTPGOccNNGPPredict", (DL_FUNC) &svcTPGOccNNGPPredict, 22},
     {"svcTPGOccNNGP", (DL_FUNC) &svcTPGOccNNGP, 65},
     {"intMsPGOcc", (DL_FUNC) &intMsPGOcc, 48},
+    {"occSessionNew", (DL_FUNC) &occSessionNew, 2},
+    {"occSessionGet", (DL_FUNC) &occSessionGet, 1},
+    {"occSessionSetStates", (DL_FUNC) &occSessionSetStates, 2},
+    {"mkNNIndx0", (DL_FUNC) &mkNNIndx0, 8},
+    {"mkNNIndxAppend", (DL_FUNC) &mkNNIndxAppend, 9},
+    {"nnHash", (DL_FUNC) &nnHash, 1},
+    {"nnLogLik", (DL_FUNC) &nnLogLik, 10},
+    {"readOccData", (DL_FUNC) &readOccData, 1},
+    {"occLongIndx", (DL_FUNC) &occLongIndx, 3},
+    {"psisLoo", (DL_FUNC) &psisLoo, 4},
+    {"postSummary", (DL_FUNC) &postSummary, 3},
+    {"rbinomSamples", (DL_FUNC) &rbinomSamples, 1},
     {NULL, NULL, 0}
 };
 
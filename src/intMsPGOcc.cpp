@@ -108,7 +108,8 @@ extern "C" {
     int nChain = INTEGER(chainInfo_r)[1];
     int status = 0; 
     int thinIndx = 0;
-    int sPost = 0;  
+    int saveIter = 0;
+    R_xlen_t sPost = 0;  
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -158,10 +159,10 @@ extern "C" {
     for (i = 0; i < nData; i++) {
       nAlpha += NLong[i] * pDetLong[i];
     }
-    int JN = J * N;
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int JpOccRE = J * pOccRE; 
+    int JN = intProd(J, N);
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int JpOccRE = intProd(J, pOccRE); 
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double)); zeros(tmp_ppDet, ppDet);
@@ -641,6 +642,8 @@ extern "C" {
         } 
       } // i (species)
 
+      // Likelihood values for WAIC are only needed on iterations that are saved.
+      saveIter = (s >= nBurn) && (thinIndx + 1 == nThin);
       /********************************************************************
        *Update Latent Occupancy
        *******************************************************************/
@@ -657,9 +660,11 @@ extern "C" {
         		            betaStarSites[spLongIndx[r] * J + zLongIndx[r]], zero, one); 
         // }
         piProd[zLongIndx[r] * N + spLongIndx[r]] *= (1.0 - detProb[r]);
-        piProdWAIC[zLongIndx[r] * N + spLongIndx[r]] *= pow(detProb[r], y[r]);
-        piProdWAIC[zLongIndx[r] * N + spLongIndx[r]] *= pow(1.0 - detProb[r], 
-        		                                                 1.0 - y[r]);
+	if (saveIter) {
+	  piProdWAIC[zLongIndx[r] * N + spLongIndx[r]] *= pow(detProb[r], y[r]);
+	  piProdWAIC[zLongIndx[r] * N + spLongIndx[r]] *= pow(1.0 - detProb[r],
+									   1.0 - y[r]);
+	}
         ySum[zLongIndx[r] * N + spLongIndx[r]] += y[r]; 
         // tmp_J[zLongIndx[obsLongIndx[r]]]++;
       } // r
@@ -670,16 +675,22 @@ extern "C" {
           if (ySum[j * N + i] == zero) {
             if (spSiteIndx[j * N + i] == 1) {
               z[j * N + i] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j * N + i])));
-              yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      if (saveIter) {
+		yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      }
             } else {
               psi[j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + 
                                                        betaStarSites[i * J + j], zero, one);
               z[j * N + i] = rbinom(one, psi[j * N + i]);
-	      yWAIC[j * N + i] = NA_REAL;
+	      if (saveIter) {
+		yWAIC[j * N + i] = NA_REAL;
+	      }
             }
           } else {
             z[j * N + i] = one; 
-            yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i]; 
+	    if (saveIter) {
+	      yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i];
+	    }
           }
           // Reset variables
           piProd[j * N + i] = one;
@@ -80,7 +80,7 @@ extern "C" {
     int stNObs = 0; 
     int stAlpha = 0; 
     int thinIndx = 0;
-    int sPost = 0;  
+    R_xlen_t sPost = 0;  
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -154,8 +154,8 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
     double *tmp_pDet = (double *) R_alloc(pDet, sizeof(double));
@@ -231,9 +231,9 @@ extern "C" {
       /********************************************************************
        *Update Occupancy Auxiliary Variables 
        *******************************************************************/
-      for (j = 0; j < J; j++) {
-        omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc));
-      } // j
+      // Linear predictors for all sites, then the PG draws in one batch. 
+      F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
+      rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
       /********************************************************************
        *Update Detection Auxiliary Variables 
        *******************************************************************/
@@ -77,7 +77,7 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0; 
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -123,14 +123,13 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int nOccREN = nOccRE * N; 
-    int Jq = J * q;
+    int Jq = intProd(J, q);
     int qq = q * q;
-    int JN = J * N;
+    int JN = intProd(J, N);
     int Nq = N * q;
-    int JpOcc = J * pOcc; 
-    int JJ = J * J;
+    int JpOcc = intProd(J, pOcc); 
     int jj, kk;
-    int JpOccRE = J * pOccRE; 
+    int JpOccRE = intProd(J, pOccRE); 
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
@@ -357,9 +356,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, &omegaOcc[i], &N FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j * N + i] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j]);
+          omegaOcc[j * N + i] += wStar[j * N + i] + betaStarSites[i * J + j];
         } // j
+        rpgBatch(J, &one, 0, &omegaOcc[i], N, &omegaOcc[i], N);
         /********************************************************************
          *Update Occupancy Regression Coefficients
          *******************************************************************/
@@ -573,17 +575,21 @@ extern "C" {
       /********************************************************************
        *Get fitted values and occurrence probability
        *******************************************************************/
-      for (i = 0; i < N; i++) {
-        for (j = 0; j < J; j++) {
-          psi[j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j], zero, one); 
-          z[j * N + i] = rbinom(one, psi[j * N + i]);           
-	  if (y[j * N + i] == 1) {
-            yWAIC[j * N + i] = psi[j * N + i];
-	  } else {
-            yWAIC[j * N + i] = 1.0 - psi[j * N + i];
-	  }
-        } // j
-      } // i
+      // Fitted values and the WAIC likelihood are only needed on iterations
+      // that are saved.
+      if ((s >= nBurn) && (thinIndx + 1 == nThin)) {
+        for (i = 0; i < N; i++) {
+          for (j = 0; j < J; j++) {
+            psi[j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j], zero, one); 
+            z[j * N + i] = rbinom(one, psi[j * N + i]);           
+	    if (y[j * N + i] == 1) {
+              yWAIC[j * N + i] = psi[j * N + i];
+	    } else {
+              yWAIC[j * N + i] = 1.0 - psi[j * N + i];
+	    }
+          } // j
+        } // i
+      }
 
       /********************************************************************
        *Save samples
@@ -105,7 +105,8 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -151,19 +152,18 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int pDetN = pDet * N; 
-    int nObsN = nObs * N; 
+    int nObsN = intProd(nObs, N); 
     int nDetREN = nDetRE * N; 
     int nOccREN = nOccRE * N; 
-    int Jq = J * q;
+    int Jq = intProd(J, q);
     int qq = q * q;
-    int JN = J * N;
+    int JN = intProd(J, N);
     int Nq = N * q;
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int JJ = J * J;
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
     int jj, kk;
-    int JpOccRE = J * pOccRE; 
-    int nObspDetRE = nObs * pDetRE;
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDetRE = intProd(nObs, pDetRE);
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -527,9 +527,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, &omegaOcc[i], &N FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j * N + i] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j]);
+          omegaOcc[j * N + i] += wStar[j * N + i] + betaStarSites[i * J + j];
         } // j
+        rpgBatch(J, &one, 0, &omegaOcc[i], N, &omegaOcc[i], N);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -855,6 +858,8 @@ extern "C" {
         F77_NAME(dgemv)(ntran, &N, &q, &one, lambda, &N, &w[j*q], &inc, &zero, &wStar[j * N], &inc FCONE);
       } // j
 
+      // Likelihood values for WAIC are only needed on iterations that are saved.
+      saveIter = (s >= nBurn) && (thinIndx + 1 == nThin);
       /********************************************************************
        *Update Latent Occupancy
        *******************************************************************/
@@ -865,8 +870,10 @@ extern "C" {
             detProb[i * nObs + r] = logitInv(F77_NAME(ddot)(&pDet, &Xp[r], &nObs, &alpha[i], &N) + alphaStarObs[i * nObs + r], zero, one);
             psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + wStar[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
             piProd[zLongIndx[r] * N + i] = pow(1.0 - detProb[i * nObs + r], K[r]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	    }
             ySum[zLongIndx[r] * N + i] = y[r * N + i]; 
           } // r
         } else {
@@ -876,9 +883,11 @@ extern "C" {
               psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + wStar[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
             }
             piProd[zLongIndx[r] * N + i] *= (1.0 - detProb[i * nObs + r]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], 
-			                            1.0 - y[r * N + i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r],
+						      1.0 - y[r * N + i]);
+	    }
             ySum[zLongIndx[r] * N + i] += y[r * N + i]; 
             tmp_JInt[zLongIndx[r]]++;
           } // r
@@ -888,10 +897,14 @@ extern "C" {
           psiNum = psi[j * N + i] * piProd[j * N + i]; 
           if (ySum[j * N + i] == zero) {
             z[j * N + i] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j * N + i])));
-            yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	    if (saveIter) {
+	      yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	    }
           } else {
             z[j * N + i] = one; 
-            yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i]; 
+	    if (saveIter) {
+	      yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i];
+	    }
           }
           // Reset variables
           piProd[j * N + i] = one;
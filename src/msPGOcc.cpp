@@ -99,7 +99,8 @@ extern "C" {
     int nChain = INTEGER(chainInfo_r)[1];
     int status = 0; 
     int thinIndx = 0;
-    int sPost = 0;  
+    int saveIter = 0;
+    R_xlen_t sPost = 0;  
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -144,14 +145,14 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int pDetN = pDet * N; 
-    int nObsN = nObs * N; 
+    int nObsN = intProd(nObs, N); 
     int nOccREN = nOccRE * N; 
     int nDetREN = nDetRE * N; 
-    int JN = J * N;
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int JpOccRE = J * pOccRE; 
-    int nObspDetRE = nObs * pDetRE;
+    int JN = intProd(J, N);
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDetRE = intProd(nObs, pDetRE);
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -461,9 +462,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, omegaOcc, &inc FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + betaStarSites[i * J + j]);
+          omegaOcc[j] += betaStarSites[i * J + j];
         } // j
+        rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -650,6 +654,8 @@ extern "C" {
           }
         }
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (s >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -659,8 +665,10 @@ extern "C" {
             detProb[i * nObs + r] = logitInv(F77_NAME(ddot)(&pDet, &Xp[r], &nObs, &alpha[i], &N) + alphaStarObs[i * nObs + r], zero, one);
             psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + betaStarSites[i * J + zLongIndx[r]], zero, one); 
             piProd[zLongIndx[r] * N + i] = pow(1.0 - detProb[i * nObs + r], K[r]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	    }
             ySum[zLongIndx[r] * N + i] = y[r * N + i]; 
           } // r
         } else {
@@ -670,9 +678,11 @@ extern "C" {
               psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N)+ betaStarSites[i * J + zLongIndx[r]], zero, one); 
             }
             piProd[zLongIndx[r] * N + i] *= (1.0 - detProb[i * nObs + r]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	    piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], 
-			                            1.0 - y[r * N + i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r],
+						      1.0 - y[r * N + i]);
+	    }
             ySum[zLongIndx[r] * N + i] += y[r * N + i]; 
             tmp_J[zLongIndx[r]]++;
           } // r
@@ -682,10 +692,14 @@ extern "C" {
           psiNum = psi[j * N + i] * piProd[j * N + i]; 
           if (ySum[j * N + i] == zero) {
             z[j * N + i] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j * N + i])));
-            yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	    if (saveIter) {
+	      yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	    }
           } else {
             z[j * N + i] = one; 
-            yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i]; 
+	    if (saveIter) {
+	      yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i];
+	    }
           }
           // Reset variables
           piProd[j * N + i] = one;
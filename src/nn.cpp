@@ -14,6 +14,7 @@
 #include <Rmath.h>
 #include <Rinternals.h>
 #include <R_ext/BLAS.h>
+#include <R_ext/Lapack.h>
 #include <R_ext/Utils.h>
 #ifndef FCONE
 # define FCONE
@@ -81,7 +82,7 @@ SEXP mkNNIndx(SEXP n_r, SEXP m_r, SEXP coords_r, SEXP nnIndx_r, SEXP nnDist_r, S
   }
 #endif
 
-  int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(n-m-1)*m);
+  int nIndx = getNIndx(n, m);
   
   for(i = 0; i < nIndx; i++){
     nnDist[i] = std::numeric_limits<double>::infinity();
@@ -255,3 +256,480 @@ extern "C" {
     return R_NilValue;
   }
 }
+
+///////////////////////////////////////////////////////////////////
+//prediction sites
+///////////////////////////////////////////////////////////////////
+
+//Description: code book search for the m nearest neighbors of a point that is not in the 
+//reference set, e.g., a prediction site. The reference set is not restricted by the NNGP ordering.
+//Input:
+//m = number of nearest neighbors
+//n = number of reference locations
+//coords = n x 2 reference coordinates
+//u = x+y of the reference coordinates sorted on input
+//sIndx = order of the reference coordinates that sorts u
+//c0 = pointer to the x coordinate of the point, with y at c0[inc0]
+//rIndx = vector of length m to store the resulting nn index
+//rNNDist = vector of length m to store the resulting nn Euclidean distance
+void fastNN0(int m, int n, double *coords, double *u, int *sIndx, double *c0, int inc0, int *rIndx, double *rNNDist){
+
+  int i, j, lo, hi, mid;
+  bool up, down;
+  double dm, de;
+  double u0 = c0[0]+c0[inc0];
+
+  //rNNDist will hold de (i.e., squared Euclidean distance) initially.
+  for(i = 0; i < m; i++){
+    rNNDist[i] = std::numeric_limits<double>::infinity();
+    rIndx[i] = -1;
+  }
+
+  //first reference point with u >= u0
+  lo = 0;
+  hi = n;
+  while(lo < hi){
+    mid = lo + (hi-lo)/2;
+    if(u[mid] < u0){
+      lo = mid+1;
+    }else{
+      hi = mid;
+    }
+  }
+
+  i = lo-1;
+  j = lo;
+  down = i >= 0;
+  up = j < n;
+
+  while(up || down){
+
+    if(down){
+      dm = pow(u0-u[i], 2);
+      if(dm > 2*rNNDist[m-1]){
+	down = false;
+      }else{
+	de = pow(c0[0]-coords[sIndx[i]], 2)+pow(c0[inc0]-coords[n+sIndx[i]], 2);
+	if(de < rNNDist[m-1]){
+	  rNNDist[m-1] = de;
+	  rIndx[m-1] = sIndx[i];
+	  rsort_with_index(rNNDist, rIndx, m);
+	}
+	i--;
+	if(i < 0){
+	  down = false;
+	}
+      }
+    }//end down
+
+    if(up){
+      dm = pow(u[j]-u0, 2);
+      if(dm > 2*rNNDist[m-1]){
+	up = false;
+      }else{
+	de = pow(c0[0]-coords[sIndx[j]], 2)+pow(c0[inc0]-coords[n+sIndx[j]], 2);
+	if(de < rNNDist[m-1]){
+	  rNNDist[m-1] = de;
+	  rIndx[m-1] = sIndx[j];
+	  rsort_with_index(rNNDist, rIndx, m);
+	}
+	j++;
+	if(j == n){
+	  up = false;
+	}
+      }
+    }//end up
+
+  }
+
+  for(i = 0; i < m; i++){
+    rNNDist[i] = sqrt(rNNDist[i]);
+  }
+
+  return;
+}
+
+extern "C" {
+  SEXP mkNNIndx0(SEXP n_r, SEXP m_r, SEXP coords_r, SEXP q_r, SEXP coords0_r, SEXP nnIndx0_r, SEXP nnDist0_r, SEXP nThreads_r){
+
+    int n = INTEGER(n_r)[0];
+    int m = INTEGER(m_r)[0];
+    double *coords = REAL(coords_r);
+    int q = INTEGER(q_r)[0];
+    double *coords0 = REAL(coords0_r);
+    int *nnIndx0 = INTEGER(nnIndx0_r);
+    double *nnDist0 = REAL(nnDist0_r);
+    int nThreads = INTEGER(nThreads_r)[0];
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    if(m > n){
+      error("c++ error: the number of neighbors exceeds the number of reference locations\n");
+    }
+
+    int i, k, threadID = 0;
+
+    int *sIndx = (int *) R_alloc(n, sizeof(int));
+    double *u = (double *) R_alloc(n, sizeof(double));
+    int *rIndx = (int *) R_alloc(nThreads*m, sizeof(int));
+    double *rNNDist = (double *) R_alloc(nThreads*m, sizeof(double));
+
+    for(i = 0; i < n; i++){
+      sIndx[i] = i;
+      u[i] = coords[i]+coords[n+i];
+    }
+
+    rsort_with_index(u, sIndx, n);
+
+    //nnIndx0 and nnDist0 are q x m, column major
+#ifdef _OPENMP
+#pragma omp parallel for private(k, threadID)
+#endif
+    for(i = 0; i < q; i++){
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      fastNN0(m, n, coords, u, sIndx, &coords0[i], q, &rIndx[threadID*m], &rNNDist[threadID*m]);
+      for(k = 0; k < m; k++){
+	nnIndx0[static_cast<R_xlen_t>(q)*k+i] = rIndx[threadID*m+k];
+	nnDist0[static_cast<R_xlen_t>(q)*k+i] = rNNDist[threadID*m+k];
+      }
+    }
+
+    return R_NilValue;
+  }
+}
+
+///////////////////////////////////////////////////////////////////
+//appending sites
+///////////////////////////////////////////////////////////////////
+
+//Extends the neighbor and u index of n ordered locations with nNew
+//locations placed at the end of the ordering. The neighbor sets of the
+//existing locations are unchanged; only the sets of the new locations are
+//found (code book search among the existing locations, and a second code
+//book over the new locations restricted to earlier ones, as in mkNNIndxCB)
+//and their entries appended to the u index.
+//coords holds all n+nNew locations, column major, in the NNGP order.
+extern "C" {
+  SEXP mkNNIndxAppend(SEXP n_r, SEXP nNew_r, SEXP m_r, SEXP coords_r, SEXP nnIndx_r, SEXP uIndx_r, SEXP uIndxLU_r, SEXP uiIndx_r, SEXP nThreads_r){
+
+    int n = INTEGER(n_r)[0];
+    int nNew = INTEGER(nNew_r)[0];
+    int m = INTEGER(m_r)[0];
+    double *coords = REAL(coords_r);
+    int *nnIndx = INTEGER(nnIndx_r);
+    int *uIndx = INTEGER(uIndx_r);
+    int *uIndxLU = INTEGER(uIndxLU_r);
+    int *uiIndx = INTEGER(uiIndx_r);
+    int nThreads = INTEGER(nThreads_r)[0];
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    if(n <= m){
+      error("c++ error: the number of existing locations must exceed the number of neighbors\n");
+    }
+
+    int i, j, k, l, t, iNNIndx, iNN, threadID = 0, nProtect = 0;
+    int N = n+nNew;
+    int nIndx = getNIndx(n, m);
+    int nIndxNew = getNIndx(N, m);
+
+    SEXP nnIndxNew_r, nnIndxLUNew_r, uIndxNew_r, uIndxLUNew_r, uiIndxNew_r;
+    PROTECT(nnIndxNew_r = allocVector(INTSXP, nIndxNew)); nProtect++;
+    PROTECT(nnIndxLUNew_r = allocVector(INTSXP, 2*N)); nProtect++;
+    PROTECT(uIndxNew_r = allocVector(INTSXP, nIndxNew)); nProtect++;
+    PROTECT(uIndxLUNew_r = allocVector(INTSXP, 2*N)); nProtect++;
+    PROTECT(uiIndxNew_r = allocVector(INTSXP, nIndxNew)); nProtect++;
+    int *nnIndxNew = INTEGER(nnIndxNew_r);
+    int *nnIndxLUNew = INTEGER(nnIndxLUNew_r);
+    int *uIndxNew = INTEGER(uIndxNew_r);
+    int *uIndxLUNew = INTEGER(uIndxLUNew_r);
+    int *uiIndxNew = INTEGER(uiIndxNew_r);
+
+    for(i = 0; i < N; i++){
+      getNNIndx(i, m, iNNIndx, iNN);
+      nnIndxLUNew[i] = iNNIndx;
+      nnIndxLUNew[N+i] = iNN;
+    }
+    for(i = 0; i < nIndx; i++){
+      nnIndxNew[i] = nnIndx[i];
+    }
+
+    //code book of the existing locations
+    int *sIndx = (int *) R_alloc(n, sizeof(int));
+    double *u = (double *) R_alloc(n, sizeof(double));
+    double *coordsOld = (double *) R_alloc(2*n, sizeof(double));
+    double *rNNDist = (double *) R_alloc(nThreads*m, sizeof(double));
+
+    for(i = 0; i < n; i++){
+      sIndx[i] = i;
+      u[i] = coords[i]+coords[N+i];
+      coordsOld[i] = coords[i];
+      coordsOld[n+i] = coords[N+i];
+    }
+
+    rsort_with_index(u, sIndx, n);
+
+    //code book of the new locations; uPos gives the position of each in uNew
+    int *sIndxNew = (int *) R_alloc(nNew, sizeof(int));
+    int *uPos = (int *) R_alloc(nNew, sizeof(int));
+    double *uNew = (double *) R_alloc(nNew, sizeof(double));
+    double *coordsNew = (double *) R_alloc(2*nNew, sizeof(double));
+    int *rIndxNew = (int *) R_alloc(nThreads*m, sizeof(int));
+    double *rNNDistNew = (double *) R_alloc(nThreads*m, sizeof(double));
+
+    for(i = 0; i < nNew; i++){
+      sIndxNew[i] = i;
+      uNew[i] = coords[n+i]+coords[N+n+i];
+      coordsNew[i] = coords[n+i];
+      coordsNew[nNew+i] = coords[N+n+i];
+    }
+
+    rsort_with_index(uNew, sIndxNew, nNew);
+
+    for(i = 0; i < nNew; i++){
+      uPos[sIndxNew[i]] = i;
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for private(j, t, iNN, iNNIndx, threadID)
+#endif
+    for(i = n; i < N; i++){
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      iNNIndx = nnIndxLUNew[i];
+      fastNN0(m, n, coordsOld, u, sIndx, &coords[i], N, &nnIndxNew[iNNIndx], &rNNDist[threadID*m]);
+      //nearest earlier new locations, merged into the existing set
+      t = i-n;
+      iNN = t < m ? t : m;
+      if(iNN > 0){
+	fastNN(iNN, nNew, coordsNew, uPos[t], uNew, sIndxNew, &rIndxNew[threadID*m], &rNNDistNew[threadID*m]);
+	for(j = 0; j < iNN; j++){
+	  if(rNNDistNew[threadID*m+j] >= rNNDist[threadID*m+m-1]){
+	    break;
+	  }
+	  rNNDist[threadID*m+m-1] = rNNDistNew[threadID*m+j];
+	  nnIndxNew[iNNIndx+m-1] = n+rIndxNew[threadID*m+j];
+	  rsort_with_index(&rNNDist[threadID*m], &nnIndxNew[iNNIndx], m);
+	}
+      }
+    }
+
+    //u index: existing lists are kept in place and the new locations, which
+    //come last in the ordering, are added to the end of each list
+    for(i = 0; i < n; i++){
+      uIndxLUNew[N+i] = uIndxLU[n+i];
+    }
+    for(i = n; i < N; i++){
+      uIndxLUNew[N+i] = 0;
+    }
+    for(i = n; i < N; i++){
+      for(l = 0; l < m; l++){
+	uIndxLUNew[N+nnIndxNew[nnIndxLUNew[i]+l]]++;
+      }
+    }
+    uIndxLUNew[0] = 0;
+    for(i = 1; i < N; i++){
+      uIndxLUNew[i] = uIndxLUNew[i-1]+uIndxLUNew[N+i-1];
+    }
+    for(i = 0; i < n; i++){
+      for(j = 0; j < uIndxLU[n+i]; j++){
+	uIndxNew[uIndxLUNew[i]+j] = uIndx[uIndxLU[i]+j];
+	uiIndxNew[uIndxLUNew[i]+j] = uiIndx[uIndxLU[i]+j];
+      }
+    }
+    int *fill = (int *) R_alloc(N, sizeof(int));
+    for(i = 0; i < N; i++){
+      fill[i] = i < n ? uIndxLU[n+i] : 0;
+    }
+    for(i = n; i < N; i++){
+      for(l = 0; l < m; l++){
+	k = nnIndxNew[nnIndxLUNew[i]+l];
+	uIndxNew[uIndxLUNew[k]+fill[k]] = i;
+	uiIndxNew[uIndxLUNew[k]+fill[k]] = l;
+	fill[k]++;
+      }
+    }
+
+    //make return object
+    SEXP result_r, resultName_r;
+    int nResultListObjs = 5;
+
+    PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+    PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+
+    SET_VECTOR_ELT(result_r, 0, nnIndxNew_r);
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("nnIndx"));
+
+    SET_VECTOR_ELT(result_r, 1, nnIndxLUNew_r);
+    SET_VECTOR_ELT(resultName_r, 1, mkChar("nnIndxLU"));
+
+    SET_VECTOR_ELT(result_r, 2, uIndxNew_r);
+    SET_VECTOR_ELT(resultName_r, 2, mkChar("uIndx"));
+
+    SET_VECTOR_ELT(result_r, 3, uIndxLUNew_r);
+    SET_VECTOR_ELT(resultName_r, 3, mkChar("uIndxLU"));
+
+    SET_VECTOR_ELT(result_r, 4, uiIndxNew_r);
+    SET_VECTOR_ELT(resultName_r, 4, mkChar("uiIndx"));
+
+    namesgets(result_r, resultName_r);
+
+    UNPROTECT(nProtect);
+
+    return(result_r);
+  }
+}
+
+///////////////////////////////////////////////////////////////////
+//cache keys
+///////////////////////////////////////////////////////////////////
+
+//64-bit FNV-1a hash of the bytes of an integer or double vector, returned
+//as a hexadecimal string for use in neighbor index cache file names
+extern "C" {
+  SEXP nnHash(SEXP x_r){
+
+    unsigned char *x;
+    R_xlen_t i, nBytes;
+    unsigned long long h = 14695981039346656037ULL;
+    char key[17];
+
+    if(TYPEOF(x_r) == REALSXP){
+      x = (unsigned char *) REAL(x_r);
+      nBytes = XLENGTH(x_r)*sizeof(double);
+    }else if(TYPEOF(x_r) == INTSXP){
+      x = (unsigned char *) INTEGER(x_r);
+      nBytes = XLENGTH(x_r)*sizeof(int);
+    }else{
+      error("c++ error: nnHash requires an integer or double vector\n");
+    }
+
+    for(i = 0; i < nBytes; i++){
+      h ^= x[i];
+      h *= 1099511628211ULL;
+    }
+
+    snprintf(key, 17, "%016llx", h);
+
+    return mkString(key);
+  }
+}
+
+///////////////////////////////////////////////////////////////////
+//NNGP log-likelihood
+///////////////////////////////////////////////////////////////////
+
+//Log-density of each column of the n x nW matrix w under the NNGP with the given
+//neighbors, covariance model, and theta = (sigma^2, phi, nu), using the same 
+//conditional regressions B and F as the samplers. Used by nnSelect() to compare 
+//numbers of neighbors.
+extern "C" {
+  SEXP nnLogLik(SEXP coords_r, SEXP n_r, SEXP m_r, SEXP nnIndx_r, SEXP nnIndxLU_r, SEXP w_r, SEXP nW_r, 
+		SEXP theta_r, SEXP covModel_r, SEXP nThreads_r){
+
+    int i, j, k, l, info = 0, threadID = 0;
+    int inc = 1;
+    double one = 1.0;
+    double zero = 0.0;
+    char lower = 'L';
+    double e, a;
+
+    double *coords = REAL(coords_r);
+    int n = INTEGER(n_r)[0];
+    int m = INTEGER(m_r)[0];
+    int mm = m*m;
+    int *nnIndx = INTEGER(nnIndx_r);
+    int *nnIndxLU = INTEGER(nnIndxLU_r);
+    double *w = REAL(w_r);
+    int nW = INTEGER(nW_r)[0];
+    double sigmaSq = REAL(theta_r)[0];
+    double phi = REAL(theta_r)[1];
+    double nu = REAL(theta_r)[2];
+    int covModel = INTEGER(covModel_r)[0];
+    int nThreads = INTEGER(nThreads_r)[0];
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    int nIndx = nnIndxLU[n-1]+nnIndxLU[2*n-1];
+    //bk must be 1+(int)floor(nu) * nthread
+    int nb = covModel == 2 ? 1+static_cast<int>(floor(nu)) : 1;
+    double *B = (double *) R_alloc(nIndx, sizeof(double));
+    double *F = (double *) R_alloc(n, sizeof(double));
+    double *c = (double *) R_alloc(m*nThreads, sizeof(double));
+    double *C = (double *) R_alloc(mm*nThreads, sizeof(double));
+    double *bk = (double *) R_alloc(nb*nThreads, sizeof(double));
+
+#ifdef _OPENMP
+#pragma omp parallel for private(k, l, info, threadID, e)
+#endif
+    for(i = 0; i < n; i++){
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      if(nnIndxLU[n+i] > 0){
+	for(k = 0; k < nnIndxLU[n+i]; k++){
+	  e = dist2(coords[i], coords[n+i], coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]]);
+	  c[m*threadID+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	  for(l = 0; l <= k; l++){
+	    e = dist2(coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]], coords[nnIndx[nnIndxLU[i]+l]], coords[n+nnIndx[nnIndxLU[i]+l]]);
+	    C[mm*threadID+l*nnIndxLU[n+i]+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	  }
+	}
+	F77_NAME(dpotrf)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotrf failed\n");}
+	F77_NAME(dpotri)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotri failed\n");}
+	F77_NAME(dsymv)(&lower, &nnIndxLU[n+i], &one, &C[mm*threadID], &nnIndxLU[n+i], &c[m*threadID], &inc, &zero, &B[nnIndxLU[i]], &inc FCONE);
+	F[i] = sigmaSq - F77_NAME(ddot)(&nnIndxLU[n+i], &B[nnIndxLU[i]], &inc, &c[m*threadID], &inc);
+      }else{
+	F[i] = sigmaSq;
+      }
+    }
+
+    SEXP logLik_r;
+    PROTECT(logLik_r = allocVector(REALSXP, nW));
+    double *logLik = REAL(logLik_r);
+
+    for(j = 0; j < nW; j++){
+      double *wj = &w[static_cast<R_xlen_t>(j)*n];
+      a = 0.0;
+#ifdef _OPENMP
+#pragma omp parallel for private(k, e) reduction(+:a)
+#endif
+      for(i = 0; i < n; i++){
+	e = wj[i];
+	for(k = 0; k < nnIndxLU[n+i]; k++){
+	  e -= B[nnIndxLU[i]+k]*wj[nnIndx[nnIndxLU[i]+k]];
+	}
+	a += log(F[i]) + e*e/F[i];
+      }
+      logLik[j] = -0.5*(n*log(2.0*M_PI) + a);
+    }
+
+    UNPROTECT(1);
+
+    return(logLik_r);
+  }
+}
@@ -33,3 +33,26 @@ void fastNN(int m, int n, double *coords, int ui, double *u, int *sIndx, int *rS
 extern "C" {
   SEXP mkNNIndxCB(SEXP n_r, SEXP m_r, SEXP coords_r, SEXP nnIndx_r, SEXP nnDist_r, SEXP nnIndxLU_r, SEXP nThreads_r);
 }
+
+///////////////////////////////////////////////////////////////////
+//prediction sites
+///////////////////////////////////////////////////////////////////
+void fastNN0(int m, int n, double *coords, double *u, int *sIndx, double *c0, int inc0, int *rIndx, double *rNNDist);
+
+extern "C" {
+  SEXP mkNNIndx0(SEXP n_r, SEXP m_r, SEXP coords_r, SEXP q_r, SEXP coords0_r, SEXP nnIndx0_r, SEXP nnDist0_r, SEXP nThreads_r);
+}
+
+///////////////////////////////////////////////////////////////////
+//appending sites
+///////////////////////////////////////////////////////////////////
+extern "C" {
+  SEXP mkNNIndxAppend(SEXP n_r, SEXP nNew_r, SEXP m_r, SEXP coords_r, SEXP nnIndx_r, SEXP uIndx_r, SEXP uIndxLU_r, SEXP uiIndx_r, SEXP nThreads_r);
+}
+
+///////////////////////////////////////////////////////////////////
+//cache keys
+///////////////////////////////////////////////////////////////////
+extern "C" {
+  SEXP nnHash(SEXP x_r);
+}
@@ -0,0 +1,376 @@
+#include <string>
+#include <cstring>
+#include <cstdio>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <R.h>
+#include <Rmath.h>
+#include <Rinternals.h>
+#include <R_ext/Utils.h>
+
+// Columnar binary detection-nondetection data (written by writeOccData).
+// All values are little-endian. The layout is
+//   "SPOCCDAT", then int32 version, J, K, nDet, nOcc, hasCoords,
+//   then for each detection and occupancy covariate an int32 name length
+//   followed by the name, zero padded to a multiple of 8 bytes,
+//   then the double columns y (J x K), each detection covariate (J x K),
+//   each occupancy covariate (J), and the coordinates (J x 2), all column
+//   major.
+// The file is memory-mapped and each column is copied once into the R
+// object returned to the front end.
+
+static const char *occDataMagic = "SPOCCDAT";
+
+#ifndef _WIN32
+typedef struct {
+  void *map;
+  size_t size;
+} occDataMap;
+
+static void occDataUnmap(SEXP map_r){
+  occDataMap *m = (occDataMap *) R_ExternalPtrAddr(map_r);
+  if (m != NULL) {
+    munmap(m->map, m->size);
+    R_Free(m);
+    R_ClearExternalPtr(map_r);
+  }
+}
+#endif
+
+typedef struct {
+  const unsigned char *data;
+  size_t size;
+  size_t pos;
+} occDataCursor;
+
+static int32_t readInt(occDataCursor *cur){
+  int32_t x;
+  if (cur->pos + sizeof(int32_t) > cur->size) {
+    error("c++ error: the occupancy data file is truncated\n");
+  }
+  memcpy(&x, cur->data + cur->pos, sizeof(int32_t));
+  cur->pos += sizeof(int32_t);
+  return(x);
+}
+
+static SEXP readColumn(occDataCursor *cur, int nRow, int nCol){
+  SEXP x_r;
+  size_t nBytes = static_cast<size_t>(nRow) * nCol * sizeof(double);
+  if (cur->pos + nBytes > cur->size) {
+    error("c++ error: the occupancy data file is truncated\n");
+  }
+  if (nCol > 1) {
+    PROTECT(x_r = allocMatrix(REALSXP, nRow, nCol));
+  } else {
+    PROTECT(x_r = allocVector(REALSXP, nRow));
+  }
+  memcpy(REAL(x_r), cur->data + cur->pos, nBytes);
+  cur->pos += nBytes;
+  UNPROTECT(1);
+  return(x_r);
+}
+
+static SEXP readOccDataBuffer(occDataCursor *cur){
+
+  int i, nProtect = 0;
+
+  if (cur->size < 8 || memcmp(cur->data, occDataMagic, 8) != 0) {
+    error("c++ error: the file is not an occupancy data file\n");
+  }
+  cur->pos = 8;
+  int version = readInt(cur);
+  if (version != 1) {
+    error("c++ error: unsupported occupancy data file version %i\n", version);
+  }
+  int J = readInt(cur);
+  int K = readInt(cur);
+  int nDet = readInt(cur);
+  int nOcc = readInt(cur);
+  int hasCoords = readInt(cur);
+  if (J < 1 || K < 1 || nDet < 0 || nOcc < 0) {
+    error("c++ error: the occupancy data file header is corrupt\n");
+  }
+
+  SEXP detNames_r, occNames_r;
+  PROTECT(detNames_r = allocVector(STRSXP, nDet)); nProtect++;
+  PROTECT(occNames_r = allocVector(STRSXP, nOcc)); nProtect++;
+  for (i = 0; i < nDet + nOcc; i++) {
+    int nChar = readInt(cur);
+    if (nChar < 0 || cur->pos + nChar > cur->size) {
+      error("c++ error: the occupancy data file is truncated\n");
+    }
+    std::string name(reinterpret_cast<const char *>(cur->data + cur->pos), nChar);
+    cur->pos += nChar;
+    if (i < nDet) {
+      SET_STRING_ELT(detNames_r, i, mkChar(name.c_str()));
+    } else {
+      SET_STRING_ELT(occNames_r, i - nDet, mkChar(name.c_str()));
+    }
+  }
+  cur->pos = (cur->pos + 7) / 8 * 8;
+
+  SEXP y_r, detCovs_r, occCovs_r, coords_r;
+  PROTECT(y_r = readColumn(cur, J, K)); nProtect++;
+  PROTECT(detCovs_r = allocVector(VECSXP, nDet)); nProtect++;
+  for (i = 0; i < nDet; i++) {
+    SET_VECTOR_ELT(detCovs_r, i, readColumn(cur, J, K));
+  }
+  setAttrib(detCovs_r, R_NamesSymbol, detNames_r);
+  PROTECT(occCovs_r = allocVector(VECSXP, nOcc)); nProtect++;
+  for (i = 0; i < nOcc; i++) {
+    SET_VECTOR_ELT(occCovs_r, i, readColumn(cur, J, 1));
+  }
+  setAttrib(occCovs_r, R_NamesSymbol, occNames_r);
+  if (hasCoords) {
+    PROTECT(coords_r = readColumn(cur, J, 2)); nProtect++;
+  } else {
+    coords_r = R_NilValue;
+  }
+
+  // make return object
+  SEXP result_r, resultName_r;
+  int nResultListObjs = 4;
+
+  PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+  PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+
+  SET_VECTOR_ELT(result_r, 0, y_r);
+  SET_VECTOR_ELT(resultName_r, 0, mkChar("y"));
+
+  SET_VECTOR_ELT(result_r, 1, detCovs_r);
+  SET_VECTOR_ELT(resultName_r, 1, mkChar("det.covs"));
+
+  SET_VECTOR_ELT(result_r, 2, occCovs_r);
+  SET_VECTOR_ELT(resultName_r, 2, mkChar("occ.covs"));
+
+  SET_VECTOR_ELT(result_r, 3, coords_r);
+  SET_VECTOR_ELT(resultName_r, 3, mkChar("coords"));
+
+  namesgets(result_r, resultName_r);
+
+  UNPROTECT(nProtect);
+
+  return(result_r);
+}
+
+extern "C" {
+
+  SEXP readOccData(SEXP file_r){
+
+    const char *file = R_ExpandFileName(CHAR(STRING_ELT(file_r, 0)));
+    occDataCursor cur;
+    SEXP result_r;
+
+#ifndef _WIN32
+    int fd = open(file, O_RDONLY);
+    if (fd < 0) {
+      error("c++ error: cannot open file '%s'\n", file);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      error("c++ error: cannot read file '%s'\n", file);
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+      error("c++ error: cannot map file '%s'\n", file);
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    // The mapping is owned by an external pointer so it is released by the
+    // finalizer if reading stops with an error.
+    occDataMap *m = R_Calloc(1, occDataMap);
+    m->map = map;
+    m->size = st.st_size;
+    SEXP map_r;
+    PROTECT(map_r = R_MakeExternalPtr(m, R_NilValue, R_NilValue));
+    R_RegisterCFinalizerEx(map_r, occDataUnmap, TRUE);
+    cur.data = (const unsigned char *) map;
+    cur.size = st.st_size;
+    cur.pos = 0;
+    PROTECT(result_r = readOccDataBuffer(&cur));
+    occDataUnmap(map_r);
+    UNPROTECT(2);
+#else
+    FILE *f = fopen(file, "rb");
+    if (f == NULL) {
+      error("c++ error: cannot open file '%s'\n", file);
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *buf = (unsigned char *) R_alloc(size, sizeof(unsigned char));
+    size_t nRead = fread(buf, 1, size, f);
+    fclose(f);
+    cur.data = buf;
+    cur.size = nRead;
+    cur.pos = 0;
+    result_r = readOccDataBuffer(&cur);
+#endif
+
+    return(result_r);
+  }
+
+  // Long format of a J x K detection-nondetection matrix in a single pass
+  // over its columns: the observed values, the (zero-based) site of each,
+  // their positions in the J x K matrix, and the rows of the detection
+  // design matrices that go with them (only compacted when they have J x K
+  // rows). The sorted levels of each column of the random effect design
+  // matrix (zero-based codes from parseFormula) are found in the same pass.
+  SEXP occLongIndx(SEXP y_r, SEXP Xp_r, SEXP XpRE_r){
+
+    int i, j, k, l, nProtect = 0;
+    R_xlen_t r, s;
+
+    int J = INTEGER(getAttrib(y_r, R_DimSymbol))[0];
+    int K = INTEGER(getAttrib(y_r, R_DimSymbol))[1];
+    double *y = REAL(y_r);
+    R_xlen_t JK = static_cast<R_xlen_t>(J) * K;
+
+    int nObs = 0;
+    for (r = 0; r < JK; r++) {
+      if (!ISNAN(y[r])) {
+	nObs++;
+      }
+    }
+
+    SEXP yLong_r, zLongIndx_r, namesLong_r;
+    PROTECT(yLong_r = allocVector(REALSXP, nObs)); nProtect++;
+    PROTECT(zLongIndx_r = allocVector(INTSXP, nObs)); nProtect++;
+    PROTECT(namesLong_r = allocVector(REALSXP, nObs)); nProtect++;
+    double *yLong = REAL(yLong_r);
+    int *zLongIndx = INTEGER(zLongIndx_r);
+    double *namesLong = REAL(namesLong_r);
+
+    l = 0;
+    for (k = 0; k < K; k++) {
+      for (j = 0; j < J; j++) {
+	r = static_cast<R_xlen_t>(k) * J + j;
+	if (!ISNAN(y[r])) {
+	  yLong[l] = y[r];
+	  zLongIndx[l] = j;
+	  namesLong[l] = r + 1;
+	  l++;
+	}
+      }
+    }
+
+    // Design matrices, one column at a time
+    SEXP des_r[2] = {Xp_r, XpRE_r};
+    SEXP desLong_r[2];
+    SEXP levels_r;
+    int nColRE = INTEGER(getAttrib(XpRE_r, R_DimSymbol))[1];
+    PROTECT(levels_r = allocVector(VECSXP, nColRE)); nProtect++;
+    for (i = 0; i < 2; i++) {
+      SEXP dim_r = getAttrib(des_r[i], R_DimSymbol);
+      int nRow = INTEGER(dim_r)[0];
+      int nCol = INTEGER(dim_r)[1];
+      bool compact = (nRow == JK && nCol > 0);
+      bool isReal = (TYPEOF(des_r[i]) == REALSXP);
+      if (compact) {
+        PROTECT(desLong_r[i] = allocMatrix(TYPEOF(des_r[i]), nObs, nCol)); nProtect++;
+      } else {
+	desLong_r[i] = des_r[i];
+	if (i == 0) {
+	  continue;
+	}
+      }
+      // Levels seen in the current random effect column. Codes are below
+      // the number of rows.
+      char *seen = NULL;
+      if (i == 1 && nCol > 0) {
+	seen = (char *) R_alloc(nRow, sizeof(char));
+      }
+      int nRowLong = compact ? nObs : nRow;
+      for (k = 0; k < nCol; k++) {
+	if (seen != NULL) {
+	  memset(seen, 0, nRow);
+	}
+	for (l = 0; l < nRowLong; l++) {
+	  s = compact ? static_cast<R_xlen_t>(namesLong[l]) - 1 : l;
+	  double v;
+	  if (isReal) {
+	    v = REAL(des_r[i])[static_cast<R_xlen_t>(k) * nRow + s];
+	    if (compact) {
+	      REAL(desLong_r[i])[static_cast<R_xlen_t>(k) * nObs + l] = v;
+	    }
+	  } else {
+	    v = INTEGER(des_r[i])[static_cast<R_xlen_t>(k) * nRow + s];
+	    if (compact) {
+	      INTEGER(desLong_r[i])[static_cast<R_xlen_t>(k) * nObs + l] = static_cast<int>(v);
+	    }
+	  }
+	  if (seen != NULL) {
+	    if (ISNAN(v) || v < 0 || v >= nRow) {
+	      error("c++ error: invalid random effect level in column %i of X.p.re\n", k + 1);
+	    }
+	    seen[static_cast<R_xlen_t>(v)] = 1;
+	  }
+	}
+	if (seen != NULL) {
+	  int nLevels = 0;
+	  for (s = 0; s < nRow; s++) {
+	    nLevels += seen[s];
+	  }
+	  SEXP lev_r;
+	  PROTECT(lev_r = allocVector(REALSXP, nLevels));
+	  for (s = 0, j = 0; s < nRow; s++) {
+	    if (seen[s]) {
+	      REAL(lev_r)[j++] = s;
+	    }
+	  }
+	  SET_VECTOR_ELT(levels_r, k, lev_r);
+	  UNPROTECT(1);
+	}
+      }
+      if (!compact) {
+	continue;
+      }
+      SEXP dimNames_r = getAttrib(des_r[i], R_DimNamesSymbol);
+      if (dimNames_r != R_NilValue) {
+	SEXP dimNamesLong_r;
+	PROTECT(dimNamesLong_r = allocVector(VECSXP, 2)); nProtect++;
+	SET_VECTOR_ELT(dimNamesLong_r, 1, VECTOR_ELT(dimNames_r, 1));
+	setAttrib(desLong_r[i], R_DimNamesSymbol, dimNamesLong_r);
+      }
+    }
+
+    // make return object
+    SEXP result_r, resultName_r;
+    int nResultListObjs = 6;
+
+    PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+    PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+
+    SET_VECTOR_ELT(result_r, 0, yLong_r);
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("y"));
+
+    SET_VECTOR_ELT(result_r, 1, zLongIndx_r);
+    SET_VECTOR_ELT(resultName_r, 1, mkChar("z.long.indx"));
+
+    SET_VECTOR_ELT(result_r, 2, namesLong_r);
+    SET_VECTOR_ELT(resultName_r, 2, mkChar("names.long"));
+
+    SET_VECTOR_ELT(result_r, 3, desLong_r[0]);
+    SET_VECTOR_ELT(resultName_r, 3, mkChar("X.p"));
+
+    SET_VECTOR_ELT(result_r, 4, desLong_r[1]);
+    SET_VECTOR_ELT(resultName_r, 4, mkChar("X.p.re"));
+
+    SET_VECTOR_ELT(result_r, 5, levels_r);
+    SET_VECTOR_ELT(resultName_r, 5, mkChar("X.p.re.levels"));
+
+    namesgets(result_r, resultName_r);
+
+    UNPROTECT(nProtect);
+
+    return(result_r);
+  }
+}
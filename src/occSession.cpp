@@ -0,0 +1,92 @@
+#include <R.h>
+#include <Rinternals.h>
+
+// Resident sampler sessions. A session holds the sampler inputs prepared by
+// the R front end (ordered data, design matrices, neighbor indices, priors)
+// together with the chain states at the end of the last run, so further
+// iterations can be sent straight to the sampler without rebuilding them.
+// Both lists are kept in the protected field of an external pointer and are
+// returned by reference. The pointer does not survive save/load, in which
+// case the session is reported as no longer valid.
+
+typedef struct {
+  int nRuns;
+} occSession;
+
+static void occSessionFinalize(SEXP session_r){
+  occSession *session = (occSession *) R_ExternalPtrAddr(session_r);
+  if (session != NULL) {
+    R_Free(session);
+    R_ClearExternalPtr(session_r);
+  }
+}
+
+static occSession *getOccSession(SEXP session_r){
+  if (TYPEOF(session_r) != EXTPTRSXP || R_ExternalPtrTag(session_r) != install("occSession")) {
+    error("c++ error: object is not a sampler session\n");
+  }
+  occSession *session = (occSession *) R_ExternalPtrAddr(session_r);
+  if (session == NULL) {
+    error("c++ error: the sampler session is no longer valid (was the model saved and reloaded?); refit the model with keep.session = TRUE\n");
+  }
+  return(session);
+}
+
+extern "C" {
+
+  SEXP occSessionNew(SEXP inputs_r, SEXP states_r){
+
+    SEXP prot_r, session_r;
+    int nProtect = 0;
+
+    occSession *session = R_Calloc(1, occSession);
+    session->nRuns = 1;
+
+    PROTECT(prot_r = allocVector(VECSXP, 2)); nProtect++;
+    SET_VECTOR_ELT(prot_r, 0, inputs_r);
+    SET_VECTOR_ELT(prot_r, 1, states_r);
+
+    PROTECT(session_r = R_MakeExternalPtr(session, install("occSession"), prot_r)); nProtect++;
+    R_RegisterCFinalizerEx(session_r, occSessionFinalize, TRUE);
+
+    UNPROTECT(nProtect);
+
+    return(session_r);
+  }
+
+  SEXP occSessionGet(SEXP session_r){
+
+    SEXP result_r, resultName_r;
+    int nProtect = 0;
+
+    occSession *session = getOccSession(session_r);
+    SEXP prot_r = R_ExternalPtrProtected(session_r);
+
+    PROTECT(result_r = allocVector(VECSXP, 3)); nProtect++;
+    PROTECT(resultName_r = allocVector(VECSXP, 3)); nProtect++;
+
+    SET_VECTOR_ELT(result_r, 0, VECTOR_ELT(prot_r, 0));
+    SET_VECTOR_ELT(result_r, 1, VECTOR_ELT(prot_r, 1));
+    SET_VECTOR_ELT(result_r, 2, ScalarInteger(session->nRuns));
+
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("inputs"));
+    SET_VECTOR_ELT(resultName_r, 1, mkChar("states"));
+    SET_VECTOR_ELT(resultName_r, 2, mkChar("n.runs"));
+
+    namesgets(result_r, resultName_r);
+
+    UNPROTECT(nProtect);
+
+    return(result_r);
+  }
+
+  SEXP occSessionSetStates(SEXP session_r, SEXP states_r){
+
+    occSession *session = getOccSession(session_r);
+
+    SET_VECTOR_ELT(R_ExternalPtrProtected(session_r), 1, states_r);
+    session->nRuns++;
+
+    return(R_NilValue);
+  }
+}
@@ -0,0 +1,137 @@
+#include <string>
+#include <algorithm>
+#include <limits>
+#include "util.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <R.h>
+#include <Rmath.h>
+#include <Rinternals.h>
+#include <R_ext/Utils.h>
+
+extern "C" {
+
+  // Posterior mean, standard deviation, and quantiles (R's default type 7)
+  // of each column of the n x p samples matrix, in parallel over columns.
+  // Quantiles are found by selection (nth_element) on a per-thread copy of
+  // the column, working up through the sorted probabilities so each
+  // selection only searches the part of the column above the last one.
+  // Columns with missing values get NA throughout. probs must be sorted.
+  SEXP postSummary(SEXP samples_r, SEXP probs_r, SEXP nThreads_r){
+
+    int i, j, k, threadID = 0, nProtect = 0;
+
+    int n = INTEGER(getAttrib(samples_r, R_DimSymbol))[0];
+    int p = INTEGER(getAttrib(samples_r, R_DimSymbol))[1];
+    double *samples = REAL(samples_r);
+    int nProbs = length(probs_r);
+    double *probs = REAL(probs_r);
+    int nThreads = INTEGER(nThreads_r)[0];
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    if (n < 1) {
+      error("c++ error: no posterior samples to summarize\n");
+    }
+
+    SEXP summary_r;
+    PROTECT(summary_r = allocMatrix(REALSXP, p, 2 + nProbs)); nProtect++;
+    double *summary = REAL(summary_r);
+
+    double *x = (double *) R_alloc(static_cast<R_xlen_t>(n) * nThreads, sizeof(double));
+
+#ifdef _OPENMP
+#pragma omp parallel for private(i, k, threadID)
+#endif
+    for (j = 0; j < p; j++) {
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      double *xj = &x[static_cast<R_xlen_t>(threadID) * n];
+      double *col = &samples[static_cast<R_xlen_t>(j) * n];
+      double mean = 0.0, ss = 0.0, d, h, lo, hi;
+      int hasNA = 0, lower, start = 0;
+
+      // Moments (Welford)
+      for (i = 0; i < n; i++) {
+	if (ISNAN(col[i])) {
+	  hasNA = 1;
+	  break;
+	}
+	d = col[i] - mean;
+	mean += d / (i + 1);
+	ss += d * (col[i] - mean);
+	xj[i] = col[i];
+      }
+      if (hasNA) {
+	for (k = 0; k < 2 + nProbs; k++) {
+	  summary[static_cast<R_xlen_t>(k) * p + j] = NA_REAL;
+	}
+	continue;
+      }
+      summary[j] = mean;
+      summary[p + j] = n > 1 ? sqrt(ss / (n - 1)) : NA_REAL;
+
+      // Quantiles
+      for (k = 0; k < nProbs; k++) {
+	h = (n - 1) * probs[k];
+	lower = static_cast<int>(floor(h + 4 * std::numeric_limits<double>::epsilon()));
+	if (lower < start) {
+	  lower = start;
+	}
+	std::nth_element(xj + start, xj + lower, xj + n);
+	lo = xj[lower];
+	if (lower + 1 < n && h > lower) {
+	  hi = *std::min_element(xj + lower + 1, xj + n);
+	  lo = (1.0 - (h - lower)) * lo + (h - lower) * hi;
+	}
+	summary[static_cast<R_xlen_t>(2 + k) * p + j] = lo;
+	start = lower;
+      }
+    }
+
+    UNPROTECT(nProtect);
+
+    return(summary_r);
+  }
+
+  // Bernoulli draws with the given probabilities, e.g., replicate
+  // detection-nondetection data for fitted(). The result has the same
+  // attributes (dimensions) as prob_r; missing probabilities give NA. Uses
+  // R's generator so results follow set.seed().
+  SEXP rbinomSamples(SEXP prob_r){
+
+    R_xlen_t i;
+    R_xlen_t n = XLENGTH(prob_r);
+    double *prob = REAL(prob_r);
+
+    SEXP y_r;
+    PROTECT(y_r = allocVector(REALSXP, n));
+    double *y = REAL(y_r);
+    DUPLICATE_ATTRIB(y_r, prob_r);
+
+    GetRNGstate();
+    for (i = 0; i < n; i++) {
+      if (ISNAN(prob[i])) {
+	y[i] = NA_REAL;
+      } else {
+	y[i] = unif_rand() < prob[i] ? 1.0 : 0.0;
+      }
+    }
+    PutRNGstate();
+
+    UNPROTECT(1);
+
+    return(y_r);
+  }
+}
@@ -0,0 +1,221 @@
+#include <string>
+#include <limits>
+#include "util.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <R.h>
+#include <Rmath.h>
+#include <Rinternals.h>
+#include <R_ext/Utils.h>
+
+// log(sum(exp(x))) over n values
+static double logSumExp(double *x, int n){
+  int i;
+  double xMax = -std::numeric_limits<double>::infinity();
+  double s = 0.0;
+  for (i = 0; i < n; i++) {
+    if (x[i] > xMax) {
+      xMax = x[i];
+    }
+  }
+  if (!R_FINITE(xMax)) {
+    return(xMax);
+  }
+  for (i = 0; i < n; i++) {
+    s += exp(x[i] - xMax);
+  }
+  return(xMax + log(s));
+}
+
+// Generalized Pareto fit to the sorted exceedances x (Zhang and Stephens 2009)
+// with the weakly informative prior on k used by Vehtari et al. (2024).
+// theta and lTheta are work space of length nGrid.
+static void gpdFit(double *x, int n, double *theta, double *lTheta, int nGrid, double *k, double *sigma){
+  int i, j;
+  int prior = 3;
+  double xStar = x[static_cast<int>(floor(n / 4.0 + 0.5)) - 1];
+  double a, kb, lMax, wSum, thetaHat, kHat;
+
+  // Profile log-likelihood of each grid value
+  for (j = 0; j < nGrid; j++) {
+    theta[j] = 1.0 / x[n - 1] + (1.0 - sqrt(nGrid / (j + 0.5))) / prior / xStar;
+    a = -theta[j];
+    kb = 0.0;
+    for (i = 0; i < n; i++) {
+      kb += log1p(a * x[i]);
+    }
+    kb /= n;
+    lTheta[j] = n * (log(a / kb) - kb - 1.0);
+  }
+  lMax = lTheta[0];
+  for (j = 1; j < nGrid; j++) {
+    if (lTheta[j] > lMax) {
+      lMax = lTheta[j];
+    }
+  }
+  wSum = 0.0;
+  thetaHat = 0.0;
+  for (j = 0; j < nGrid; j++) {
+    lTheta[j] = exp(lTheta[j] - lMax);
+    wSum += lTheta[j];
+    thetaHat += theta[j] * lTheta[j];
+  }
+  thetaHat /= wSum;
+  kHat = 0.0;
+  for (i = 0; i < n; i++) {
+    kHat += log1p(-thetaHat * x[i]);
+  }
+  kHat /= n;
+  *sigma = -kHat / thetaHat;
+  // Shrink towards 0.5
+  *k = (kHat * n + 0.5 * 10) / (n + 10);
+}
+
+// Pareto smoothed importance weights for one observation. lw holds the log
+// importance ratios on input and the normalized smoothed log weights on output.
+// Returns the Pareto k diagnostic.
+static double psisSmooth(double *lw, int nSamples, double *lwSort, int *ord, double *x, double *theta, double *lTheta){
+  int i;
+  int tailLen = static_cast<int>(ceil(std::min(0.2 * nSamples, 3.0 * sqrt(static_cast<double>(nSamples)))));
+  int nGrid = 30 + static_cast<int>(floor(sqrt(static_cast<double>(tailLen))));
+  double lwMax = lw[0];
+  double k = R_PosInf, sigma, cutoff, expCutoff, p, lse;
+
+  for (i = 1; i < nSamples; i++) {
+    if (lw[i] > lwMax) {
+      lwMax = lw[i];
+    }
+  }
+  for (i = 0; i < nSamples; i++) {
+    lw[i] -= lwMax;
+    lwSort[i] = lw[i];
+    ord[i] = i;
+  }
+
+  if (tailLen >= 5 && tailLen < nSamples) {
+    rsort_with_index(lwSort, ord, nSamples);
+    if (fabs(lwSort[nSamples - 1] - lwSort[nSamples - tailLen]) >= std::numeric_limits<double>::epsilon() / 100) {
+      cutoff = lwSort[nSamples - tailLen - 1];
+      expCutoff = exp(cutoff);
+      for (i = 0; i < tailLen; i++) {
+        x[i] = exp(lwSort[nSamples - tailLen + i]) - expCutoff;
+      }
+      gpdFit(x, tailLen, theta, lTheta, nGrid, &k, &sigma);
+      if (R_FINITE(k) && sigma > 0) {
+        for (i = 0; i < tailLen; i++) {
+          p = (i + 0.5) / tailLen;
+          lw[ord[nSamples - tailLen + i]] = log(sigma * expm1(-k * log1p(-p)) / k + expCutoff);
+        }
+      }
+    }
+  }
+
+  // Truncate at the largest raw weight and normalize
+  for (i = 0; i < nSamples; i++) {
+    if (lw[i] > 0.0) {
+      lw[i] = 0.0;
+    }
+  }
+  lse = logSumExp(lw, nSamples);
+  for (i = 0; i < nSamples; i++) {
+    lw[i] -= lse;
+  }
+
+  return(k);
+}
+
+extern "C" {
+
+  SEXP psisLoo(SEXP logLik_r, SEXP nSamples_r, SEXP nObs_r, SEXP nThreads_r){
+
+    int i, nProtect = 0, threadID = 0;
+    R_xlen_t s, r;
+
+    double *logLik = REAL(logLik_r);
+    int nSamples = INTEGER(nSamples_r)[0];
+    int nObs = INTEGER(nObs_r)[0];
+    int nThreads = INTEGER(nThreads_r)[0];
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    if (nSamples < 2) {
+      error("c++ error: PSIS-LOO requires at least two posterior samples\n");
+    }
+
+    SEXP elpd_r, lpd_r, k_r;
+    PROTECT(elpd_r = allocVector(REALSXP, nObs)); nProtect++;
+    PROTECT(lpd_r = allocVector(REALSXP, nObs)); nProtect++;
+    PROTECT(k_r = allocVector(REALSXP, nObs)); nProtect++;
+    double *elpd = REAL(elpd_r);
+    double *lpd = REAL(lpd_r);
+    double *kHat = REAL(k_r);
+
+    // Per-thread work space. The grid is at most 30 + sqrt(tail length).
+    int nGridMax = 30 + static_cast<int>(floor(sqrt(static_cast<double>(nSamples)))) + 1;
+    R_xlen_t nSamplesThread = static_cast<R_xlen_t>(nSamples) * nThreads;
+    double *lw = (double *) R_alloc(nSamplesThread, sizeof(double));
+    double *lwSort = (double *) R_alloc(nSamplesThread, sizeof(double));
+    double *x = (double *) R_alloc(nSamplesThread, sizeof(double));
+    int *ord = (int *) R_alloc(nSamplesThread, sizeof(int));
+    double *theta = (double *) R_alloc(nGridMax * nThreads, sizeof(double));
+    double *lTheta = (double *) R_alloc(nGridMax * nThreads, sizeof(double));
+    double *ll = (double *) R_alloc(nSamplesThread, sizeof(double));
+
+#ifdef _OPENMP
+#pragma omp parallel for private(threadID, s, r)
+#endif
+    for (i = 0; i < nObs; i++) {
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      double *lwI = &lw[static_cast<R_xlen_t>(threadID) * nSamples];
+      double *llI = &ll[static_cast<R_xlen_t>(threadID) * nSamples];
+      r = static_cast<R_xlen_t>(i) * nSamples;
+      for (s = 0; s < nSamples; s++) {
+        llI[s] = logLik[r + s];
+        lwI[s] = -llI[s];
+      }
+      lpd[i] = logSumExp(llI, nSamples) - log(static_cast<double>(nSamples));
+      kHat[i] = psisSmooth(lwI, nSamples, &lwSort[static_cast<R_xlen_t>(threadID) * nSamples],
+			   &ord[static_cast<R_xlen_t>(threadID) * nSamples],
+			   &x[static_cast<R_xlen_t>(threadID) * nSamples], &theta[threadID * nGridMax], 
+			   &lTheta[threadID * nGridMax]);
+      for (s = 0; s < nSamples; s++) {
+        lwI[s] += llI[s];
+      }
+      elpd[i] = logSumExp(lwI, nSamples);
+    }
+
+    // make return object
+    SEXP result_r, resultName_r;
+    int nResultListObjs = 3;
+
+    PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+    PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+
+    SET_VECTOR_ELT(result_r, 0, elpd_r);
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("elpd.loo"));
+
+    SET_VECTOR_ELT(result_r, 1, lpd_r);
+    SET_VECTOR_ELT(resultName_r, 1, mkChar("lpd"));
+
+    SET_VECTOR_ELT(result_r, 2, k_r);
+    SET_VECTOR_ELT(resultName_r, 2, mkChar("k.hat"));
+
+    namesgets(result_r, resultName_r);
+
+    UNPROTECT(nProtect);
+
+    return(result_r);
+  }
+}
@@ -2,6 +2,7 @@
 #include <Rmath.h>
 #include <Rinternals.h>
 #include "rpg.h"
+#include "util.h"
 
 // Mathematical constants computed using Wolfram Alpha
 #define MATH_PI        3.141592653589793238462643383279502884197169399375105820974
@@ -15,9 +16,20 @@
 #define MATH_LOG_2_PI  -0.45158270528945486472619522989488214357179467855505631739
 #define MATH_LOG_PI_2  0.451582705289454864726195229894882143571794678555056317392
 
+// Uniform and standard normal draws from R's generator, or from the 
+// per-thread stream in state when it is not NULL. The thread streams 
+// allow PG draws inside OpenMP regions. 
+static inline double pgUnif(unsigned long long *state){
+  return state ? unifThread(state) : runif(0.0,1.0);
+}
+
+static inline double pgNorm(unsigned long long *state){
+  return state ? normThread(state) : rnorm(0.0,1.0);
+}
+
 // Generate exponential distribution random variates
-double exprnd(double mu){
-  return -mu * (double)std::log(1.0 - (double)runif(0.0,1.0));
+double exprnd(double mu, unsigned long long *state){
+  return -mu * (double)std::log(1.0 - (double)pgUnif(state));
 }
 
 // Function a_n(x) defined in equations (12) and (13) of
@@ -40,13 +52,13 @@ double aterm(int n, double x, double t){
 
 
 // Generate inverse gaussian random variates
-double randinvg(double mu){
+double randinvg(double mu, unsigned long long *state){
   // sampling
-  double u = rnorm(0.0,1.0);
+  double u = pgNorm(state);
   double V = u*u;
   double out = mu + 0.5*mu * ( mu*V - (double)std::sqrt(4.0*mu*V + mu*mu * V*V) );
   
-  if(runif(0.0,1.0) > mu /(mu+out)) {    
+  if(pgUnif(state) > mu /(mu+out)) {    
     out = mu*mu / out; 
   }    
   return out;
@@ -55,17 +67,17 @@ double randinvg(double mu){
 // Sample truncated gamma random variates
 // Ref: Chung, Y.: Simulation of truncated gamma variables 
 // Korean Journal of Computational & Applied Mathematics, 1998, 5, 601-610
-double truncgamma(){
+double truncgamma(unsigned long long *state){
   double c = MATH_PI_2;
   double X, gX;
   
   bool done = false;
   while(!done)
   {
-    X = exprnd(1.0) * 2.0 + c;
+    X = exprnd(1.0, state) * 2.0 + c;
     gX = MATH_SQRT_PI_2 / (double)std::sqrt(X);
     
-    if(runif(0.0,1.0) <= gX) {
+    if(pgUnif(state) <= gX) {
       done = true;
     }
   }
@@ -75,7 +87,7 @@ double truncgamma(){
 
 // Sample truncated inverse Gaussian random variates
 // Algorithm 4 in the Windle (2013) PhD thesis, page 129
-double tinvgauss(double z, double t){
+double tinvgauss(double z, double t, unsigned long long *state){
   double X, u;
   double mu = 1.0/z;
   
@@ -84,8 +96,8 @@ double tinvgauss(double z, double t){
     // Sampler based on truncated gamma 
     // Algorithm 3 in the Windle (2013) PhD thesis, page 128
     while(1) {
-	  u = runif(0.0, 1.0);
-      X = 1.0 / truncgamma();
+	  u = pgUnif(state);
+      X = 1.0 / truncgamma(state);
       
 	  if ((double)std::log(u) < (-z*z*0.5*X)) {
         break;
@@ -96,61 +108,76 @@ double tinvgauss(double z, double t){
     // Rejection sampler
     X = t + 1.0;
     while(X >= t) {
-      X = randinvg(mu);
+      X = randinvg(mu, state);
     }
   }    
   return X;
 }
 
-// Sample PG(1,z)
-// Based on Algorithm 6 in PhD thesis of Jesse Bennett Windle, 2013
-// URL: https://repositories.lib.utexas.edu/bitstream/handle/2152/21842/WINDLE-DISSERTATION-2013.pdf?sequence=1
-double samplepg(double z){
-  //  PG(b, z) = 0.25 * J*(b, z/2)
-  z = (double)std::fabs((double)z) * 0.5;
-  
-  // Point on the intersection IL = [0, 4/ log 3] and IR = [(log 3)/pi^2, \infty)
+// Mixture constants of the PG(1,z) sampler. These depend only on z, so 
+// they are computed once per linear predictor and shared by all draws. 
+// z is the half absolute value of the linear predictor.
+static void pgConst(double z, double *K, double *ratio){
   double t = MATH_2_PI;
   
   // Compute p, q and the ratio q / (q + p)
   // (derived from scratch; derivation is not in the original paper)
-  double K = z*z/2.0 + MATH_PI2/8.0;
+  *K = z*z/2.0 + MATH_PI2/8.0;
   double logA = (double)std::log(4.0) - MATH_LOG_PI - z;
-  double logK = (double)std::log(K);
-  double Kt = K * t;
+  double logK = (double)std::log(*K);
+  double Kt = *K * t;
   double w = (double)std::sqrt(MATH_PI_2);
 
   double logf1 = logA + pnorm(w*(t*z - 1),0.0,1.0,1,1) + logK + Kt;
   double logf2 = logA + 2*z + pnorm(-w*(t*z+1),0.0,1.0,1,1) + logK + Kt;
   double p_over_q = (double)std::exp(logf1) + (double)std::exp(logf2);
-  double ratio = 1.0 / (1.0 + p_over_q); 
+  *ratio = 1.0 / (1.0 + p_over_q); 
+}
 
-  double u, X;
+// Sample PG(1,z) given the mixture constants from pgConst. 
+// The terms of the alternating series only differ in n, so the 
+// parts that depend on the proposal X are computed once per proposal. 
+static double samplepgConst(double z, double K, double ratio, unsigned long long *state){
+  double t = MATH_2_PI;
+  double u, X, cL, cR, Sn, U, a;
+  int i, asgn;
+  bool even;
 
   // Main sampling loop; page 130 of the Windle PhD thesis
   while(1) 
   {
     // Step 1: Sample X ? g(x|z)
-    u = runif(0.0,1.0);
+    u = pgUnif(state);
     if(u < ratio) {
       // truncated exponential
-      X = t + exprnd(1.0)/K;
+      X = t + exprnd(1.0, state)/K;
     }
     else {
       // truncated Inverse Gaussian
-      X = tinvgauss(z, t);
+      X = tinvgauss(z, t, state);
+    }
+
+    // a_n(X) = exp(log(pi) + log(n + 0.5) + c(X, n)), see aterm
+    if(X <= t) {
+      cL = MATH_LOG_PI + 1.5*(MATH_LOG_2_PI - (double)std::log(X));
+      cR = -2.0/X;
+    }
+    else {
+      cL = MATH_LOG_PI;
+      cR = -X * MATH_PI2_2;
     }
 
     // Step 2: Iteratively calculate Sn(X|z), starting at S1(X|z), until U ? Sn(X|z) for an odd n or U > Sn(X|z) for an even n
-    int i = 1;
-    double Sn = aterm(0, X, t);
-    double U = runif(0.0,1.0) * Sn;
-    int asgn = -1;
-    bool even = false;
+    i = 1;
+    Sn = (double)exp(cL + (double)std::log(0.5) + cR*0.25);
+    U = pgUnif(state) * Sn;
+    asgn = -1;
+    even = false;
 
     while(1) 
     {
-      Sn = Sn + asgn * aterm(i, X, t);
+      a = i + 0.5;
+      Sn = Sn + asgn * (double)exp(cL + (double)std::log(a) + cR*a*a);
       
       // Accept if n is odd
       if(!even && (U <= Sn)) {
@@ -171,15 +198,54 @@ double samplepg(double z){
   return X;
 }
 
+// Sample PG(1,z)
+// Based on Algorithm 6 in PhD thesis of Jesse Bennett Windle, 2013
+// URL: https://repositories.lib.utexas.edu/bitstream/handle/2152/21842/WINDLE-DISSERTATION-2013.pdf?sequence=1
+double samplepg(double z){
+  double K, ratio;
+
+  //  PG(b, z) = 0.25 * J*(b, z/2)
+  z = (double)std::fabs((double)z) * 0.5;
+  pgConst(z, &K, &ratio);
+  return samplepgConst(z, K, ratio, NULL);
+}
+
 double rpg(int n, double z){
   
-  double sum = 0;
+  return rpgThread(n, z, NULL);
+}
+
+// PG(n, z) using the per-thread stream in state (R's generator if NULL). 
+double rpgThread(int n, double z, unsigned long long *state){
+  
+  double sum = 0, K, ratio;
   int i;
  
+  z = (double)std::fabs((double)z) * 0.5;
+  pgConst(z, &K, &ratio);
   for(i = 0; i < n; i++){
-    sum += samplepg(z);
+    sum += samplepgConst(z, K, ratio, state);
   }
  
   return(sum);
 }
 
+// Sample out[i] ~ PG(b[i], z[i]) for i = 0, ..., n - 1 with BLAS-style 
+// strides. incB = 0 uses the same b for all draws. z and out may be the 
+// same array, in which case the linear predictors are overwritten. 
+void rpgBatch(int n, const double *b, int incB, const double *z, int incZ, double *out, int incOut){
+  
+  double sum, zz, K, ratio;
+  int i, k, nb;
+
+  for(i = 0; i < n; i++){
+    nb = static_cast<int>(b[i*incB]);
+    zz = (double)std::fabs((double)z[i*incZ]) * 0.5;
+    pgConst(zz, &K, &ratio);
+    sum = 0;
+    for(k = 0; k < nb; k++){
+      sum += samplepgConst(zz, K, ratio, NULL);
+    }
+    out[i*incOut] = sum;
+  }
+}
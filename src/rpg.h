@@ -1,7 +1,9 @@
-double exprnd(double mu);
+double exprnd(double mu, unsigned long long *state);
 double aterm(int n, double x, double t);
-double randinvg(double mu);
-double truncgamma();
-double tinvgauss(double z, double t);
+double randinvg(double mu, unsigned long long *state);
+double truncgamma(unsigned long long *state);
+double tinvgauss(double z, double t, unsigned long long *state);
 double samplepg(double z);
 double rpg(int n, double z);
+double rpgThread(int n, double z, unsigned long long *state);
+void rpgBatch(int n, const double *b, int incB, const double *z, int incZ, double *out, int incOut);
@@ -124,12 +124,13 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *nOccRELong = INTEGER(nOccRELong_r); 
     int *betaStarIndx = INTEGER(betaStarIndx_r); 
     int *betaLevelIndx = INTEGER(betaLevelIndx_r);
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -141,7 +142,7 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0; 
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
     int *monitors = INTEGER(monitors_r);
     // Indices for monitoring
     int betaCommMonitor = 0;
@@ -203,14 +204,13 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int nOccREN = nOccRE * N; 
-    int Jq = J * q;
+    int Jq = intProd(J, q);
     int qq = q * q;
-    int JN = J * N;
+    int JN = intProd(J, N);
     int Nq = N * q;
-    int JpOcc = J * pOcc; 
-    int JJ = J * J;
-    int jj, kk;
-    int JpOccRE = J * pOccRE; 
+    int JpOcc = intProd(J, pOcc); 
+    int jj;
+    int JpOccRE = intProd(J, pOccRE); 
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
@@ -378,7 +378,7 @@ extern "C" {
     // still maintaining the same approach to leverage the same correlation
     // functions underneath. 
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -392,10 +392,39 @@ extern "C" {
       theta[phiIndx * q + ll] = phi[ll];
       // sigmaSq by default is 1 for spatial factor models. 
       theta[sigmaSqIndx * q + ll] = 1.0;
-      if (corName == "matern") {
+      if (isMatern) {
         theta[nuIndx * q + ll] = nu[ll]; 
       } 
     } // ll
+    // Adaptive block Metropolis for phi (and nu if matern), proposed jointly on 
+    // the logit scale, one block per factor. 
+    int amD = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    amIndx[amD] = phiIndx; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amD++; 
+    }
+    int amDD = amD * amD; 
+    int *amN = (int *) R_alloc(q, sizeof(int)); 
+    double *amA = (double *) R_alloc(amD * q, sizeof(double)); 
+    double *amB = (double *) R_alloc(amD * q, sizeof(double)); 
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD * q, sizeof(double)); zeros(amMean, amD * q); 
+    double *amM2 = (double *) R_alloc(amDD * q, sizeof(double)); zeros(amM2, amDD * q); 
+    double *amChol = (double *) R_alloc(amDD * q, sizeof(double)); 
+    for (ll = 0; ll < q; ll++) {
+      amN[ll] = 0; 
+      amA[ll * amD] = phiA[ll]; amB[ll * amD] = phiB[ll]; 
+      if (isMatern) {
+        amA[ll * amD + 1] = nuA[ll]; amB[ll * amD + 1] = nuB[ll]; 
+      }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k] * q + ll]); 
+      }
+      mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+    }
     SEXP thetaSamples_r; 
     if (monitors[thetaMonitor]) {
       PROTECT(thetaSamples_r = allocMatrix(REALSXP, nThetaqSave, nPost)); nProtect++; 
@@ -413,11 +442,14 @@ extern "C" {
     double *mu = (double *) R_alloc(q, sizeof(double));
     double *var = (double *) R_alloc(qq, sizeof(double));
     double *ff = (double *) R_alloc(q, sizeof(double));
+    // NNGP residuals w_j - B_j w_N(j) of each process, kept current through the w sweep
+    double *wResid = (double *) R_alloc(Jq, sizeof(double));
+    double *wNew = (double *) R_alloc(q, sizeof(double));
     double *gg = (double *) R_alloc(q, sizeof(double));
 
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP. Create a copy of these for each species. Increases storage 
     // space that is needed, but reduces amount of computations. 
@@ -528,9 +560,12 @@ extern "C" {
           /********************************************************************
            *Update Occupancy Auxiliary Variables 
            *******************************************************************/
+          // Linear predictors for all sites, then the PG draws in one batch. 
+          F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, &omegaOcc[i], &N FCONE);
           for (j = 0; j < J; j++) {
-            omegaOcc[j * N + i] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j]);
+            omegaOcc[j * N + i] += wStar[j * N + i] + betaStarSites[i * J + j];
           } // j
+          rpgBatch(J, &one, 0, &omegaOcc[i], N, &omegaOcc[i], N);
           /********************************************************************
            *Update Occupancy Regression Coefficients
            *******************************************************************/
@@ -627,6 +662,9 @@ extern "C" {
           updateBF1JSDM(&B[ll * nIndx], &F[ll*J], &c[ll * m*nThreads], &C[ll * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * q + ll], theta[phiIndx * q + ll], nu[ll], covModel, &bk[ll * sizeBK], nuB[0]);
         }
 
+	for (ll = 0; ll < q; ll++) {
+	  mkNNResid(J, &w[ll], q, &B[ll * nIndx], 1, nnIndx, nnIndxLU, &wResid[ll * J]);
+	} // ll
 	for (ii = 0; ii < J; ii++) {
           // tmp_qq = lambda' S_beta lambda 
 	  for (i = 0; i < N; i++) {
@@ -641,27 +679,16 @@ extern "C" {
             a[ll] = 0; 
 	    v[ll] = 0; 
 
-	    if (uIndxLU[J + ii] > 0){ // is ii a neighbor for anybody
-	      for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
-	        b = 0;
-	        // now the neighbors for the jth location who has ii as a neighbor
-	        jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
-	        for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	          kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	          if(kk != ii){ //if the neighbor of jj is not ii
-	    	    b += B[ll*nIndx + nnIndxLU[jj]+k]*w[kk * q + ll]; //covariance between jj and kk and the random effect of kk
-	          }
-	        } // k
-	        aij = w[jj * q + ll] - b;
-	        a[ll] += B[ll*nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]]*aij/F[ll*J + jj];
-	        v[ll] += pow(B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]],2)/F[ll * J + jj];
-	      } // j
-	    }
+	    for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
+	      jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
+	      b = B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]];
+	      // residual of jj given its neighbors other than ii
+	      aij = wResid[ll * J + jj] + b*w[ii * q + ll];
+	      a[ll] += b*aij/F[ll * J + jj];
+	      v[ll] += b*b/F[ll * J + jj];
+	    } // j
 	    
-	    e = 0;
-	    for(j = 0; j < nnIndxLU[J+ii]; j++){
-	      e += B[ll * nIndx + nnIndxLU[ii]+j]*w[nnIndx[nnIndxLU[ii]+j] * q + ll];
-	    }
+	    e = w[ii * q + ll] - wResid[ll * J + ii];
 
 	    ff[ll] = 1.0 / F[ll * J + ii];
 	    gg[ll] = e / F[ll * J + ii];
@@ -693,7 +720,11 @@ extern "C" {
 	  F77_NAME(dpotrf)(lower, &q, var, &q, &info FCONE); 
           if(info != 0){error("c++ error: dpotrf var 2 failed\n");}
 
-	  mvrnorm(&w[ii * q], tmp_N, var, q);
+	  mvrnorm(wNew, tmp_N, var, q);
+	  for (ll = 0; ll < q; ll++) {
+	    updateNNResid(ii, wNew[ll] - w[ii * q + ll], J, &B[ll * nIndx], 1, nnIndxLU, uIndx, uIndxLU, uiIndx, &wResid[ll * J]);
+	    w[ii * q + ll] = wNew[ll];
+	  } // ll
 
         } // ii
         /********************************************************************
@@ -786,7 +817,7 @@ extern "C" {
          *******************************************************************/
 	for (ll = 0; ll < q; ll++) {
           // Current
-          if (corName == "matern"){ 
+          if (isMatern){ 
 	    nu[ll] = theta[nuIndx * q + ll];
        	  }
           updateBF1JSDM(&B[ll * nIndx], &F[ll*J], &c[ll * m*nThreads], &C[ll * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * q + ll], theta[phiIndx * q + ll], nu[ll], covModel, &bk[ll * sizeBK], nuB[ll]);
@@ -812,14 +843,18 @@ extern "C" {
       
           logPostCurr = -0.5 * logDet - 0.5 * aa;
           logPostCurr += log(theta[phiIndx * q + ll] - phiA[ll]) + log(phiB[ll] - theta[phiIndx * q + ll]); 
-          if(corName == "matern"){
+          if(isMatern){
        	    logPostCurr += log(theta[nuIndx * q + ll] - nuA[ll]) + log(nuB[ll] - theta[nuIndx * q + ll]); 
           }
           
           // Candidate
-          phiCand = logitInv(rnorm(logit(theta[phiIndx * q + ll], phiA[ll], phiB[ll]), exp(tuning[phiIndx * q + ll])), phiA[ll], phiB[ll]);
-          if (corName == "matern"){
-      	    nuCand = logitInv(rnorm(logit(theta[nuIndx * q + ll], nuA[ll], nuB[ll]), exp(tuning[nuIndx * q + ll])), nuA[ll], nuB[ll]);
+          for (k = 0; k < amD; k++) {
+            amX[k] = logit(theta[amIndx[k] * q + ll], amA[ll * amD + k], amB[ll * amD + k]); 
+          }
+          mvrnorm(amXCand, amX, &amChol[ll * amDD], amD); 
+          phiCand = logitInv(amXCand[0], phiA[ll], phiB[ll]);
+          if (isMatern){
+            nuCand = logitInv(amXCand[1], nuA[ll], nuB[ll]);
           }
       
           updateBF1JSDM(BCand, FCand, &c[ll * m*nThreads], &C[ll * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * q + ll], phiCand, nuCand, covModel, &bk[ll * sizeBK], nuB[ll]);
@@ -846,7 +881,7 @@ extern "C" {
           
           logPostCand = -0.5*logDet - 0.5*aa;      
           logPostCand += log(phiCand - phiA[ll]) + log(phiB[ll] - phiCand); 
-          if (corName == "matern"){
+          if (isMatern){
             logPostCand += log(nuCand - nuA[ll]) + log(nuB[ll] - nuCand); 
           }
 
@@ -857,28 +892,35 @@ extern "C" {
             
 	    theta[phiIndx * q + ll] = phiCand;
             accept[phiIndx * q + ll]++;
-            if (corName == "matern") {
+            if (isMatern) {
               nu[ll] = nuCand; 
 	      theta[nuIndx * q + ll] = nu[ll]; 
               accept[nuIndx * q + ll]++; 
             }
+            F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
           }
+          updateAM(amX, &amMean[ll * amD], &amM2[ll * amDD], amN[ll], amD); 
+          amN[ll]++; 
 	} // ll
 
         /********************************************************************
          *Get fitted values and occurrence probability
          *******************************************************************/
-        for (i = 0; i < N; i++) {
-          for (j = 0; j < J; j++) {
-            psi[j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j], zero, one); 
-            z[j * N + i] = rbinom(one, psi[j * N + i]);           
-	    if (y[j * N + i] == 1) {
-              yWAIC[j * N + i] = psi[j * N + i];
-	    } else {
-              yWAIC[j * N + i] = 1.0 - psi[j * N + i];
-	    }
-          } // j
-        } // i
+        // Fitted values and the WAIC likelihood are only needed on iterations
+        // that are saved.
+        if ((g >= nBurn) && (thinIndx + 1 == nThin)) {
+          for (i = 0; i < N; i++) {
+            for (j = 0; j < J; j++) {
+              psi[j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + wStar[j * N + i] + betaStarSites[i * J + j], zero, one); 
+              z[j * N + i] = rbinom(one, psi[j * N + i]);           
+	      if (y[j * N + i] == 1) {
+                yWAIC[j * N + i] = psi[j * N + i];
+	      } else {
+                yWAIC[j * N + i] = 1.0 - psi[j * N + i];
+	      }
+            } // j
+          } // i
+        }
 
         /********************************************************************
          *Save samples
@@ -946,6 +988,12 @@ extern "C" {
         } // k
       } // i
 
+      for (ll = 0; ll < q; ll++) {
+        for (k = 0; k < amD; k++) {
+          amSD[k] = exp(tuning[amIndx[k] * q + ll]); 
+        }
+        mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -955,7 +1003,7 @@ extern "C" {
           Rprintf("\tLatent Factor\tParameter\tAcceptance\tTuning\n");	  
           for (ll = 0; ll < q; ll++) {
             Rprintf("\t%i\t\tphi\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*accept2[phiIndx * q + ll], exp(tuning[phiIndx * q + ll]));
-	    if (corName == "matern") {
+	    if (isMatern) {
             Rprintf("\t%i\t\tnu\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*accept2[nuIndx * q + ll], exp(tuning[nuIndx * q + ll]));
 	    }
           } // ll
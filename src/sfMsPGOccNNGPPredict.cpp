@@ -24,9 +24,10 @@ extern "C" {
 			    SEXP thetaSamples_r, SEXP lambdaSamples_r, 
 			    SEXP wSamples_r, SEXP betaStarSiteSamples_r, 
 			    SEXP nSamples_r, SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
-			    SEXP nReport_r){
+			    SEXP nReport_r, SEXP speciesLevel_r){
 
-    int i, j, k, l, s, info, nProtect=0, ll;
+    int i, j, k, l, info, nProtect=0, ll;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     char const *ntran = "N";
@@ -39,15 +40,15 @@ extern "C" {
     int q = INTEGER(q_r)[0]; 
     int pOcc = INTEGER(pOcc_r)[0];
     int pOccN = pOcc * N;
-    int JN = J * N; 
-    int Jq = J * q;
+    int JN = intProd(J, N); 
+    int Jq = intProd(J, q);
     int Nq = N * q;
 
     double *X0 = REAL(X0_r);
     double *coords0 = REAL(coords0_r);
     int JStr = INTEGER(JStr_r)[0];
-    int JStrN = JStr * N;
-    int JStrq = JStr * q;
+    int JStrN = intProd(JStr, N);
+    int JStrq = intProd(JStr, q);
     int m = INTEGER(m_r)[0]; 
     int mm = m * m; 
 
@@ -61,9 +62,13 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
+    // If 0, only the q factor fields are predicted and the species-level 
+    // occurrence probabilities are left to be composed from them later.
+    int speciesLevel = INTEGER(speciesLevel_r)[0];
     
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -96,7 +101,7 @@ extern "C" {
     int nTheta, phiIndx, nuIndx;
 
     // NOTE: this differs from other non-factor modeling functions
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 1; //phi
       phiIndx = 0;
     } else{
@@ -114,7 +119,7 @@ extern "C" {
       nb[ll] = 0; 
     }
     
-    if(corName == "matern"){
+    if(isMatern){
       for (ll = 0; ll < q; ll++) {
         for(s = 0; s < nSamples; s++){
           if(theta[s*nThetaq + nuIndx * q + ll] > nuMax[ll]){
@@ -139,14 +144,18 @@ extern "C" {
     double phi = 0, nu = 0, sigmaSq = 1.0, d;
     int threadID = 0, status = 0;
 
-    SEXP z0_r, w0_r, psi0_r;
-    PROTECT(z0_r = allocMatrix(REALSXP, JStrN, nSamples)); nProtect++; 
-    PROTECT(psi0_r = allocMatrix(REALSXP, JStrN, nSamples)); nProtect++; 
+    SEXP z0_r = R_NilValue, w0_r, psi0_r = R_NilValue;
+    double *z0 = NULL, *psi0 = NULL;
     PROTECT(w0_r = allocMatrix(REALSXP, JStrq, nSamples)); nProtect++;
-    double *z0 = REAL(z0_r);
-    double *psi0 = REAL(psi0_r); 
     double *w0 = REAL(w0_r);
-    double *w0Star = (double *) R_alloc(nSamples * JStrN, sizeof(double));
+    if (speciesLevel) {
+      PROTECT(z0_r = allocMatrix(REALSXP, JStrN, nSamples)); nProtect++; 
+      PROTECT(psi0_r = allocMatrix(REALSXP, JStrN, nSamples)); nProtect++; 
+      z0 = REAL(z0_r);
+      psi0 = REAL(psi0_r); 
+    }
+    // Species-level spatial effects lambda w of one location and sample
+    double *w0Star = (double *) R_alloc(N, sizeof(double));
     if (verbose) {
       Rprintf("-------------------------------------------------\n");
       Rprintf("\t\tPredicting\n");
@@ -156,14 +165,16 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(JStrq*nSamples, sizeof(double));
+    R_xlen_t vIndx = -1, nWV;
+    nWV = static_cast<R_xlen_t>(JStrq)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < JStrq*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
+    vIndx = -1;
     
     for(j = 0; j < JStr; j++){
       for (ll = 0; ll < q; ll++) {
@@ -175,7 +186,7 @@ extern "C" {
 	  threadID = omp_get_thread_num();
 #endif 	
 	  phi = theta[s * nThetaq + phiIndx * q + ll];
-	  if(corName == "matern"){
+	  if(isMatern){
 	    nu = theta[s * nThetaq + nuIndx * q + ll];
 	  }
 	  sigmaSq = 1.0;
@@ -233,37 +244,41 @@ extern "C" {
 
     // Generate latent occurrence state after the fact.
     // Temporary fix. Will embed this in the above loop at some point.
-    if (verbose) {
-      Rprintf("Generating latent occupancy state\n");
+    if (speciesLevel) {
+      if (verbose) {
+        Rprintf("Generating latent occupancy state\n");
+      }
+      for (j = 0; j < JStr; j++) {
+        for (s = 0; s < nSamples; s++) {
+            F77_NAME(dgemv)(ntran, &N, &q, &one, &lambda[s * Nq], &N, &w0[s * JStrq + j*q], &inc, &zero, w0Star, &inc FCONE);
+	    for (i = 0; i < N; i++) {
+	      psi0[s * JStrN + j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X0[j], &JStr, &beta[s*pOccN + i], &N) + w0Star[i] + betaStarSite[s*JStrN + j * N + i], zero, one);
+	      z0[s * JStrN + j * N + i] = rbinom(one, psi0[s * JStrN + j * N + i]);
+	    } // i
+        } // s
+        R_CheckUserInterrupt();
+      } // j
     }
-    for (j = 0; j < JStr; j++) {
-      for (s = 0; s < nSamples; s++) {
-          F77_NAME(dgemv)(ntran, &N, &q, &one, &lambda[s * Nq], &N, &w0[s * JStrq + j*q], &inc, &zero, &w0Star[s * JStrN + j * N], &inc FCONE);
-	  for (i = 0; i < N; i++) {
-	    psi0[s * JStrN + j * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X0[j], &JStr, &beta[s*pOccN + i], &N) + w0Star[s * JStrN + j * N + i] + betaStarSite[s*JStrN + j * N + i], zero, one);
-	    z0[s * JStrN + j * N + i] = rbinom(one, psi0[s * JStrN + j * N + i]);
-	  } // i
-      } // s
-      R_CheckUserInterrupt();
-    } // j
 
     PutRNGstate();
     
     //make return object
     SEXP result_r, resultName_r;
-    int nResultListObjs = 3;
+    int nResultListObjs = speciesLevel ? 3 : 1;
 
     PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
     PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
 
-    SET_VECTOR_ELT(result_r, 0, z0_r);
-    SET_VECTOR_ELT(resultName_r, 0, mkChar("z.0.samples")); 
-    
-    SET_VECTOR_ELT(result_r, 1, w0_r);
-    SET_VECTOR_ELT(resultName_r, 1, mkChar("w.0.samples"));
+    SET_VECTOR_ELT(result_r, 0, w0_r);
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("w.0.samples"));
+
+    if (speciesLevel) {
+      SET_VECTOR_ELT(result_r, 1, z0_r);
+      SET_VECTOR_ELT(resultName_r, 1, mkChar("z.0.samples")); 
 
-    SET_VECTOR_ELT(result_r, 2, psi0_r);
-    SET_VECTOR_ELT(resultName_r, 2, mkChar("psi.0.samples")); 
+      SET_VECTOR_ELT(result_r, 2, psi0_r);
+      SET_VECTOR_ELT(resultName_r, 2, mkChar("psi.0.samples")); 
+    }
 
     namesgets(result_r, resultName_r);
     
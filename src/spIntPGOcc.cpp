@@ -61,6 +61,7 @@ extern "C" {
     // Covariance model
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     // Priors for regression coefficients
     double *muBeta = (double *) R_alloc(pOcc, sizeof(double));   
     F77_NAME(dcopy)(&pOcc, REAL(muBeta_r), &inc, muBeta, &inc);
@@ -85,7 +86,7 @@ extern "C" {
     int *alphaIndx = INTEGER(alphaIndx_r); 
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nThin = INTEGER(nThin_r)[0];
     int nBurn = INTEGER(nBurn_r)[0]; 
     int nPost = INTEGER(nPost_r)[0]; 
@@ -102,7 +103,7 @@ extern "C" {
     int thinIndx = 0; 
     int fixedSigmaSq = INTEGER(fixedSigmaSq_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -185,9 +186,9 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int JJ = J * J; 
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int JJ = intProd(J, J); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
     double *tmp_pDet = (double *) R_alloc(pDet, sizeof(double));
@@ -260,7 +261,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -282,9 +283,32 @@ extern "C" {
     double phi = REAL(phiStarting_r)[0]; 
     double sigmaSq = theta[sigmaSqIndx]; 
     theta[phiIndx] = phi; 
-    if (corName == "matern") {
+    if (isMatern) {
       theta[nuIndx] = nu; 
     }
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale. 
+    int amD = 0, amN = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    double *amA = (double *) R_alloc(nTheta, sizeof(double)); 
+    double *amB = (double *) R_alloc(nTheta, sizeof(double)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amA[amD] = sigmaSqA; amB[amD] = sigmaSqB; amD++; 
+    }
+    amIndx[amD] = phiIndx; amA[amD] = phiA; amB[amD] = phiB; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amA[amD] = nuA; amB[amD] = nuB; amD++; 
+    }
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD, sizeof(double)); zeros(amMean, amD); 
+    double *amM2 = (double *) R_alloc(amD*amD, sizeof(double)); zeros(amM2, amD*amD); 
+    double *amChol = (double *) R_alloc(amD*amD, sizeof(double)); 
+    for (k = 0; k < amD; k++) {
+      amSD[k] = exp(tuning[amIndx[k]]); 
+    }
+    mkAMChol(amSD, amM2, amN, amD, amChol); 
     double *C = (double *) R_alloc(JJ, sizeof(double));
     double *CCand = (double *) R_alloc(JJ, sizeof(double));
     double *tmp_JD = (double *) R_alloc(J, sizeof(double));
@@ -317,9 +341,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + w[j]);
+          omegaOcc[j] += w[j];
         } // j
+        rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -469,19 +496,26 @@ extern "C" {
         /********************************************************************
          *Update phi (and nu if matern)
          *******************************************************************/
-	if (corName == "matern") {
-          nu = theta[nuIndx]; 
-	  nuCand = logitInv(rnorm(logit(theta[nuIndx], nuA, nuB), exp(tuning[nuIndx])), nuA, nuB); 
-	  theta[nuIndx] = nuCand; 
-        }
+	if (isMatern) {
+	  nu = theta[nuIndx]; 
+	}
 	phi = theta[phiIndx]; 
-	phiCand = logitInv(rnorm(logit(phi, phiA, phiB), exp(tuning[phiIndx])), phiA, phiB); 
-	theta[phiIndx] = phiCand; 
 	if (sigmaSqIG == 0) {
 	  sigmaSq = theta[sigmaSqIndx]; 
-	  sigmaSqCand = logitInv(rnorm(logit(sigmaSq, sigmaSqA, sigmaSqB), 
-				 exp(tuning[sigmaSqIndx])), sigmaSqA, sigmaSqB); 
-	  theta[sigmaSqIndx] = sigmaSqCand; 
+	}
+	for (k = 0; k < amD; k++) {
+	  amX[k] = logit(theta[amIndx[k]], amA[k], amB[k]); 
+	}
+	mvrnorm(amXCand, amX, amChol, amD); 
+	for (k = 0; k < amD; k++) {
+	  theta[amIndx[k]] = logitInv(amXCand[k], amA[k], amB[k]); 
+	}
+	phiCand = theta[phiIndx]; 
+	if (isMatern) {
+	  nuCand = theta[nuIndx]; 
+	}
+	if (sigmaSqIG == 0) {
+	  sigmaSqCand = theta[sigmaSqIndx]; 
 	}
 
 	// Construct covariance matrix (stored in C). 
@@ -506,7 +540,7 @@ extern "C" {
 	// (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	F77_NAME(dsymv)(lower, &J, &one,  CCand, &J, w, &inc, &zero, tmp_JD, &inc FCONE);
 	logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&J, w, &inc, tmp_JD, &inc);
-        if (corName == "matern"){
+        if (isMatern){
           logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
         }
 	if (sigmaSqIG == 0) {
@@ -516,7 +550,7 @@ extern "C" {
         /********************************
          * Current
          *******************************/
-	if (corName == "matern") {
+	if (isMatern) {
 	  theta[nuIndx] = nu; 
 	}
 	theta[phiIndx] = phi; 
@@ -538,7 +572,7 @@ extern "C" {
 	// (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	F77_NAME(dsymv)(lower, &J, &one, C, &J, w, &inc, &zero, tmp_JD, &inc FCONE);
 	logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&J, w, &inc, tmp_JD, &inc);
-        if (corName == "matern"){
+        if (isMatern){
           logPostCurr += log(nu - nuA) + log(nuB - nu); 
         }
 	if (sigmaSqIG == 0) {
@@ -550,7 +584,7 @@ extern "C" {
 	if (runif(0.0, 1.0) <= exp(logMHRatio)) {
           theta[phiIndx] = phiCand;
           accept[phiIndx]++;
-          if (corName == "matern") {
+          if (isMatern) {
             theta[nuIndx] = nuCand; 
             accept[nuIndx]++; 
           }
@@ -559,7 +593,10 @@ extern "C" {
 	    accept[sigmaSqIndx]++;
 	  }
 	  F77_NAME(dcopy)(&JJ, CCand, &inc, C, &inc); 
+          F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
         }
+        updateAM(amX, amMean, amM2, amN, amD); 
+        amN++; 
 
         /********************************************************************
          *Update w (spatial random effects)
@@ -657,6 +694,10 @@ extern "C" {
           }
         accept[j] = 0;
       }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k]]); 
+      }
+      mkAMChol(amSD, amM2, amN, amD, amChol); 
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -665,7 +706,7 @@ extern "C" {
 	  Rprintf("Batch: %i of %i, %3.2f%%\n", s, nBatch, 100.0*s/nBatch);
 	  Rprintf("\tParameter\tAcceptance\tTuning\n");	  
 	  Rprintf("\tphi\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + phiIndx], exp(tuning[phiIndx]));
-	  if (corName == "matern") {
+	  if (isMatern) {
 	    Rprintf("\tnu\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + nuIndx], exp(tuning[nuIndx]));
 	  }
 	  if (sigmaSqIG == 0) {
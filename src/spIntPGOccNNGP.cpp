@@ -76,7 +76,7 @@ extern "C" {
 		      SEXP nBatch_r, SEXP batchLength_r, 
 		      SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, SEXP nReport_r, 
       	              SEXP nBurn_r, SEXP nThin_r, SEXP nPost_r, SEXP currChain_r, SEXP nChain_r, 
-		      SEXP fixedSigmaSq_r, SEXP sigmaSqIG_r){
+		      SEXP fixedSigmaSq_r, SEXP sigmaSqIG_r, SEXP asis_r){
    
     /**********************************************************************
      * Initial constants
@@ -127,6 +127,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int J = INTEGER(J_r)[0];
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int nObs = INTEGER(nObs_r)[0]; 
@@ -136,7 +137,7 @@ extern "C" {
     int *alphaIndx = INTEGER(alphaIndx_r); 
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nThin = INTEGER(nThin_r)[0]; 
     int nBurn = INTEGER(nBurn_r)[0]; 
     int nPost = INTEGER(nPost_r)[0]; 
@@ -153,7 +154,8 @@ extern "C" {
     int thinIndx = 0; 
     int fixedSigmaSq = INTEGER(fixedSigmaSq_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
-    int sPost = 0; 
+    int asis = INTEGER(asis_r)[0];
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -187,6 +189,9 @@ extern "C" {
         Rprintf("Source not compiled with OpenMP support.\n\n");
 #endif
         Rprintf("Adaptive Metropolis with target acceptance rate: %.1f\n", 100*acceptRate);
+        if (asis) {
+          Rprintf("Interweaving (ASIS) updates for the intercept and sigma.sq.\n");
+        }
       }
       Rprintf("----------------------------------------\n");
       Rprintf("\tChain %i\n", currChain);
@@ -234,9 +239,9 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int jj, kk;
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int jj;
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
     double *tmp_pDet = (double *) R_alloc(pDet, sizeof(double));
@@ -308,7 +313,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -326,16 +331,44 @@ extern "C" {
     PROTECT(tuningSamples_r = allocMatrix(REALSXP, nTheta, nBatch)); nProtect++; 
     SEXP thetaSamples_r; 
     PROTECT(thetaSamples_r = allocMatrix(REALSXP, nTheta, nPost)); nProtect++; 
-    double a, v, b, e, mu, var, aij; 
+    double a, v, b, e, mu, var, aij, wNew; 
+    // NNGP residuals w_j - B_j w_N(j), kept current through the w sweep
+    double *wResid = (double *) R_alloc(J, sizeof(double)); 
+    // For interweaving (ASIS) updates
+    double ee, asisSigma, asisSigmaCand, logMHRatio; 
     // Initiate spatial values
     theta[sigmaSqIndx] = REAL(sigmaSqStarting_r)[0]; 
     theta[phiIndx] = REAL(phiStarting_r)[0]; 
-    if (corName == "matern") {
+    if (isMatern) {
       theta[nuIndx] = nu; 
     } 
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale. 
+    int amD = 0, amN = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    double *amA = (double *) R_alloc(nTheta, sizeof(double)); 
+    double *amB = (double *) R_alloc(nTheta, sizeof(double)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amA[amD] = sigmaSqA; amB[amD] = sigmaSqB; amD++; 
+    }
+    amIndx[amD] = phiIndx; amA[amD] = phiA; amB[amD] = phiB; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amA[amD] = nuA; amB[amD] = nuB; amD++; 
+    }
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD, sizeof(double)); zeros(amMean, amD); 
+    double *amM2 = (double *) R_alloc(amD*amD, sizeof(double)); zeros(amM2, amD*amD); 
+    double *amChol = (double *) R_alloc(amD*amD, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (k = 0; k < amD; k++) {
+      amSD[k] = exp(tuning[amIndx[k]]); 
+    }
+    mkAMChol(amSD, amM2, amN, amD, amChol); 
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP
     int mm = m*m;
@@ -349,7 +382,7 @@ extern "C" {
 
     double *bk = (double *) R_alloc(nThreads*(1.0+static_cast<int>(floor(nuB))), sizeof(double));
 
-    if (corName == "matern") {
+    if (isMatern) {
       nu = theta[nuIndx];
     }
     updateBF1Int(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], theta[phiIndx], nu, covModel, bk, nuB);
@@ -361,9 +394,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + w[j]);
+          omegaOcc[j] += w[j];
         } // j
+        rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -488,44 +524,71 @@ extern "C" {
         /********************************************************************
          *Update w (spatial random effects)
          *******************************************************************/
+	mkNNResid(J, w, 1, B, 1, nnIndx, nnIndxLU, wResid);
 	for (i = 0; i < J; i++ ) {
           a = 0;
 	  v = 0;
-	  if (uIndxLU[J + i] > 0){ // is i a neighbor for anybody
-	    for (j = 0; j < uIndxLU[J+i]; j++){ // how many locations have i as a neighbor
-	      b = 0;
-	      // now the neighbors for the jth location who has i as a neighbor
-	      jj = uIndx[uIndxLU[i]+j]; // jj is the index of the jth location who has i as a neighbor
-	      for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	        kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	        if(kk != i){ //if the neighbor of jj is not i
-	  	b += B[nnIndxLU[jj]+k]*w[kk]; //covariance between jj and kk and the random effect of kk
-	        }
-	      }
-	      aij = w[jj] - b;
-	      a += B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]]*aij/F[jj];
-	      v += pow(B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]],2)/F[jj];
-	    }
+	  for (j = 0; j < uIndxLU[J+i]; j++){ // how many locations have i as a neighbor
+	    jj = uIndx[uIndxLU[i]+j]; // jj is the index of the jth location who has i as a neighbor
+	    b = B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]];
+	    // residual of jj given its neighbors other than i
+	    aij = wResid[jj] + b*w[i];
+	    a += b*aij/F[jj];
+	    v += b*b/F[jj];
 	  }
 	  
-	  e = 0;
-	  for(j = 0; j < nnIndxLU[J+i]; j++){
-	    e += B[nnIndxLU[i]+j]*w[nnIndx[nnIndxLU[i]+j]];
-	  }
+	  e = w[i] - wResid[i];
 	  
 	  mu = (kappaOcc[i] / omegaOcc[i] - F77_NAME(ddot)(&pOcc, &X[i], &J, beta, &inc))*omegaOcc[i] + e/F[i] + a;
 	  
 	  var = 1.0/(omegaOcc[i] + 1.0/F[i] + v);
 	  
-	  w[i] = rnorm(mu*var, sqrt(var));
+	  wNew = rnorm(mu*var, sqrt(var));
+	  updateNNResid(i, wNew - w[i], J, B, 1, nnIndxLU, uIndx, uIndxLU, uiIndx, wResid);
+	  w[i] = wNew;
 
         } // i 
 
+        /********************************************************************
+         *Interweave the intercept (ASIS)
+         *******************************************************************/
+	// Redraw the intercept given the centered spatial effects w + beta[0], 
+	// which leaves the linear predictor unchanged. Uses the current B and F. 
+	if (asis) {
+	  a = 0;
+	  v = 0;
+#ifdef _OPENMP
+#pragma omp parallel for private (e, ee, i) reduction(+:a, v)
+#endif
+          for (j = 0; j < J; j++) {
+            e = 0;
+	    ee = 0;
+	    for (i = 0; i < nnIndxLU[J+j]; i++) {
+              e += B[nnIndxLU[j]+i];
+	      ee += B[nnIndxLU[j]+i]*(w[nnIndx[nnIndxLU[j]+i]] + beta[0]);
+	    }
+	    a += (1.0 - e)*(w[j] + beta[0] - ee)/F[j];
+	    v += (1.0 - e)*(1.0 - e)/F[j];
+	  }
+	  // Prior for the intercept conditional on the other coefficients. 
+	  mu = SigmaBetaInv[0] * muBeta[0];
+	  for (k = 1; k < pOcc; k++) {
+            mu -= SigmaBetaInv[k] * (beta[k] - muBeta[k]); 
+	  }
+	  var = 1.0 / (SigmaBetaInv[0] + v);
+	  b = rnorm((mu + a) * var, sqrt(var)); 
+	  for (j = 0; j < J; j++) {
+            w[j] += beta[0] - b; 
+	  }
+	  beta[0] = b; 
+	}
+
         /********************************************************************
          *Update sigmaSq
          *******************************************************************/
 	if (!fixedSigmaSq) {
           if (sigmaSqIG) {
+	    a = 0;
 #ifdef _OPENMP
 #pragma omp parallel for private (e, i, b) reduction(+:a, logDet)
 #endif
@@ -544,13 +607,46 @@ extern "C" {
 
 	    theta[sigmaSqIndx] = rigamma(sigmaSqA + J / 2.0, sigmaSqB + 0.5 * a * theta[sigmaSqIndx]); 
 	  }
+	  /******************************
+	   *Interweave sigmaSq (ASIS)
+	   *****************************/
+	  // Redraw sigma given the standardized spatial effects w / sigma with an 
+	  // independence proposal from the Gaussian PG-augmented likelihood, so 
+	  // only the prior enters the acceptance ratio. 
+	  if (asis) {
+            asisSigma = sqrt(theta[sigmaSqIndx]); 
+	    a = 0;
+	    v = 0;
+	    for (j = 0; j < J; j++) {
+              e = w[j] / asisSigma; 
+	      a += e * (kappaOcc[j] - omegaOcc[j] * F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc)); 
+	      v += omegaOcc[j] * e * e; 
+	    }
+	    asisSigmaCand = rnorm(a / v, sqrt(1.0 / v)); 
+	    if (asisSigmaCand > 0.0) {
+	      if (sigmaSqIG) {
+                logMHRatio = -1.0 * (2.0 * sigmaSqA + 1.0) * log(asisSigmaCand / asisSigma) - 
+			     sigmaSqB / (asisSigmaCand * asisSigmaCand) + sigmaSqB / theta[sigmaSqIndx]; 
+	      } else if (asisSigmaCand * asisSigmaCand > sigmaSqA && asisSigmaCand * asisSigmaCand < sigmaSqB) {
+                logMHRatio = log(asisSigmaCand / asisSigma); 
+	      } else {
+                logMHRatio = R_NegInf; 
+	      }
+	      if (runif(0.0, 1.0) <= exp(logMHRatio)) {
+                for (j = 0; j < J; j++) {
+                  w[j] *= asisSigmaCand / asisSigma; 
+		}
+		theta[sigmaSqIndx] = asisSigmaCand * asisSigmaCand; 
+	      }
+	    }
+	  }
 	}
 
         /********************************************************************
          *Update phi (and nu if matern)
          *******************************************************************/
         // Current
-        if (corName == "matern"){ nu = theta[nuIndx]; }
+        if (isMatern){ nu = theta[nuIndx]; }
         updateBF1Int(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], theta[phiIndx], nu, covModel, bk, nuB);
         
         a = 0;
@@ -575,7 +671,7 @@ extern "C" {
       
         logPostCurrent = -0.5*logDet - 0.5*a;
         logPostCurrent += log(theta[phiIndx] - phiA) + log(phiB - theta[phiIndx]); 
-        if(corName == "matern"){
+        if(isMatern){
         	logPostCurrent += log(theta[nuIndx] - nuA) + log(nuB - theta[nuIndx]); 
         }
 	if (sigmaSqIG == 0) {
@@ -583,14 +679,20 @@ extern "C" {
 	}
         
         // Candidate
-        phiCand = logitInv(rnorm(logit(theta[phiIndx], phiA, phiB), exp(tuning[phiIndx])), phiA, phiB);
-        if (corName == "matern"){
-      	  nuCand = logitInv(rnorm(logit(theta[nuIndx], nuA, nuB), exp(tuning[nuIndx])), nuA, nuB);
+        for (k = 0; k < amD; k++) {
+          amX[k] = logit(theta[amIndx[k]], amA[k], amB[k]); 
+        }
+        mvrnorm(amXCand, amX, amChol, amD); 
+        for (k = 0; k < amD; k++) {
+          thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[k], amB[k]); 
+        }
+        phiCand = thetaCand[phiIndx];
+        if (isMatern){
+          nuCand = thetaCand[nuIndx];
+        }
+        if (sigmaSqIG == 0) {
+          sigmaSqCand = thetaCand[sigmaSqIndx]; 
         }
-	if (sigmaSqIG == 0) {
-	  sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx], sigmaSqA, sigmaSqB), 
-				 exp(tuning[sigmaSqIndx])), sigmaSqA, sigmaSqB); 
-	}
 
 	if (sigmaSqIG) { 
         updateBF1Int(BCand, FCand, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], phiCand, nuCand, covModel, bk, nuB);
@@ -620,7 +722,7 @@ extern "C" {
         
         logPostCand = -0.5*logDet - 0.5*a;      
         logPostCand += log(phiCand - phiA) + log(phiB - phiCand); 
-        if (corName == "matern"){
+        if (isMatern){
           logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
         }
 	if (sigmaSqIG == 0) {
@@ -634,7 +736,7 @@ extern "C" {
           
           theta[phiIndx] = phiCand;
           accept[phiIndx]++;
-          if(corName == "matern"){
+          if(isMatern){
             theta[nuIndx] = nuCand; 
             accept[nuIndx]++; 
           }
@@ -642,7 +744,10 @@ extern "C" {
             theta[sigmaSqIndx] = sigmaSqCand;
 	    accept[sigmaSqIndx]++;
 	  }
+          F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
         }
+        updateAM(amX, amMean, amM2, amN, amD); 
+        amN++; 
 
         /********************************************************************
          *Update Latent Occupancy
@@ -704,6 +809,10 @@ extern "C" {
           }
         accept[j] = 0;
       }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k]]); 
+      }
+      mkAMChol(amSD, amM2, amN, amD, amChol); 
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -712,7 +821,7 @@ extern "C" {
 	  Rprintf("Batch: %i of %i, %3.2f%%\n", s, nBatch, 100.0*s/nBatch);
 	  Rprintf("\tParameter\tAcceptance\tTuning\n");	  
 	  Rprintf("\tphi\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + phiIndx], exp(tuning[phiIndx]));
-	  if (corName == "matern") {
+	  if (isMatern) {
 	    Rprintf("\tnu\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + nuIndx], exp(tuning[nuIndx]));
 	  }
 	  if (sigmaSqIG == 0) {
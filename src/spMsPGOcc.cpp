@@ -98,6 +98,7 @@ extern "C" {
     double *tuning = REAL(tuning_r); 
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *nDetRELong = INTEGER(nDetRELong_r); 
     int *nOccRELong = INTEGER(nOccRELong_r);
     double *K = REAL(K_r); 
@@ -110,7 +111,7 @@ extern "C" {
     int *betaLevelIndx = INTEGER(betaLevelIndx_r);
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -122,9 +123,10 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0; 
+    int saveIter = 0;
     int fixedSigmaSq = INTEGER(sigmaSqInfo_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqInfo_r)[1];
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -171,15 +173,15 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int pDetN = pDet * N; 
-    int nObsN = nObs * N; 
+    int nObsN = intProd(nObs, N); 
     int nDetREN = nDetRE * N; 
     int nOccREN = nOccRE * N; 
-    int JN = J * N;
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int JpOccRE = J * pOccRE; 
-    int nObspDetRE = nObs * pDetRE;
-    int JJ = J * J; 
+    int JN = intProd(J, N);
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDetRE = intProd(nObs, pDetRE);
+    int JJ = intProd(J, J); 
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -391,7 +393,7 @@ extern "C" {
      Set up spatial stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -404,10 +406,45 @@ extern "C" {
     for (i = 0; i < N; i++) {
       theta[sigmaSqIndx * N + i] = sigmaSq[i]; 
       theta[phiIndx * N + i] = phi[i]; 
-      if (corName == "matern") {
+      if (isMatern) {
         theta[nuIndx * N + i] = nu[i]; 
       } 
     } // i
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale, one block per species. 
+    int amD = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amD++; 
+    }
+    amIndx[amD] = phiIndx; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amD++; 
+    }
+    int amDD = amD * amD; 
+    int *amN = (int *) R_alloc(N, sizeof(int)); 
+    double *amA = (double *) R_alloc(amD * N, sizeof(double)); 
+    double *amB = (double *) R_alloc(amD * N, sizeof(double)); 
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD * N, sizeof(double)); zeros(amMean, amD * N); 
+    double *amM2 = (double *) R_alloc(amDD * N, sizeof(double)); zeros(amM2, amDD * N); 
+    double *amChol = (double *) R_alloc(amDD * N, sizeof(double)); 
+    for (i = 0; i < N; i++) {
+      amN[i] = 0; 
+      for (k = 0; k < amD; k++) {
+        if (amIndx[k] == sigmaSqIndx) {
+          amA[i * amD + k] = sigmaSqA[i]; amB[i * amD + k] = sigmaSqB[i]; 
+        } else if (amIndx[k] == phiIndx) {
+          amA[i * amD + k] = phiA[i]; amB[i * amD + k] = phiB[i]; 
+        } else {
+          amA[i * amD + k] = nuA[i]; amB[i * amD + k] = nuB[i]; 
+        }
+        amSD[k] = exp(tuning[amIndx[k] * N + i]); 
+      }
+      mkAMChol(amSD, &amM2[i * amDD], amN[i], amD, &amChol[i * amDD]); 
+    }
     // Initiate currTheta with first species
     for (q = 0; q < nTheta; q++) {
       currTheta[q] = theta[q * N];   
@@ -587,9 +624,12 @@ extern "C" {
           /********************************************************************
            *Update Occupancy Auxiliary Variables 
            *******************************************************************/
+          // Linear predictors for all sites, then the PG draws in one batch. 
+          F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, omegaOcc, &inc FCONE);
           for (j = 0; j < J; j++) {
-            omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + w[j * N + i] + betaStarSites[i * J + j]);
+            omegaOcc[j] += w[j * N + i] + betaStarSites[i * J + j];
           } // j
+          rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
           /********************************************************************
            *Update Detection Auxiliary Variables 
            *******************************************************************/
@@ -761,21 +801,26 @@ extern "C" {
           /********************************************************************
            *Update phi (and nu if matern)
            *******************************************************************/
-	  if (corName == "matern") {
+	  if (isMatern) {
             nu[i] = currTheta[nuIndx]; 
-	    nuCand = logitInv(rnorm(logit(currTheta[nuIndx], nuA[i], nuB[i]), exp(tuning[nuIndx * N + i])), nuA[i], nuB[i]); 
           }
 	  phi[i] = currTheta[phiIndx]; 
-	  phiCand = logitInv(rnorm(logit(currTheta[phiIndx], phiA[i], phiB[i]), exp(tuning[phiIndx * N + i])), phiA[i], phiB[i]);
-	  currTheta[phiIndx] = phiCand; 
-	  if (corName == "matern") {
-	    currTheta[nuIndx] = nuCand; 
-          }
 	  if (sigmaSqIG == 0) {
 	    sigmaSq[i] = currTheta[sigmaSqIndx]; 
-	    sigmaSqCand = logitInv(rnorm(logit(sigmaSq[i], sigmaSqA[i], sigmaSqB[i]), 
-	  			 exp(tuning[sigmaSqIndx * N + i])), sigmaSqA[i], sigmaSqB[i]); 
-	    currTheta[sigmaSqIndx] = sigmaSqCand; 
+	  }
+	  for (k = 0; k < amD; k++) {
+	    amX[k] = logit(currTheta[amIndx[k]], amA[i * amD + k], amB[i * amD + k]); 
+	  }
+	  mvrnorm(amXCand, amX, &amChol[i * amDD], amD); 
+	  for (k = 0; k < amD; k++) {
+	    currTheta[amIndx[k]] = logitInv(amXCand[k], amA[i * amD + k], amB[i * amD + k]); 
+	  }
+	  phiCand = currTheta[phiIndx]; 
+	  if (isMatern) {
+	    nuCand = currTheta[nuIndx]; 
+          }
+	  if (sigmaSqIG == 0) {
+	    sigmaSqCand = currTheta[sigmaSqIndx]; 
 	  }
 
 	  // Construct proposal covariance matrix (stored in CCand). 
@@ -802,7 +847,7 @@ extern "C" {
 	  F77_NAME(dsymv)(lower, &J, &one,  CCand, &J, &w[i], &N, &zero, tmp_JD, &inc FCONE);
 	  logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&J, &w[i], &N, tmp_JD, &inc);
 	  // Rprintf("logPostCand: %f\n", logPostCand); 
-          if (corName == "matern"){
+          if (isMatern){
             logPostCand += log(nuCand - nuA[i]) + log(nuB[i] - nuCand); 
           }
 	  if (sigmaSqIG == 0) {
@@ -829,7 +874,7 @@ extern "C" {
 	  F77_NAME(dsymv)(lower, &J, &one, C, &J, &w[i], &N, &zero, tmp_JD, &inc FCONE);
 	  logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&J, &w[i], &N, tmp_JD, &inc);
 	  // Rprintf("logPostCurr: %f\n", logPostCurr); 
-          if (corName == "matern"){
+          if (isMatern){
             logPostCurr += log(nu[i] - nuA[i]) + log(nuB[i] - nu[i]); 
           }
 	  if (sigmaSqIG == 0) {
@@ -842,7 +887,7 @@ extern "C" {
             theta[phiIndx * N + i] = phiCand; 
 	    currTheta[phiIndx] = phiCand;
 	    accept[phiIndx * N + i]++; 
-            if (corName == "matern") {
+            if (isMatern) {
               nu[i] = nuCand; 
 	      currTheta[nuIndx] = nuCand; 
 	      theta[nuIndx * N + i] = nu[i]; 
@@ -854,7 +899,10 @@ extern "C" {
 	      accept[sigmaSqIndx * N + i]++;
 	    }
 	    F77_NAME(dcopy)(&JJ, CCand, &inc, C, &inc); 
+	    F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
           }
+          updateAM(amX, &amMean[i * amD], &amM2[i * amDD], amN[i], amD); 
+          amN[i]++; 
 
           /********************************************************************
            *Update w (spatial random effects)
@@ -965,6 +1013,8 @@ extern "C" {
             }
           }
 
+          // Likelihood values for WAIC are only needed on iterations that are saved.
+          saveIter = (a >= nBurn) && (thinIndx + 1 == nThin);
           /********************************************************************
            *Update Latent Occupancy
            *******************************************************************/
@@ -973,8 +1023,10 @@ extern "C" {
               detProb[i * nObs + r] = logitInv(F77_NAME(ddot)(&pDet, &Xp[r], &nObs, &alpha[i], &N) + alphaStarObs[i * nObs + r], zero, one);
               psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + w[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
               piProd[zLongIndx[r] * N + i] = pow(1.0 - detProb[i * nObs + r], K[r]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	      if (saveIter) {
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	      }
               ySum[zLongIndx[r] * N + i] = y[r * N + i]; 
             } // r
           } else {
@@ -984,9 +1036,11 @@ extern "C" {
                 psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + w[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
               }
               piProd[zLongIndx[r] * N + i] *= (1.0 - detProb[i * nObs + r]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], 
-	          	                            1.0 - y[r * N + i]);
+	      if (saveIter) {
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r],
+							1.0 - y[r * N + i]);
+	      }
               ySum[zLongIndx[r] * N + i] += y[r * N + i]; 
               tmp_J[zLongIndx[r]]++;
             } // r
@@ -997,10 +1051,14 @@ extern "C" {
             psiNum = psi[j * N + i] * piProd[j * N + i]; 
             if (ySum[j * N + i] == zero) {
               z[j * N + i] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j * N + i])));
-              yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      if (saveIter) {
+		yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      }
             } else {
               z[j * N + i] = one; 
-              yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i]; 
+	      if (saveIter) {
+		yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i];
+	      }
             }
             // Reset variables
             piProd[j * N + i] = one;
@@ -1063,6 +1121,12 @@ extern "C" {
         } // k
       } // i
 
+      for (i = 0; i < N; i++) {
+        for (k = 0; k < amD; k++) {
+          amSD[k] = exp(tuning[amIndx[k] * N + i]); 
+        }
+        mkAMChol(amSD, &amM2[i * amDD], amN[i], amD, &amChol[i * amDD]); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -1072,7 +1136,7 @@ extern "C" {
 	  Rprintf("\tSpecies\t\tParameter\tAcceptance\tTuning\n");	  
 	  for (i = 0; i < N; i++) {
 	    Rprintf("\t%i\t\tphi\t\t%3.1f\t\t%1.5f\n", i + 1, 100.0*REAL(acceptSamples_r)[s * nThetaN + phiIndx * N + i], exp(tuning[phiIndx * N + i]));
-	    if (corName == "matern") {
+	    if (isMatern) {
 	      Rprintf("\t%i\t\tnu\t\t%3.1f\t\t%1.5f\n", i + 1, 100.0*REAL(acceptSamples_r)[s * nThetaN + nuIndx * N + i], exp(tuning[nuIndx * N + i]));
 	    }
 	    if (sigmaSqIG == 0) {
@@ -148,6 +148,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *nDetRELong = INTEGER(nDetRELong_r); 
     int *nOccRELong = INTEGER(nOccRELong_r);
     double *K = REAL(K_r); 
@@ -158,7 +159,7 @@ extern "C" {
     int *betaLevelIndx = INTEGER(betaLevelIndx_r);
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -170,9 +171,10 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int status = 0; 
     int thinIndx = 0; 
+    int saveIter = 0;
     int fixedSigmaSq = INTEGER(sigmaSqInfo_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqInfo_r)[1];
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -220,15 +222,15 @@ extern "C" {
      * *******************************************************************/
     int pOccN = pOcc * N; 
     int pDetN = pDet * N; 
-    int nObsN = nObs * N; 
+    int nObsN = intProd(nObs, N); 
     int nDetREN = nDetRE * N; 
     int nOccREN = nOccRE * N; 
-    int JN = J * N;
-    int JpOcc = J * pOcc; 
-    int nObspDet = nObs * pDet;
-    int jj, kk;
-    int JpOccRE = J * pOccRE; 
-    int nObspDetRE = nObs * pDetRE;
+    int JN = intProd(J, N);
+    int JpOcc = intProd(J, pOcc); 
+    int nObspDet = intProd(nObs, pDet);
+    int jj;
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDetRE = intProd(nObs, pDetRE);
     double tmp_0, tmp_02; 
     double *tmp_one = (double *) R_alloc(inc, sizeof(double)); 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -438,7 +440,7 @@ extern "C" {
      Set up spatial stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -450,18 +452,57 @@ extern "C" {
     for (i = 0; i < N; i++) {
       theta[sigmaSqIndx * N + i] = sigmaSq[i]; 
       theta[phiIndx * N + i] = phi[i]; 
-      if (corName == "matern") {
+      if (isMatern) {
         theta[nuIndx * N + i] = nu[i]; 
       } 
     } // i
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale, one block per species. 
+    int amD = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amD++; 
+    }
+    amIndx[amD] = phiIndx; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amD++; 
+    }
+    int amDD = amD * amD; 
+    int *amN = (int *) R_alloc(N, sizeof(int)); 
+    double *amA = (double *) R_alloc(amD * N, sizeof(double)); 
+    double *amB = (double *) R_alloc(amD * N, sizeof(double)); 
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD * N, sizeof(double)); zeros(amMean, amD * N); 
+    double *amM2 = (double *) R_alloc(amDD * N, sizeof(double)); zeros(amM2, amDD * N); 
+    double *amChol = (double *) R_alloc(amDD * N, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (i = 0; i < N; i++) {
+      amN[i] = 0; 
+      for (k = 0; k < amD; k++) {
+        if (amIndx[k] == sigmaSqIndx) {
+          amA[i * amD + k] = sigmaSqA[i]; amB[i * amD + k] = sigmaSqB[i]; 
+        } else if (amIndx[k] == phiIndx) {
+          amA[i * amD + k] = phiA[i]; amB[i * amD + k] = phiB[i]; 
+        } else {
+          amA[i * amD + k] = nuA[i]; amB[i * amD + k] = nuB[i]; 
+        }
+        amSD[k] = exp(tuning[amIndx[k] * N + i]); 
+      }
+      mkAMChol(amSD, &amM2[i * amDD], amN[i], amD, &amChol[i * amDD]); 
+    }
     SEXP thetaSamples_r; 
     PROTECT(thetaSamples_r = allocMatrix(REALSXP, nThetaN, nPost)); nProtect++; 
     // For NNGP
-    double a, v, b, e, mu, var, aij; 
+    double a, v, b, e, mu, var, aij, wNew; 
+    // NNGP residuals w_j - B_j w_N(j) of the current species, kept current 
+    // through the w sweep
+    double *wResid = (double *) R_alloc(J, sizeof(double)); 
 
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP. Create a copy of these for each species. Increases storage 
     // space that is needed, but reduces amount of computations. 
@@ -636,9 +677,12 @@ extern "C" {
           /********************************************************************
            *Update Occupancy Auxiliary Variables 
            *******************************************************************/
+          // Linear predictors for all sites, then the PG draws in one batch. 
+          F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, &beta[i], &N, &zero, omegaOcc, &inc FCONE);
           for (j = 0; j < J; j++) {
-            omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, &beta[i], &N) + w[j * N + i] + betaStarSites[i * J + j]);
+            omegaOcc[j] += w[j * N + i] + betaStarSites[i * J + j];
           } // j
+          rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
           /********************************************************************
            *Update Detection Auxiliary Variables 
            *******************************************************************/
@@ -844,36 +888,28 @@ extern "C" {
           /********************************************************************
            *Update w (spatial random effects)
            *******************************************************************/
+	  mkNNResid(J, &w[i], N, &B[i * nIndx], 1, nnIndx, nnIndxLU, wResid);
 	  for (ii = 0; ii < J; ii++ ) {
             a = 0;
 	    v = 0;
-	    if (uIndxLU[J + ii] > 0){ // is ii a neighbor for anybody
-	      for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
-	        b = 0;
-	        // now the neighbors for the jth location who has ii as a neighbor
-	        jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
-	        for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	          kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	          if(kk != ii){ //if the neighbor of jj is not ii
-	    	    b += B[i*nIndx + nnIndxLU[jj]+k]*w[kk * N + i]; //covariance between jj and kk and the random effect of kk
-	          }
-	        }
-	        aij = w[jj * N + i] - b;
-	        a += B[i*nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]]*aij/F[i*J + jj];
-	        v += pow(B[i * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]],2)/F[i * J + jj];
-	      }
+	    for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
+	      jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
+	      b = B[i * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]];
+	      // residual of jj given its neighbors other than ii
+	      aij = wResid[jj] + b*w[ii * N + i];
+	      a += b*aij/F[i * J + jj];
+	      v += b*b/F[i * J + jj];
 	    }
 	    
-	    e = 0;
-	    for(j = 0; j < nnIndxLU[J+ii]; j++){
-	      e += B[i * nIndx + nnIndxLU[ii]+j]*w[nnIndx[nnIndxLU[ii]+j] * N + i];
-	    }
+	    e = w[ii * N + i] - wResid[ii];
 	    
 	    mu = (kappaOcc[ii] / omegaOcc[ii] - F77_NAME(ddot)(&pOcc, &X[ii], &J, &beta[i], &N)- betaStarSites[i * J + ii])*omegaOcc[ii] + e/F[i*J + ii] + a;
 	    
 	    var = 1.0/(omegaOcc[ii] + 1.0/F[i * J + ii] + v);
 	    
-	    w[ii * N + i] = rnorm(mu*var, sqrt(var));
+	    wNew = rnorm(mu*var, sqrt(var));
+	    updateNNResid(ii, wNew - w[ii * N + i], J, &B[i * nIndx], 1, nnIndxLU, uIndx, uIndxLU, uiIndx, wResid);
+	    w[ii * N + i] = wNew;
 
           } // ii
 
@@ -907,7 +943,7 @@ extern "C" {
            *Update phi (and nu if matern)
            *******************************************************************/
           // Current
-          if (corName == "matern"){ 
+          if (isMatern){ 
 	    nu[i] = theta[nuIndx * N + i];
        	  }
           updateBF1MsRE(&B[i * nIndx], &F[i*J], &c[i * m*nThreads], &C[i * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * N + i], theta[phiIndx * N + i], nu[i], covModel, &bk[i * sizeBK], nuB[i]);
@@ -933,7 +969,7 @@ extern "C" {
       
           logPostCurr = -0.5 * logDet - 0.5 * a;
           logPostCurr += log(theta[phiIndx * N + i] - phiA[i]) + log(phiB[i] - theta[phiIndx * N + i]); 
-          if(corName == "matern"){
+          if(isMatern){
        	    logPostCurr += log(theta[nuIndx * N + i] - nuA[i]) + log(nuB[i] - theta[nuIndx * N + i]); 
           }
 	  if (sigmaSqIG == 0) {
@@ -942,13 +978,19 @@ extern "C" {
 	  }
           
           // Candidate
-          phiCand = logitInv(rnorm(logit(theta[phiIndx * N + i], phiA[i], phiB[i]), exp(tuning[phiIndx * N + i])), phiA[i], phiB[i]);
-          if (corName == "matern"){
-      	    nuCand = logitInv(rnorm(logit(theta[nuIndx * N + i], nuA[i], nuB[i]), exp(tuning[nuIndx * N + i])), nuA[i], nuB[i]);
+          for (k = 0; k < amD; k++) {
+            amX[k] = logit(theta[amIndx[k] * N + i], amA[i * amD + k], amB[i * amD + k]); 
+          }
+          mvrnorm(amXCand, amX, &amChol[i * amDD], amD); 
+          for (k = 0; k < amD; k++) {
+            thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[i * amD + k], amB[i * amD + k]); 
+          }
+          phiCand = thetaCand[phiIndx];
+          if (isMatern){
+            nuCand = thetaCand[nuIndx];
           }
 	  if (sigmaSqIG == 0) {
-	    sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx * N + i], sigmaSqA[i], sigmaSqB[i]), 
-	  			 exp(tuning[sigmaSqIndx * N + i])), sigmaSqA[i], sigmaSqB[i]); 
+	    sigmaSqCand = thetaCand[sigmaSqIndx]; 
 	  }
      
 	  if (sigmaSqIG) { 
@@ -979,7 +1021,7 @@ extern "C" {
           
           logPostCand = -0.5*logDet - 0.5*a;      
           logPostCand += log(phiCand - phiA[i]) + log(phiB[i] - phiCand); 
-          if (corName == "matern"){
+          if (isMatern){
             logPostCand += log(nuCand - nuA[i]) + log(nuB[i] - nuCand); 
           }
 	  if (sigmaSqIG == 0) {
@@ -993,7 +1035,7 @@ extern "C" {
             
 	    theta[phiIndx * N + i] = phiCand;
             accept[phiIndx * N + i]++;
-            if (corName == "matern") {
+            if (isMatern) {
               nu[i] = nuCand; 
 	      theta[nuIndx * N + i] = nu[i]; 
               accept[nuIndx * N + i]++; 
@@ -1002,8 +1044,13 @@ extern "C" {
               theta[sigmaSqIndx * N + i] = sigmaSqCand;
 	      accept[sigmaSqIndx * N + i]++;
 	    }
+            F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
           }
+          updateAM(amX, &amMean[i * amD], &amM2[i * amDD], amN[i], amD); 
+          amN[i]++; 
 
+          // Likelihood values for WAIC are only needed on iterations that are saved.
+          saveIter = (g >= nBurn) && (thinIndx + 1 == nThin);
           /********************************************************************
            *Update Latent Occupancy
            *******************************************************************/
@@ -1013,8 +1060,10 @@ extern "C" {
               detProb[i * nObs + r] = logitInv(F77_NAME(ddot)(&pDet, &Xp[r], &nObs, &alpha[i], &N) + alphaStarObs[i * nObs + r], zero, one);
               psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + w[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
               piProd[zLongIndx[r] * N + i] = pow(1.0 - detProb[i * nObs + r], K[r]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	      if (saveIter) {
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], K[r] - y[r * N + i]);
+	      }
               ySum[zLongIndx[r] * N + i] = y[r * N + i]; 
             } // r
           } else {
@@ -1024,9 +1073,11 @@ extern "C" {
                 psi[zLongIndx[r] * N + i] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[r]], &J, &beta[i], &N) + w[zLongIndx[r] * N + i] + betaStarSites[i * J + zLongIndx[r]], zero, one); 
               }
               piProd[zLongIndx[r] * N + i] *= (1.0 - detProb[i * nObs + r]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
-	      piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r], 
-	          	                            1.0 - y[r * N + i]);
+	      if (saveIter) {
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(detProb[i * nObs + r], y[r * N + i]);
+		piProdWAIC[zLongIndx[r] * N + i] *= pow(1.0 - detProb[i * nObs + r],
+							1.0 - y[r * N + i]);
+	      }
               ySum[zLongIndx[r] * N + i] += y[r * N + i]; 
               tmp_J[zLongIndx[r]]++;
             } // r
@@ -1036,10 +1087,14 @@ extern "C" {
             psiNum = psi[j * N + i] * piProd[j * N + i]; 
             if (ySum[j * N + i] == zero) {
               z[j * N + i] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j * N + i])));
-              yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      if (saveIter) {
+		yWAIC[j * N + i] = (1.0 - psi[j * N + i]) + psi[j * N + i] * piProdWAIC[j * N + i];
+	      }
             } else {
               z[j * N + i] = one; 
-              yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i]; 
+	      if (saveIter) {
+		yWAIC[j * N + i] = psi[j * N + i] * piProdWAIC[j * N + i];
+	      }
             }
             // Reset variables
             piProd[j * N + i] = one;
@@ -1102,6 +1157,12 @@ extern "C" {
         } // k
       } // i
 
+      for (i = 0; i < N; i++) {
+        for (k = 0; k < amD; k++) {
+          amSD[k] = exp(tuning[amIndx[k] * N + i]); 
+        }
+        mkAMChol(amSD, &amM2[i * amDD], amN[i], amD, &amChol[i * amDD]); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -1111,7 +1172,7 @@ extern "C" {
 	  Rprintf("\tSpecies\t\tParameter\tAcceptance\tTuning\n");	  
 	  for (i = 0; i < N; i++) {
 	    Rprintf("\t%i\t\tphi\t\t%3.1f\t\t%1.5f\n", i + 1, 100.0*REAL(acceptSamples_r)[s * nThetaN + phiIndx * N + i], exp(tuning[phiIndx * N + i]));
-	    if (corName == "matern") {
+	    if (isMatern) {
 	      Rprintf("\t%i\t\tnu\t\t%3.1f\t\t%1.5f\n", i + 1, 100.0*REAL(acceptSamples_r)[s * nThetaN + nuIndx * N + i], exp(tuning[nuIndx * N + i]));
 	    }
 	    if (sigmaSqIG == 0) {
@@ -26,7 +26,8 @@ extern "C" {
 			    SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
 			    SEXP nReport_r){
 
-    int i, j, k, l, s, info, nProtect=0;
+    int i, j, k, l, info, nProtect=0;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     const double zero = 0.0;
@@ -37,12 +38,12 @@ extern "C" {
     int N = INTEGER(N_r)[0]; 
     int pOcc = INTEGER(pOcc_r)[0];
     int pOccN = pOcc * N;
-    int JN = J * N; 
+    int JN = intProd(J, N); 
 
     double *X0 = REAL(X0_r);
     double *coords0 = REAL(coords0_r);
     int q = INTEGER(q_r)[0];
-    int qN = q * N;
+    int qN = intProd(q, N);
     int m = INTEGER(m_r)[0]; 
     int mm = m * m; 
 
@@ -55,6 +56,7 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
@@ -88,7 +90,7 @@ extern "C" {
     // parameters
     int nTheta, sigmaSqIndx,  phiIndx, nuIndx;
 
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; //sigma^2, phi
       sigmaSqIndx = 0; phiIndx = 1;
     } else{
@@ -106,7 +108,7 @@ extern "C" {
       nb[i] = 0; 
     }
     
-    if(corName == "matern"){
+    if(isMatern){
       for (i = 0; i < N; i++) {
         for(s = 0; s < nSamples; s++){
           if(theta[s*nThetaN + nuIndx * N + i] > nuMax[i]){
@@ -147,14 +149,16 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(qN*nSamples, sizeof(double));
+    R_xlen_t vIndx = -1, nWV;
+    nWV = static_cast<R_xlen_t>(qN)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < qN*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
+    vIndx = -1;
     
     for(j = 0; j < q; j++){
       for (i = 0; i < N; i++) {
@@ -166,7 +170,7 @@ extern "C" {
 	  threadID = omp_get_thread_num();
 #endif 	
 	  phi = theta[s * nThetaN + phiIndx * N + i];
-	  if(corName == "matern"){
+	  if(isMatern){
 	    nu = theta[s * nThetaN + nuIndx * N + i];
 	  }
 	  sigmaSq = theta[s * nThetaN + sigmaSqIndx * N + i];
@@ -29,7 +29,8 @@ extern "C" {
     /*****************************************
                 Common variables
     *****************************************/
-    int i, j, s, info, nProtect= 0;
+    int i, j, info, nProtect= 0;
+    R_xlen_t s;
     const char *lower = "L";
     const char *ntran = "N";
     const char *ytran = "T";
@@ -44,12 +45,12 @@ extern "C" {
 
     int J = INTEGER(J_r)[0];
     int N = INTEGER(N_r)[0]; 
-    int JN = J * N; 
+    int JN = intProd(J, N); 
     int pOcc = INTEGER(pOcc_r)[0];
     int pOccN = N * pOcc; 
     double *X0 = REAL(X0_r);
     int q = INTEGER(q_r)[0];
-    int qN = q * N; 
+    int qN = intProd(q, N); 
 
     double *obsD = REAL(obsD_r);
     double *obsPredD = REAL(obsPredD_r);
@@ -108,8 +109,8 @@ extern "C" {
       }
     int nThetaN = nTheta * N; 
     double *theta = (double *) R_alloc(nTheta, sizeof(double));
-    int JJ = J * J; 
-    int qJ = q * J; 
+    int JJ = intProd(J, J); 
+    int qJ = intProd(q, J); 
     
     SEXP w0_r, psi0_r, z0_r;
 
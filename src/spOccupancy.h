@@ -51,7 +51,24 @@ extern "C" {
 	           SEXP tuning_r, SEXP covModel_r, SEXP nBatch_r, 
 	           SEXP batchLength_r, SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, 
 	           SEXP nReport_r, SEXP samplesInfo_r, SEXP chainInfo_r, SEXP fixedParams_r, 
-		   SEXP sigmaSqIG_r);
+		   SEXP sigmaSqIG_r, SEXP asis_r, SEXP amState_r);
+
+  SEXP spPGOccNNGPInit(SEXP y_r, SEXP X_r, SEXP Xp_r, SEXP coords_r,
+		       SEXP XRE_r, SEXP XpRE_r, SEXP consts_r, SEXP K_r,
+		       SEXP nOccRELong_r, SEXP nDetRELong_r, SEXP m_r, SEXP nnIndx_r,
+		       SEXP nnIndxLU_r, SEXP uIndx_r, SEXP uIndxLU_r, SEXP uiIndx_r,
+		       SEXP zLongIndx_r, SEXP betaStarting_r, SEXP alphaStarting_r,
+		       SEXP sigmaSqPsiStarting_r, SEXP sigmaSqPStarting_r,
+		       SEXP betaStarStarting_r, SEXP alphaStarStarting_r,
+		       SEXP phiStarting_r, SEXP sigmaSqStarting_r, SEXP nuStarting_r,
+		       SEXP betaStarIndx_r, SEXP betaLevelIndx_r,
+		       SEXP alphaStarIndx_r, SEXP alphaLevelIndx_r,
+		       SEXP muBeta_r, SEXP muAlpha_r, SEXP SigmaBeta_r, SEXP SigmaAlpha_r,
+		       SEXP phiA_r, SEXP phiB_r, SEXP sigmaSqA_r, SEXP sigmaSqB_r,
+		       SEXP nuB_r, SEXP sigmaSqPsiA_r, SEXP sigmaSqPsiB_r,
+		       SEXP sigmaSqPA_r, SEXP sigmaSqPB_r, SEXP sigmaSqIG_r,
+		       SEXP covModel_r, SEXP nIter_r, SEXP nThreads_r,
+		       SEXP fixedParams_r);
 
   SEXP spPGOccPredict(SEXP J_r, SEXP pOcc_r, SEXP X0_r, SEXP q_r, 
 		      SEXP obsD_r, SEXP obsPredD_r, SEXP betaSamples_r, 
@@ -182,7 +199,7 @@ extern "C" {
 		      SEXP nBatch_r, SEXP batchLength_r, 
 		      SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, SEXP nReport_r, 
       	              SEXP nBurn_r, SEXP nThin_r, SEXP nPost_r, SEXP currChain_r, SEXP nChain_r, 
-		      SEXP fixedSigmaSq_r, SEXP sigmaSqIG_r);
+		      SEXP fixedSigmaSq_r, SEXP sigmaSqIG_r, SEXP asis_r);
 
   SEXP lfMsPGOcc(SEXP y_r, SEXP X_r, SEXP Xp_r, SEXP XRE_r, SEXP XpRE_r, 
 		 SEXP consts_r, SEXP K_r,
@@ -230,7 +247,7 @@ extern "C" {
 			    SEXP thetaSamples_r, SEXP lambdaSamples_r, 
 			    SEXP wSamples_r, SEXP betaStarSiteSamples_r, 
 			    SEXP nSamples_r, SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
-			    SEXP nReport_r);
+			    SEXP nReport_r, SEXP speciesLevel_r);
 
   SEXP lfJSDM(SEXP y_r, SEXP X_r, SEXP XRE_r, SEXP consts_r, SEXP nOccRELong_r, 
 		 SEXP betaStarting_r, SEXP betaCommStarting_r, 
@@ -297,7 +314,7 @@ extern "C" {
 		   SEXP tuning_r, SEXP covModel_r, SEXP nBatch_r, 
 	           SEXP batchLength_r, SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, 
 	           SEXP nReport_r, SEXP nBurn_r, SEXP nThin_r, SEXP nPost_r, 
-		   SEXP currChain_r, SEXP nChain_r, SEXP sigmaSqIG_r);
+		   SEXP currChain_r, SEXP nChain_r, SEXP sigmaSqIG_r, SEXP asis_r);
 
   SEXP stPGOccNNGPPredict(SEXP coords_r, SEXP J_r, SEXP nYearsMax_r,
 		          SEXP pOcc_r, SEXP m_r, SEXP X0_r, SEXP coords0_r, 
@@ -305,7 +322,7 @@ extern "C" {
 			  SEXP thetaSamples_r, SEXP wSamples_r, 
 			  SEXP betaStarSiteSamples_r, SEXP etaSamples_r, SEXP nSamples_r, 
 			  SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
-			  SEXP nReport_r);
+			  SEXP nReport_r, SEXP summaryOnly_r);
 
   SEXP svcPGBinomNNGP(SEXP y_r, SEXP X_r, SEXP Xw_r, SEXP coords_r, SEXP XRE_r, 
 	            SEXP consts_r, SEXP weights_r, SEXP nRELong_r, SEXP m_r, SEXP nnIndx_r, 
@@ -419,4 +436,31 @@ extern "C" {
 	       SEXP nSamples_r, SEXP nThreads_r, SEXP verbose_r, SEXP nReport_r, 
 	       SEXP samplesInfo_r, SEXP chainInfo_r);
 
+  SEXP occSessionNew(SEXP inputs_r, SEXP states_r);
+
+  SEXP occSessionGet(SEXP session_r);
+
+  SEXP occSessionSetStates(SEXP session_r, SEXP states_r);
+
+  SEXP mkNNIndx0(SEXP n_r, SEXP m_r, SEXP coords_r, SEXP q_r, SEXP coords0_r, 
+		 SEXP nnIndx0_r, SEXP nnDist0_r, SEXP nThreads_r);
+
+  SEXP mkNNIndxAppend(SEXP n_r, SEXP nNew_r, SEXP m_r, SEXP coords_r, SEXP nnIndx_r, 
+		      SEXP uIndx_r, SEXP uIndxLU_r, SEXP uiIndx_r, SEXP nThreads_r);
+
+  SEXP nnHash(SEXP x_r);
+
+  SEXP nnLogLik(SEXP coords_r, SEXP n_r, SEXP m_r, SEXP nnIndx_r, SEXP nnIndxLU_r, SEXP w_r, SEXP nW_r, 
+		SEXP theta_r, SEXP covModel_r, SEXP nThreads_r);
+
+  SEXP readOccData(SEXP file_r);
+
+  SEXP occLongIndx(SEXP y_r, SEXP Xp_r, SEXP XpRE_r);
+
+  SEXP psisLoo(SEXP logLik_r, SEXP nSamples_r, SEXP nObs_r, SEXP nThreads_r);
+
+  SEXP postSummary(SEXP samples_r, SEXP probs_r, SEXP nThreads_r);
+
+  SEXP rbinomSamples(SEXP prob_r);
+
 }
@@ -92,6 +92,7 @@ extern "C" {
     int *nDetRELong = INTEGER(nDetRELong_r); 
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int *alphaStarIndx = INTEGER(alphaStarIndx_r); 
     int *alphaLevelIndx = INTEGER(alphaLevelIndx_r);
@@ -100,7 +101,7 @@ extern "C" {
     double *K = REAL(K_r); 
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -111,9 +112,10 @@ extern "C" {
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
     int thinIndx = 0; 
+    int saveIter = 0;
     int fixedSigmaSq = INTEGER(fixedSigmaSq_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
-    int sPost = 0; 
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -219,11 +221,11 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int JJ = J * J; 
-    int nObspDet = nObs * pDet;
-    int JpOccRE = J * pOccRE; 
-    int nObspDetRE = nObs * pDetRE;
+    int JpOcc = intProd(J, pOcc); 
+    int JJ = intProd(J, J); 
+    int nObspDet = intProd(nObs, pDet);
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDetRE = intProd(nObs, pDetRE);
     double tmp_0, tmp_02; 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
@@ -312,7 +314,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -334,9 +336,32 @@ extern "C" {
     double phi = REAL(phiStarting_r)[0]; 
     double sigmaSq = theta[sigmaSqIndx];
     theta[phiIndx] = phi; 
-    if (corName == "matern") {
+    if (isMatern) {
       theta[nuIndx] = nu; 
     }
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale. 
+    int amD = 0, amN = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    double *amA = (double *) R_alloc(nTheta, sizeof(double)); 
+    double *amB = (double *) R_alloc(nTheta, sizeof(double)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amA[amD] = sigmaSqA; amB[amD] = sigmaSqB; amD++; 
+    }
+    amIndx[amD] = phiIndx; amA[amD] = phiA; amB[amD] = phiB; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amA[amD] = nuA; amB[amD] = nuB; amD++; 
+    }
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD, sizeof(double)); zeros(amMean, amD); 
+    double *amM2 = (double *) R_alloc(amD*amD, sizeof(double)); zeros(amM2, amD*amD); 
+    double *amChol = (double *) R_alloc(amD*amD, sizeof(double)); 
+    for (k = 0; k < amD; k++) {
+      amSD[k] = exp(tuning[amIndx[k]]); 
+    }
+    mkAMChol(amSD, amM2, amN, amD, amChol); 
     double *C = (double *) R_alloc(JJ, sizeof(double));
     double *CCand = (double *) R_alloc(JJ, sizeof(double));
     double *tmp_JD = (double *) R_alloc(J, sizeof(double));
@@ -366,9 +391,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + w[j] + betaStarSites[j]);
+          omegaOcc[j] += w[j] + betaStarSites[j];
         } // j
+        rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -604,19 +632,26 @@ extern "C" {
         /********************************************************************
          *Update phi (and nu if matern and sigmaSq if uniform prior)
          *******************************************************************/
-	if (corName == "matern") {
-          nu = theta[nuIndx]; 
-	  nuCand = logitInv(rnorm(logit(theta[nuIndx], nuA, nuB), exp(tuning[nuIndx])), nuA, nuB); 
-          theta[nuIndx] = nuCand; 
-        }
+	if (isMatern) {
+	  nu = theta[nuIndx]; 
+	}
 	phi = theta[phiIndx]; 
-	phiCand = logitInv(rnorm(logit(phi, phiA, phiB), exp(tuning[phiIndx])), phiA, phiB); 
-	theta[phiIndx] = phiCand; 
 	if (sigmaSqIG == 0) {
 	  sigmaSq = theta[sigmaSqIndx]; 
-	  sigmaSqCand = logitInv(rnorm(logit(sigmaSq, sigmaSqA, sigmaSqB), 
-				 exp(tuning[sigmaSqIndx])), sigmaSqA, sigmaSqB); 
-	  theta[sigmaSqIndx] = sigmaSqCand; 
+	}
+	for (k = 0; k < amD; k++) {
+	  amX[k] = logit(theta[amIndx[k]], amA[k], amB[k]); 
+	}
+	mvrnorm(amXCand, amX, amChol, amD); 
+	for (k = 0; k < amD; k++) {
+	  theta[amIndx[k]] = logitInv(amXCand[k], amA[k], amB[k]); 
+	}
+	phiCand = theta[phiIndx]; 
+	if (isMatern) {
+	  nuCand = theta[nuIndx]; 
+	}
+	if (sigmaSqIG == 0) {
+	  sigmaSqCand = theta[sigmaSqIndx]; 
 	}
 
 	// Construct covariance matrix (stored in C). 
@@ -641,7 +676,7 @@ extern "C" {
 	// (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	F77_NAME(dsymv)(lower, &J, &one,  CCand, &J, w, &inc, &zero, tmp_JD, &inc FCONE);
 	logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&J, w, &inc, tmp_JD, &inc);
-        if (corName == "matern"){
+        if (isMatern){
           logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
         }
 	if (sigmaSqIG == 0) {
@@ -651,7 +686,7 @@ extern "C" {
         /********************************
          * Current
          *******************************/
-	if (corName == "matern") {
+	if (isMatern) {
 	  theta[nuIndx] = nu; 
 	}
 	theta[phiIndx] = phi; 
@@ -672,7 +707,7 @@ extern "C" {
 	// (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	F77_NAME(dsymv)(lower, &J, &one, C, &J, w, &inc, &zero, tmp_JD, &inc FCONE);
 	logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&J, w, &inc, tmp_JD, &inc);
-        if (corName == "matern"){
+        if (isMatern){
           logPostCurr += log(nu - nuA) + log(nuB - nu); 
         }
 	if (sigmaSqIG == 0) {
@@ -684,7 +719,7 @@ extern "C" {
 	if (runif(0.0, 1.0) <= exp(logMHRatio)) {
           theta[phiIndx] = phiCand;
           accept[phiIndx]++;
-          if (corName == "matern") {
+          if (isMatern) {
             theta[nuIndx] = nuCand; 
             accept[nuIndx]++; 
           }
@@ -693,7 +728,10 @@ extern "C" {
 	    accept[sigmaSqIndx]++;
 	  }
 	  F77_NAME(dcopy)(&JJ, CCand, &inc, C, &inc); 
+          F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
         }
+        updateAM(amX, amMean, amM2, amN, amD); 
+        amN++; 
 	
         /********************************************************************
          *Update w (spatial random effects)
@@ -727,6 +765,8 @@ extern "C" {
         // Args: destination, mu, cholesky of the covariance matrix, dimension
         mvrnorm(w, tmp_JD2, tmp_JJ, J);
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (q >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -736,8 +776,10 @@ extern "C" {
             detProb[i] = logitInv(F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i], zero, one);
             psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             piProd[zLongIndx[i]] = pow(1.0 - detProb[i], K[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    }
             ySum[zLongIndx[i]] = y[i]; 	
           } // i
         } else {
@@ -747,8 +789,10 @@ extern "C" {
               psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             }
             piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    }
             ySum[zLongIndx[i]] += y[i]; 	
             tmp_J[zLongIndx[i]]++;
           } // i
@@ -759,10 +803,14 @@ extern "C" {
           psiNum = psi[j] * piProd[j]; 
           if (ySum[j] == zero) {
             z[j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j])));          
-            yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j]; 
+	    if (saveIter) {
+	      yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j];
+	    }
           } else {
             z[j] = one; 
-            yWAIC[j] = psi[j] * piProdWAIC[j];
+	    if (saveIter) {
+	      yWAIC[j] = psi[j] * piProdWAIC[j];
+	    }
           }
           piProd[j] = one;
           piProdWAIC[j] = one;
@@ -818,6 +866,10 @@ extern "C" {
           }
         accept[j] = 0;
       }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k]]); 
+      }
+      mkAMChol(amSD, amM2, amN, amD, amChol); 
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -826,7 +878,7 @@ extern "C" {
 	  Rprintf("Batch: %i of %i, %3.2f%%\n", s, nBatch, 100.0*s/nBatch);
 	  Rprintf("\tParameter\tAcceptance\tTuning\n");	  
 	  Rprintf("\tphi\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + phiIndx], exp(tuning[phiIndx]));
-	  if (corName == "matern") {
+	  if (isMatern) {
 	    Rprintf("\tnu\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + nuIndx], exp(tuning[nuIndx]));
 	  }
 	  if (sigmaSqIG == 0) {
@@ -1,5 +1,6 @@
 #define USE_FC_LEN_T
 #include <string>
+#include <algorithm>
 #include "util.h"
 #include "rpg.h"
 
@@ -17,10 +18,39 @@
 # define FCONE
 #endif
 
-void updateBF1RE(double *B, double *F, double *c, double *C, double *coords, int *nnIndx, int *nnIndxLU, int n, int m, double sigmaSq, double phi, double nu, int covModel, double *bk, double nuUnifb){
+// Correlation for a covariance model fixed at compile time, so the B and F 
+// loops below carry no per-pair model dispatch. Same values as spCor.
+template <int covModel>
+static inline double spCorFixed(double D, double phi, double nu, double *bk){
+  if (covModel == 0) {
+    return exp(-phi*D);
+  } else if (covModel == 1) {
+    if(D > 0 && D <= 1.0/phi){
+      return 1.0 - 1.5*phi*D + 0.5*pow(phi*D,3);
+    }else if(D >= 1.0/phi){
+      return 0.0;
+    }else{
+      return 1.0;
+    }
+  } else if (covModel == 2) {
+    if(D*phi > 0.0){
+      return pow(D*phi, nu)/(pow(2, nu-1)*gammafn(nu))*bessel_k_ex(D*phi, nu, 1.0, bk);//thread safe bessel
+    }else{
+      return 1.0;
+    }
+  } else {
+    return exp(-1.0*(pow(phi*D,2)));
+  }
+}
+
+// Returns nonzero if a factorization failed. It runs inside parallel regions, 
+// so the caller raises the error. 
+template <int covModel>
+static int updateBF1REFixed(double *B, double *F, double *c, double *C, double *coords, int *nnIndx, int *nnIndxLU, int n, int m, double sigmaSq, double phi, double nu, double *bk, double nuUnifb){
 
   int i, k, l;
   int info = 0;
+  int fail = 0;
   int inc = 1;
   double one = 1.0;
   double zero = 0.0;
@@ -33,7 +63,7 @@ void updateBF1RE(double *B, double *F, double *c, double *C, double *coords, int
   int mm = m*m;
 
 #ifdef _OPENMP
-#pragma omp parallel for private(k, l, info, threadID, e)
+#pragma omp parallel for private(k, l, info, threadID, e) schedule(static)
 #endif
     for(i = 0; i < n; i++){
 #ifdef _OPENMP
@@ -42,14 +72,23 @@ void updateBF1RE(double *B, double *F, double *c, double *C, double *coords, int
       if(i > 0){
 	for(k = 0; k < nnIndxLU[n+i]; k++){
 	  e = dist2(coords[i], coords[n+i], coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]]);
-	  c[m*threadID+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	  c[m*threadID+k] = sigmaSq*spCorFixed<covModel>(e, phi, nu, &bk[threadID*nb]);
 	  for(l = 0; l <= k; l++){
 	    e = dist2(coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]], coords[nnIndx[nnIndxLU[i]+l]], coords[n+nnIndx[nnIndxLU[i]+l]]);
-	    C[mm*threadID+l*nnIndxLU[n+i]+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	    C[mm*threadID+l*nnIndxLU[n+i]+k] = sigmaSq*spCorFixed<covModel>(e, phi, nu, &bk[threadID*nb]);
 	  }
 	}
-	F77_NAME(dpotrf)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotrf failed\n");}
-	F77_NAME(dpotri)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotri failed\n");}
+	F77_NAME(dpotrf)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); 
+	if(info == 0){
+	  F77_NAME(dpotri)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); 
+	}
+	if(info != 0){
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+	  fail = 1;
+	  continue;
+	}
 	F77_NAME(dsymv)(&lower, &nnIndxLU[n+i], &one, &C[mm*threadID], &nnIndxLU[n+i], &c[m*threadID], &inc, &zero, &B[nnIndxLU[i]], &inc FCONE);
 	F[i] = sigmaSq - F77_NAME(ddot)(&nnIndxLU[n+i], &B[nnIndxLU[i]], &inc, &c[m*threadID], &inc);
       }else{
@@ -58,6 +97,165 @@ void updateBF1RE(double *B, double *F, double *c, double *C, double *coords, int
       }
     }
 
+  return fail;
+}
+
+int updateBF1RE(double *B, double *F, double *c, double *C, double *coords, int *nnIndx, int *nnIndxLU, int n, int m, double sigmaSq, double phi, double nu, int covModel, double *bk, double nuUnifb){
+  switch (covModel) {
+    case 0: return updateBF1REFixed<0>(B, F, c, C, coords, nnIndx, nnIndxLU, n, m, sigmaSq, phi, nu, bk, nuUnifb);
+    case 1: return updateBF1REFixed<1>(B, F, c, C, coords, nnIndx, nnIndxLU, n, m, sigmaSq, phi, nu, bk, nuUnifb);
+    case 2: return updateBF1REFixed<2>(B, F, c, C, coords, nnIndx, nnIndxLU, n, m, sigmaSq, phi, nu, bk, nuUnifb);
+    case 3: return updateBF1REFixed<3>(B, F, c, C, coords, nnIndx, nnIndxLU, n, m, sigmaSq, phi, nu, bk, nuUnifb);
+    default: error("c++ error: cov.model is not correctly specified");
+  }
+}
+
+// Update the detection side of the model given z: PG auxiliary variables, 
+// regression coefficients, random effect variances and random effects. 
+// These are conditionally independent of the occupancy parameters, so this 
+// can run on its own thread. Draws come from the per-thread stream in state 
+// (R's generator if NULL). Since R's API cannot be used off the main 
+// thread, a failed factorization returns an error message instead of 
+// stopping; NULL is returned on success. binom is nObs == J (one binomial 
+// observation per site), fixed at compile time. XpAlpha holds Xp alpha for the 
+// current alpha on entry and is kept up to date; XpRowPtr is NULL unless Xp 
+// is sparse enough to be used in compressed row form.
+template <bool binom>
+static const char *updateDetBlock(double *y, double *Xp, int *XpRowPtr, int *XpColIndx, double *XpVal, 
+		                  int *XpRE, double *K, double *z, int *zLongIndx, 
+		                  int nObs, int pDet, int pDetRE, int nDetRE, 
+				  double *alpha, double *alphaStar, double *alphaStarObs, double *sigmaSqP, 
+				  double *omegaDet, double *kappaDet, double *SigmaAlphaInv, double *SigmaAlphaInvMuAlpha, 
+				  double *sigmaSqPA, double *sigmaSqPB, int *nDetRELong, int *alphaStarStart, 
+				  int *alphaStarIndx, int *alphaLevelIndx, int *alphaStarLongIndx, 
+				  int fixedAlpha, int fixedSigmaSqP, double *XpAlpha, double *tmp_nObs, double *tmp_nObspDet, 
+				  double *tmp_ppDet, double *tmp_pDet, double *tmp_pDet2, unsigned long long *state){
+
+  int i, j, l, ll, info;
+  int inc = 1;
+  int ppDet = pDet * pDet;
+  double one = 1.0;
+  double zero = 0.0;
+  double tmp_0, tmp_02, tmp_one;
+  char const *lower = "L";
+
+  /********************************************************************
+   *Update Detection Auxiliary Variables 
+   *******************************************************************/
+  // Note that all of the variables are sampled, but only those at 
+  // locations with z[j] == 1 actually effect the results. 
+  for (i = 0; i < nObs; i++) {
+    if (z[zLongIndx[i]] == 1.0) {
+      omegaDet[i] = rpgThread(binom ? K[i] : 1, XpAlpha[i] + alphaStarObs[i], state);
+    }
+  } // i
+
+  /********************************************************************
+   *Update Detection Regression Coefficients
+   *******************************************************************/
+  // /********************************
+  //  * Compute b.alpha
+  //  *******************************/
+  // First multiply kappDet * the current occupied values, such that values go 
+  // to 0 if they z == 0 and values go to kappaDet if z == 1
+  for (i = 0; i < nObs; i++) {
+    kappaDet[i] = (y[i] - (binom ? K[i] : 1.0)/2.0) * z[zLongIndx[i]];
+    tmp_nObs[i] = kappaDet[i] - omegaDet[i] * alphaStarObs[i]; 
+    tmp_nObs[i] *= z[zLongIndx[i]]; 
+  } // i
+  if (!fixedAlpha) {
+    designTMv(nObs, pDet, Xp, XpRowPtr, XpColIndx, XpVal, tmp_nObs, tmp_pDet); 	  
+    for (j = 0; j < pDet; j++) {
+      tmp_pDet[j] += SigmaAlphaInvMuAlpha[j]; 
+    } // j
+
+    /********************************
+     * Compute A.alpha
+     * *****************************/
+    // omegaDet weighted by z, in tmp_nObs (no longer needed for b.alpha)
+    for (j = 0; j < nObs; j++) {
+      tmp_nObs[j] = omegaDet[j] * z[zLongIndx[j]];
+    } // j
+
+    designCrossprod(nObs, pDet, Xp, XpRowPtr, XpColIndx, XpVal, tmp_nObs, tmp_nObspDet, tmp_ppDet);
+
+    for (j = 0; j < ppDet; j++) {
+      tmp_ppDet[j] += SigmaAlphaInv[j]; 
+    } // j
+
+    F77_NAME(dpotrf)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
+    if(info != 0){return("dpotrf A.alpha failed");}
+    F77_NAME(dpotri)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
+    if(info != 0){return("dpotri A.alpha failed");}
+    F77_NAME(dsymv)(lower, &pDet, &one, tmp_ppDet, &pDet, tmp_pDet, &inc, &zero, tmp_pDet2, &inc FCONE);
+    F77_NAME(dpotrf)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
+    if(info != 0){return("dpotrf here failed");}
+    if (state) {
+      mvrnormThread(alpha, tmp_pDet2, tmp_ppDet, pDet, state);
+    } else {
+      mvrnorm(alpha, tmp_pDet2, tmp_ppDet, pDet);
+    }
+    designMv(nObs, pDet, Xp, XpRowPtr, XpColIndx, XpVal, alpha, XpAlpha);
+  }
+
+  /********************************************************************
+   *Update Detection random effects variance
+   *******************************************************************/
+  if (!fixedSigmaSqP) {
+    for (l = 0; l < pDetRE; l++) {
+      tmp_0 = F77_NAME(ddot)(&nDetRELong[l], &alphaStar[alphaStarStart[l]], &inc, &alphaStar[alphaStarStart[l]], &inc); 
+      tmp_0 *= 0.5; 
+      if (state) {
+        sigmaSqP[l] = rigammaThread(sigmaSqPA[l] + nDetRELong[l] / 2.0, sigmaSqPB[l] + tmp_0, state); 
+      } else {
+        sigmaSqP[l] = rigamma(sigmaSqPA[l] + nDetRELong[l] / 2.0, sigmaSqPB[l] + tmp_0); 
+      }
+    }
+  }
+
+  /********************************************************************
+   *Update Detection random effects
+   *******************************************************************/
+  if (pDetRE > 0) {
+    // Update each individual random effect one by one. 
+    for (l = 0; l < nDetRE; l++) {
+      /********************************
+       * Compute b.alpha.star
+       *******************************/
+      // Only allow information to come from when z[r] == 1 and XpRE == alphaLevelIndx[l]
+      tmp_one = 0.0;
+      tmp_0 = 0.0;
+      for (i = 0; i < nObs; i++) {
+        if ((z[zLongIndx[i]] == 1.0) && (XpRE[alphaStarIndx[l] * nObs + i] == alphaLevelIndx[l])) {
+          tmp_02 = 0.0;
+          for (ll = 0; ll < pDetRE; ll++) {
+            tmp_02 += alphaStar[alphaStarLongIndx[ll * nObs + i]];
+          } 
+          tmp_one += kappaDet[i] - (XpAlpha[i] + tmp_02 - alphaStar[l]) * omegaDet[i];
+          tmp_0 += omegaDet[i];
+        }
+      }
+      /********************************
+       * Compute A.alpha.star
+       *******************************/
+      tmp_0 += 1.0 / sigmaSqP[alphaStarIndx[l]]; 
+      tmp_0 = 1.0 / tmp_0; 
+      if (state) {
+        alphaStar[l] = tmp_0 * tmp_one + sqrt(tmp_0) * normThread(state); 
+      } else {
+        alphaStar[l] = rnorm(tmp_0 * tmp_one, sqrt(tmp_0)); 
+      }
+    }
+    zeros(alphaStarObs, nObs); 
+    // Update the RE sums for the current species
+    for (i = 0; i < nObs; i++) {
+      for (l = 0; l < pDetRE; l++) {
+        alphaStarObs[i] += alphaStar[alphaStarLongIndx[l * nObs + i]]; 
+      }
+    }
+  }
+
+  return(NULL);
 }
 
 extern "C" {
@@ -78,7 +276,7 @@ extern "C" {
 	           SEXP tuning_r, SEXP covModel_r, SEXP nBatch_r, 
 	           SEXP batchLength_r, SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, 
 	           SEXP nReport_r, SEXP samplesInfo_r, SEXP chainInfo_r, SEXP fixedParams_r, 
-		   SEXP sigmaSqIG_r){
+		   SEXP sigmaSqIG_r, SEXP asis_r, SEXP amState_r){
    
     /**********************************************************************
      * Initial constants
@@ -89,8 +287,6 @@ extern "C" {
     const double one = 1.0;
     const double zero = 0.0;
     char const *lower = "L";
-    char const *ntran = "N";
-    char const *ytran = "T";
 
     
     /**********************************************************************
@@ -143,6 +339,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     double *K = REAL(K_r); 
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int *alphaStarIndx = INTEGER(alphaStarIndx_r); 
@@ -151,7 +348,7 @@ extern "C" {
     int *betaLevelIndx = INTEGER(betaLevelIndx_r);
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -163,8 +360,10 @@ extern "C" {
     int nReport = INTEGER(nReport_r)[0];
     int *fixedParams = INTEGER(fixedParams_r);
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
+    int asis = INTEGER(asis_r)[0];
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -174,6 +373,20 @@ extern "C" {
       nThreads = 1;
     }
 #endif
+    // With more than one thread the detection block is updated concurrently 
+    // with the occupancy block, which keeps its own nested parallel loops on 
+    // the remaining threads. 
+    int concurrentDet = 0;
+#ifdef _OPENMP
+    int maxActiveLevels = omp_get_max_active_levels();
+    if (nThreads > 1) {
+      concurrentDet = 1;
+    }
+#endif
+    int nOccThreads = concurrentDet ? std::max(nThreads - 1, 1) : nThreads;
+    // Page placement of the large per-site and per-observation arrays, which 
+    // are first touched below by the threads that use them. 
+    int numa = numaPolicy();
     
     /**********************************************************************
      * Print Information 
@@ -197,6 +410,9 @@ extern "C" {
         Rprintf("Source not compiled with OpenMP support.\n\n");
 #endif
         Rprintf("Adaptive Metropolis with target acceptance rate: %.1f\n", 100*acceptRate);
+        if (asis) {
+          Rprintf("Interweaving (ASIS) updates for the intercept and sigma.sq.\n");
+        }
       }
       Rprintf("----------------------------------------\n");
       Rprintf("\tChain %i\n", currChain);
@@ -220,8 +436,8 @@ extern "C" {
     F77_NAME(dcopy)(&nOccRE, REAL(betaStarStarting_r), &inc, betaStar, &inc); 
     double *alpha = (double *) R_alloc(pDet, sizeof(double));   
     F77_NAME(dcopy)(&pDet, REAL(alphaStarting_r), &inc, alpha, &inc);
+    // Set from wStarting_r once its pages are placed (see below).
     double *w = (double *) R_alloc(J, sizeof(double));   
-    F77_NAME(dcopy)(&J, REAL(wStarting_r), &inc, w, &inc);
     // Detection random effect variances
     double *sigmaSqP = (double *) R_alloc(pDetRE, sizeof(double)); 
     F77_NAME(dcopy)(&pDetRE, REAL(sigmaSqPStarting_r), &inc, sigmaSqP, &inc); 
@@ -232,10 +448,11 @@ extern "C" {
     // Latent Occurrence
     double *z = (double *) R_alloc(J, sizeof(double));   
     F77_NAME(dcopy)(&J, REAL(zStarting_r), &inc, z, &inc);
-    double *omegaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(omegaDet, nObs);
-    double *omegaOcc = (double *) R_alloc(J, sizeof(double)); zeros(omegaOcc, J);
-    double *kappaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(kappaDet, nObs);
-    double *kappaOcc = (double *) R_alloc(J, sizeof(double)); zeros(kappaOcc, J);
+    // Zero-filled where their pages are placed (see below).
+    double *omegaDet = (double *) R_alloc(nObs, sizeof(double)); 
+    double *omegaOcc = (double *) R_alloc(J, sizeof(double)); 
+    double *kappaDet = (double *) R_alloc(nObs, sizeof(double)); 
+    double *kappaOcc = (double *) R_alloc(J, sizeof(double)); 
     
     /**********************************************************************
      * Return Stuff
@@ -271,12 +488,11 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int JJ = J * J; 
-    int JpOccRE = J * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
-    int jj, kk;
+    int JpOcc = intProd(J, pOcc); 
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
+    int jj;
     double tmp_0, tmp_02; 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
@@ -349,6 +565,20 @@ extern "C" {
         alphaStarObs[i] += alphaStar[alphaStarLongIndx[l * nObs + i]];
       }
     }
+    /**********************************************************************
+     * Design matrices
+     * *******************************************************************/
+    // Compressed row copies of X and Xp when they are mostly zeros (e.g., 
+    // indicator columns of factors), and the current linear predictors. 
+    int *XRowPtr, *XColIndx, *XpRowPtr, *XpColIndx; 
+    double *XVal, *XpVal; 
+    mkCSR(J, pOcc, X, 0.25, &XRowPtr, &XColIndx, &XVal); 
+    mkCSR(nObs, pDet, Xp, 0.25, &XpRowPtr, &XpColIndx, &XpVal); 
+    double *XBeta = (double *) R_alloc(J, sizeof(double)); 
+    double *XpAlpha = (double *) R_alloc(nObs, sizeof(double)); 
+    designMv(J, pOcc, X, XRowPtr, XColIndx, XVal, beta, XBeta); 
+    designMv(nObs, pDet, Xp, XpRowPtr, XpColIndx, XpVal, alpha, XpAlpha); 
+
     // Starting index for occurrence random effects
     int *betaStarStart = (int *) R_alloc(pOccRE, sizeof(int)); 
     for (l = 0; l < pOccRE; l++) {
@@ -364,7 +594,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -382,16 +612,57 @@ extern "C" {
     PROTECT(tuningSamples_r = allocMatrix(REALSXP, nTheta, nBatch)); nProtect++; 
     SEXP thetaSamples_r; 
     PROTECT(thetaSamples_r = allocMatrix(REALSXP, nTheta, nPost)); nProtect++; 
-    double a, v, b, e, mu, var, aij; 
+    double a, v, b, e, mu, var, aij, wNew; 
+    // NNGP residuals w_j - B_j w_N(j), kept current through the w sweep
+    double *wResid = (double *) R_alloc(J, sizeof(double)); 
+    // For interweaving (ASIS) updates
+    double ee, asisSigma, asisSigmaCand, logMHRatio; 
     // Initiate spatial values
     theta[sigmaSqIndx] = REAL(sigmaSqStarting_r)[0]; 
     theta[phiIndx] = REAL(phiStarting_r)[0]; 
-    if (corName == "matern") {
+    if (isMatern) {
       theta[nuIndx] = nu; 
     } 
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale. 
+    int amD = 0, amN = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    double *amA = (double *) R_alloc(nTheta, sizeof(double)); 
+    double *amB = (double *) R_alloc(nTheta, sizeof(double)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amA[amD] = sigmaSqA; amB[amD] = sigmaSqB; amD++; 
+    }
+    amIndx[amD] = phiIndx; amA[amD] = phiA; amB[amD] = phiB; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amA[amD] = nuA; amB[amD] = nuB; amD++; 
+    }
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD, sizeof(double)); zeros(amMean, amD); 
+    double *amM2 = (double *) R_alloc(amD*amD, sizeof(double)); zeros(amM2, amD*amD); 
+    double *amChol = (double *) R_alloc(amD*amD, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (k = 0; k < amD; k++) {
+      amSD[k] = exp(tuning[amIndx[k]]); 
+    }
+    // Adaptive state carried over from an earlier run of the chain (see 
+    // updateMCMC): batches done so far, amN, amMean, and amM2. Empty for a 
+    // new chain. 
+    int amDD = amD*amD, batchOffset = 0; 
+    if (length(amState_r) > 0) {
+      if (length(amState_r) != 2 + amD + amDD) {
+        error("c++ error: adaptive Metropolis state does not match the model\n");
+      }
+      batchOffset = static_cast<int>(REAL(amState_r)[0]); 
+      amN = static_cast<int>(REAL(amState_r)[1]); 
+      F77_NAME(dcopy)(&amD, &REAL(amState_r)[2], &inc, amMean, &inc); 
+      F77_NAME(dcopy)(&amDD, &REAL(amState_r)[2 + amD], &inc, amM2, &inc); 
+    }
+    mkAMChol(amSD, amM2, amN, amD, amChol); 
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP
     int mm = m*m;
@@ -404,12 +675,91 @@ extern "C" {
 
     double *bk = (double *) R_alloc(nThreads*(1.0+static_cast<int>(floor(nuB))), sizeof(double));
 
-    if (corName == "matern") {
+    // First touch, in the same two-block team as the sampler: the detection 
+    // thread zero-fills the arrays only the detection block uses, and the 
+    // occupancy thread's nested team zero-fills the per-site arrays with the 
+    // static site partition of its loops. Pages follow the threads only when 
+    // they are bound (e.g., OMP_PROC_BIND). 
+#ifdef _OPENMP
+    if (concurrentDet) {
+      omp_set_max_active_levels(2);
+    }
+#pragma omp parallel num_threads(2) if(concurrentDet)
+#endif
+    {
+      int blockID = 0, nBlocks = 1;
+#ifdef _OPENMP
+      blockID = omp_get_thread_num();
+      nBlocks = omp_get_num_threads();
+#endif
+      if (blockID == 1 || nBlocks == 1) {
+        zeros(omegaDet, nObs);
+        zeros(kappaDet, nObs);
+        zeros(tmp_nObs, nObs);
+        zeros(tmp_nObspDet, nObspDet);
+      }
+      if (blockID == 0) {
+        int nTouch = (nBlocks == 2) ? nOccThreads : nThreads;
+        zerosFirstTouchNN(B, nnIndxLU, J, nTouch, numa);
+        zerosFirstTouch(F, J, nTouch, numa);
+        zerosFirstTouchNN(BCand, nnIndxLU, J, nTouch, numa);
+        zerosFirstTouch(FCand, J, nTouch, numa);
+        zerosFirstTouch(w, J, nTouch, numa);
+        zerosFirstTouch(wResid, J, nTouch, numa);
+        zerosFirstTouch(omegaOcc, J, nTouch, numa);
+        zerosFirstTouch(kappaOcc, J, nTouch, numa);
+      }
+    }
+#ifdef _OPENMP
+    if (concurrentDet) {
+      omp_set_max_active_levels(maxActiveLevels);
+    }
+#endif
+    F77_NAME(dcopy)(&J, REAL(wStarting_r), &inc, w, &inc);
+
+    if (isMatern) {
       nu = theta[nuIndx];
     }
-    updateBF1RE(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], theta[phiIndx], nu, covModel, bk, nuB);
+    if (updateBF1RE(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], theta[phiIndx], nu, covModel, bk, nuB)) {
+      error("c++ error: dpotrf failed\n");
+    }
+
+    // Coloring of the sites for the parallel spatial random effects update. 
+    // With a single thread all sites share one color, so the update is the 
+    // usual sequential sweep using R's RNG.
+    int nColors = 1, colorStart, colorEnd;
+    int threadID = 0;
+    int *colorIndx = (int *) R_alloc(J, sizeof(int));
+    int *colorLU = (int *) R_alloc(2*J, sizeof(int));
+    if (nThreads > 1) {
+      nColors = mkColorIndx(J, nnIndx, nnIndxLU, uIndx, uIndxLU, colorIndx, colorLU);
+    } else {
+      for (j = 0; j < J; j++) {
+        colorIndx[j] = j;
+      }
+      colorLU[0] = 0;
+      colorLU[J] = J;
+    }
+    unsigned long long *rngState = (unsigned long long *) R_alloc(nThreads, sizeof(unsigned long long));
+
+    // Neither block can call error() inside the parallel region, so failures 
+    // are recorded and raised after it. 
+    const char *detErr = NULL;
+    const char *occErr = NULL;
+    // Detection block specialized once on the observation model. 
+    decltype(&updateDetBlock<true>) detBlock = (nObs == J) ? updateDetBlock<true> : updateDetBlock<false>;
+    unsigned long long *detRNG = (unsigned long long *) R_alloc(1, sizeof(unsigned long long));
 
     GetRNGstate();
+
+    // The per-thread streams are only seeded when used, so a single-thread 
+    // fit draws the same numbers from R's generator as the serial sampler. 
+    if (nThreads > 1) {
+      seedThreadRNG(rngState, nThreads);
+    }
+    if (concurrentDet) {
+      seedThreadRNG(detRNG, 1);
+    }
    
     /**********************************************************************
      * Begin Sampler 
@@ -417,411 +767,449 @@ extern "C" {
     for (s = 0, q = 0; s < nBatch; s++) {
       for (r = 0; r < batchLength; r++, q++) {
         /********************************************************************
-         *Update Occupancy Auxiliary Variables 
+         *Update Detection and Occupancy Blocks
          *******************************************************************/
-        for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + w[j] + betaStarSites[j]);
-        } // j
-        /********************************************************************
-         *Update Detection Auxiliary Variables 
-         *******************************************************************/
-        // Note that all of the variables are sampled, but only those at 
-        // locations with z[j] == 1 actually effect the results. 
-        if (nObs == J) {
-          for (i = 0; i < nObs; i++) {
-            if (z[zLongIndx[i]] == 1.0) {
-              omegaDet[i] = rpg(K[i], F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
-	    }
-          } // i
-        } else {
-          for (i = 0; i < nObs; i++) {
-            if (z[zLongIndx[i]] == 1.0) {
-              omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
-	    }
-          } // i
+        // Given z, the detection parameters (omegaDet, alpha, sigmaSqP, alphaStar) 
+        // are conditionally independent of the occupancy parameters and w. With 
+        // more than one thread the detection block runs on a second thread with 
+        // its own random number stream while the master thread updates the 
+        // occupancy side. 
+        detErr = NULL;
+        occErr = NULL;
+#ifdef _OPENMP
+        // Nesting is enabled only for this region, so that errors raised 
+        // outside it leave the session's setting unchanged. 
+        if (concurrentDet) {
+          omp_set_max_active_levels(2);
         }
-             
-        /********************************************************************
-         *Update Occupancy Regression Coefficients
-         *******************************************************************/
-        for (j = 0; j < J; j++) {
-          kappaOcc[j] = z[j] - 1.0 / 2.0; 
-          tmp_J1[j] = kappaOcc[j] - omegaOcc[j] * (w[j] + betaStarSites[j]); 
-        } // j
-        if (!fixedParams[0]) {
-          /********************************
-           * Compute b.beta
-           *******************************/
-          F77_NAME(dgemv)(ytran, &J, &pOcc, &one, X, &J, tmp_J1, &inc, &zero, tmp_pOcc, &inc FCONE); 	 
-          for (j = 0; j < pOcc; j++) {
-            tmp_pOcc[j] += SigmaBetaInvMuBeta[j]; 
-          } // j 
-
-          /********************************
-           * Compute A.beta
-           * *****************************/
-          for(j = 0; j < J; j++){
-            for(i = 0; i < pOcc; i++){
-              tmp_JpOcc[i*J+j] = X[i*J+j]*omegaOcc[j];
+#pragma omp parallel num_threads(2) if(concurrentDet)
+#endif
+        {
+          int blockID = 0, nBlocks = 1;
+#ifdef _OPENMP
+          blockID = omp_get_thread_num();
+          nBlocks = omp_get_num_threads();
+#endif
+          if (blockID == 1) {
+            detErr = detBlock(y, Xp, XpRowPtr, XpColIndx, XpVal, XpRE, K, z, zLongIndx, nObs, pDet, pDetRE, nDetRE, 
+                              alpha, alphaStar, alphaStarObs, sigmaSqP, omegaDet, kappaDet, 
+                              SigmaAlphaInv, SigmaAlphaInvMuAlpha, sigmaSqPA, sigmaSqPB, nDetRELong, 
+                              alphaStarStart, alphaStarIndx, alphaLevelIndx, alphaStarLongIndx, 
+                              fixedParams[1], fixedParams[5], XpAlpha, tmp_nObs, tmp_nObspDet, tmp_ppDet, 
+                              tmp_pDet, tmp_pDet2, detRNG);
+          } else {
+            // The runtime may grant a single thread (e.g., OMP_THREAD_LIMIT or 
+            // dynamic adjustment), in which case the detection block runs here. 
+            if (nBlocks == 1) {
+              detErr = detBlock(y, Xp, XpRowPtr, XpColIndx, XpVal, XpRE, K, z, zLongIndx, nObs, pDet, pDetRE, nDetRE, 
+                                alpha, alphaStar, alphaStarObs, sigmaSqP, omegaDet, kappaDet, 
+                                SigmaAlphaInv, SigmaAlphaInvMuAlpha, sigmaSqPA, sigmaSqPB, nDetRELong, 
+                                alphaStarStart, alphaStarIndx, alphaLevelIndx, alphaStarLongIndx, 
+                                fixedParams[1], fixedParams[5], XpAlpha, tmp_nObs, tmp_nObspDet, tmp_ppDet, 
+                                tmp_pDet, tmp_pDet2, concurrentDet ? detRNG : NULL);
             }
-          }
-
-          F77_NAME(dgemm)(ytran, ntran, &pOcc, &pOcc, &J, &one, X, &J, tmp_JpOcc, &J, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
-          for (j = 0; j < ppOcc; j++) {
-            tmp_ppOcc[j] += SigmaBetaInv[j]; 
-          } // j
-
-          F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
-          if(info != 0){error("c++ error: dpotrf here failed\n");}
-          F77_NAME(dpotri)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
-          if(info != 0){error("c++ error: dpotri here failed\n");}
-          F77_NAME(dsymv)(lower, &pOcc, &one, tmp_ppOcc, &pOcc, tmp_pOcc, &inc, &zero, tmp_pOcc2, &inc FCONE);
-          F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
-	  if(info != 0){error("c++ error: dpotrf here failed\n");}
-          mvrnorm(beta, tmp_pOcc2, tmp_ppOcc, pOcc);
-	}
-        
-        /********************************************************************
-         *Update Detection Regression Coefficients
-         *******************************************************************/
-        // /********************************
-        //  * Compute b.alpha
-        //  *******************************/
-        // First multiply kappDet * the current occupied values, such that values go 
-        // to 0 if they z == 0 and values go to kappaDet if z == 1
-        if (nObs == J) {
-          for (i = 0; i < nObs; i++) {
-            kappaDet[i] = (y[i] - K[i]/2.0) * z[zLongIndx[i]];
-            tmp_nObs[i] = kappaDet[i] - omegaDet[i] * alphaStarObs[i]; 
-            tmp_nObs[i] *= z[zLongIndx[i]]; 
-          } // i
-        } else {
-          for (i = 0; i < nObs; i++) {
-            kappaDet[i] = (y[i] - 1.0/2.0) * z[zLongIndx[i]];
-            tmp_nObs[i] = kappaDet[i] - omegaDet[i] * alphaStarObs[i]; 
-            tmp_nObs[i] *= z[zLongIndx[i]]; 
-          } // i
-        }
-	if (!fixedParams[1]) {
-        
-          F77_NAME(dgemv)(ytran, &nObs, &pDet, &one, Xp, &nObs, tmp_nObs, &inc, &zero, tmp_pDet, &inc FCONE); 	  
-          for (j = 0; j < pDet; j++) {
-            tmp_pDet[j] += SigmaAlphaInvMuAlpha[j]; 
-          } // j
-
-          /********************************
-           * Compute A.alpha
-           * *****************************/
-          for (j = 0; j < nObs; j++) {
-            for (i = 0; i < pDet; i++) {
-              tmp_nObspDet[i*nObs + j] = Xp[i * nObs + j] * omegaDet[j] * z[zLongIndx[j]];
-            } // i
-          } // j
-
-          F77_NAME(dgemm)(ytran, ntran, &pDet, &pDet, &nObs, &one, Xp, &nObs, tmp_nObspDet, &nObs, &zero, tmp_ppDet, &pDet FCONE FCONE);
-
-          for (j = 0; j < ppDet; j++) {
-            tmp_ppDet[j] += SigmaAlphaInv[j]; 
-          } // j
-
-          F77_NAME(dpotrf)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
-          if(info != 0){error("c++ error: dpotrf A.alpha failed\n");}
-          F77_NAME(dpotri)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
-          if(info != 0){error("c++ error: dpotri A.alpha failed\n");}
-          F77_NAME(dsymv)(lower, &pDet, &one, tmp_ppDet, &pDet, tmp_pDet, &inc, &zero, tmp_pDet2, &inc FCONE);
-          F77_NAME(dpotrf)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE); 
-          if(info != 0){error("c++ error: dpotrf here failed\n");}
-          mvrnorm(alpha, tmp_pDet2, tmp_ppDet, pDet);
-	}
-
-        /********************************************************************
-         *Update Occupancy random effects variance
-         *******************************************************************/
-	if (!fixedParams[4]) {
-          for (l = 0; l < pOccRE; l++) {
-            tmp_0 = F77_NAME(ddot)(&nOccRELong[l], &betaStar[betaStarStart[l]], &inc, &betaStar[betaStarStart[l]], &inc); 
-            tmp_0 *= 0.5; 
-            sigmaSqPsi[l] = rigamma(sigmaSqPsiA[l] + nOccRELong[l] / 2.0, sigmaSqPsiB[l] + tmp_0); 
-          }
-	}
+#ifdef _OPENMP
+            // The occupancy loops leave one thread to the detection block. 
+            omp_set_num_threads(nBlocks == 2 ? nOccThreads : nThreads);
+#endif
+            /********************************************************************
+             *Update Occupancy Auxiliary Variables 
+             *******************************************************************/
+            // Linear predictors for all sites, then the PG draws in one batch. 
+            for (j = 0; j < J; j++) {
+              omegaOcc[j] = XBeta[j] + w[j] + betaStarSites[j];
+            } // j
+            rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
+            /********************************************************************
+             *Update Occupancy Regression Coefficients
+             *******************************************************************/
+            for (j = 0; j < J; j++) {
+              kappaOcc[j] = z[j] - 1.0 / 2.0; 
+              tmp_J1[j] = kappaOcc[j] - omegaOcc[j] * (w[j] + betaStarSites[j]); 
+            } // j
+            if (!fixedParams[0]) {
+              /********************************
+               * Compute b.beta
+               *******************************/
+              designTMv(J, pOcc, X, XRowPtr, XColIndx, XVal, tmp_J1, tmp_pOcc); 	 
+              for (j = 0; j < pOcc; j++) {
+                tmp_pOcc[j] += SigmaBetaInvMuBeta[j]; 
+              } // j 
 
-        /********************************************************************
-         *Update Detection random effects variance
-         *******************************************************************/
-	if (!fixedParams[5]) {
-          for (l = 0; l < pDetRE; l++) {
-            tmp_0 = F77_NAME(ddot)(&nDetRELong[l], &alphaStar[alphaStarStart[l]], &inc, &alphaStar[alphaStarStart[l]], &inc); 
-            tmp_0 *= 0.5; 
-            sigmaSqP[l] = rigamma(sigmaSqPA[l] + nDetRELong[l] / 2.0, sigmaSqPB[l] + tmp_0); 
-          }
-	}
+              /********************************
+               * Compute A.beta
+               * *****************************/
+              designCrossprod(J, pOcc, X, XRowPtr, XColIndx, XVal, omegaOcc, tmp_JpOcc, tmp_ppOcc);
+              for (j = 0; j < ppOcc; j++) {
+                tmp_ppOcc[j] += SigmaBetaInv[j]; 
+              } // j
 
-        /********************************************************************
-         *Update Occupancy random effects
-         *******************************************************************/
-        if (pOccRE > 0) {
-          // Update each individual random effect one by one. 
-          for (l = 0; l < nOccRE; l++) {
-            /********************************
-             * Compute b.beta.star
-             *******************************/
-            zeros(tmp_one, inc);
-            tmp_0 = 0.0;	      
-            // Only allow information to come from when XRE == betaLevelIndx[l]. 
-            // aka information only comes from the sites with any given level 
-            // of a random effect. 
-            for (j = 0; j < J; j++) {
-              if (XRE[betaStarIndx[l] * J + j] == betaLevelIndx[l]) {
-                tmp_02 = 0.0;
-                for (ll = 0; ll < pOccRE; ll++) {
-                  tmp_02 += betaStar[betaStarLongIndx[ll * J + j]];
-	        } 
-                tmp_one[0] += kappaOcc[j] - (F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + 
-          		    tmp_02 - betaStar[l] + w[j]) * omegaOcc[j];
-                tmp_0 += omegaOcc[j];
+              F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
+              if(info != 0){occErr = "dpotrf here failed";}
+              if (occErr == NULL) {
+                F77_NAME(dpotri)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
+                if(info != 0){occErr = "dpotri here failed";}
+              }
+              if (occErr == NULL) {
+                F77_NAME(dsymv)(lower, &pOcc, &one, tmp_ppOcc, &pOcc, tmp_pOcc, &inc, &zero, tmp_pOcc2, &inc FCONE);
+                F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
+                if(info != 0){occErr = "dpotrf here failed";}
+              }
+              if (occErr == NULL) {
+                mvrnorm(beta, tmp_pOcc2, tmp_ppOcc, pOcc);
+                designMv(J, pOcc, X, XRowPtr, XColIndx, XVal, beta, XBeta);
               }
             }
-            /********************************
-             * Compute A.beta.star
-             *******************************/
-            tmp_0 += 1.0 / sigmaSqPsi[betaStarIndx[l]]; 
-            tmp_0 = 1.0 / tmp_0; 
-            betaStar[l] = rnorm(tmp_0 * tmp_one[0], sqrt(tmp_0)); 
-          }
-        
-          // Update the RE sums for the current species
-          zeros(betaStarSites, J);
-          for (j = 0; j < J; j++) {
-            for (l = 0; l < pOccRE; l++) {
-              betaStarSites[j] += betaStar[betaStarLongIndx[l * J + j]];
-            }
-          }
-        }
 
-        /********************************************************************
-         *Update Detection random effects
-         *******************************************************************/
-        if (pDetRE > 0) {
-          // Update each individual random effect one by one. 
-          for (l = 0; l < nDetRE; l++) {
-            /********************************
-             * Compute b.alpha.star
-             *******************************/
-            // Only allow information to come from when z[r] == 1 and XpRE == alphaLevelIndx[l]
-            zeros(tmp_one, inc);
-            tmp_0 = 0.0;
-            for (i = 0; i < nObs; i++) {
-              if ((z[zLongIndx[i]] == 1.0) && (XpRE[alphaStarIndx[l] * nObs + i] == alphaLevelIndx[l])) {
-                tmp_02 = 0.0;
-                for (ll = 0; ll < pDetRE; ll++) {
-                  tmp_02 += alphaStar[alphaStarLongIndx[ll * nObs + i]];
-	        } 
-                tmp_one[0] += kappaDet[i] - (F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + tmp_02 - alphaStar[l]) * omegaDet[i];
-        	      tmp_0 += omegaDet[i];
+            /********************************************************************
+             *Update Occupancy random effects variance
+             *******************************************************************/
+            if (!fixedParams[4]) {
+              for (l = 0; l < pOccRE; l++) {
+                tmp_0 = F77_NAME(ddot)(&nOccRELong[l], &betaStar[betaStarStart[l]], &inc, &betaStar[betaStarStart[l]], &inc); 
+                tmp_0 *= 0.5; 
+                sigmaSqPsi[l] = rigamma(sigmaSqPsiA[l] + nOccRELong[l] / 2.0, sigmaSqPsiB[l] + tmp_0); 
               }
             }
-            /********************************
-             * Compute A.alpha.star
-             *******************************/
-            tmp_0 += 1.0 / sigmaSqP[alphaStarIndx[l]]; 
-            tmp_0 = 1.0 / tmp_0; 
-            alphaStar[l] = rnorm(tmp_0 * tmp_one[0], sqrt(tmp_0)); 
-          }
-          zeros(alphaStarObs, nObs); 
-          // Update the RE sums for the current species
-          for (i = 0; i < nObs; i++) {
-            for (l = 0; l < pDetRE; l++) {
-              alphaStarObs[i] += alphaStar[alphaStarLongIndx[l * nObs + i]]; 
+
+            /********************************************************************
+             *Update Occupancy random effects
+             *******************************************************************/
+            if (pOccRE > 0) {
+              // Update each individual random effect one by one. 
+              for (l = 0; l < nOccRE; l++) {
+                /********************************
+                 * Compute b.beta.star
+                 *******************************/
+                zeros(tmp_one, inc);
+                tmp_0 = 0.0;	      
+                // Only allow information to come from when XRE == betaLevelIndx[l]. 
+                // aka information only comes from the sites with any given level 
+                // of a random effect. 
+                for (j = 0; j < J; j++) {
+                  if (XRE[betaStarIndx[l] * J + j] == betaLevelIndx[l]) {
+                    tmp_02 = 0.0;
+                    for (ll = 0; ll < pOccRE; ll++) {
+                      tmp_02 += betaStar[betaStarLongIndx[ll * J + j]];
+                    } 
+                    tmp_one[0] += kappaOcc[j] - (XBeta[j] + 
+                                tmp_02 - betaStar[l] + w[j]) * omegaOcc[j];
+                    tmp_0 += omegaOcc[j];
+                  }
+                }
+                /********************************
+                 * Compute A.beta.star
+                 *******************************/
+                tmp_0 += 1.0 / sigmaSqPsi[betaStarIndx[l]]; 
+                tmp_0 = 1.0 / tmp_0; 
+                betaStar[l] = rnorm(tmp_0 * tmp_one[0], sqrt(tmp_0)); 
+              }
+
+              // Update the RE sums for the current species
+              zeros(betaStarSites, J);
+              for (j = 0; j < J; j++) {
+                for (l = 0; l < pOccRE; l++) {
+                  betaStarSites[j] += betaStar[betaStarLongIndx[l * J + j]];
+                }
+              }
             }
-          }
-        }
 
-        /********************************************************************
-         *Update w (spatial random effects)
-         *******************************************************************/
-	for (i = 0; i < J; i++ ) {
-          a = 0;
-	  v = 0;
-	  if (uIndxLU[J + i] > 0){ // is i a neighbor for anybody
-	    for (j = 0; j < uIndxLU[J+i]; j++){ // how many locations have i as a neighbor
-	      b = 0;
-	      // now the neighbors for the jth location who has i as a neighbor
-	      jj = uIndx[uIndxLU[i]+j]; // jj is the index of the jth location who has i as a neighbor
-	      for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	        kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	        if(kk != i){ //if the neighbor of jj is not i
-	  	b += B[nnIndxLU[jj]+k]*w[kk]; //covariance between jj and kk and the random effect of kk
-	        }
-	      }
-	      aij = w[jj] - b;
-	      a += B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]]*aij/F[jj];
-	      v += pow(B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]],2)/F[jj];
-	    }
-	  }
-	  
-	  e = 0;
-	  for(j = 0; j < nnIndxLU[J+i]; j++){
-	    e += B[nnIndxLU[i]+j]*w[nnIndx[nnIndxLU[i]+j]];
-	  }
-	  
-	  mu = (kappaOcc[i] / omegaOcc[i] - F77_NAME(ddot)(&pOcc, &X[i], &J, beta, &inc) - betaStarSites[i])*omegaOcc[i] + e/F[i] + a;
-	  
-	  var = 1.0/(omegaOcc[i] + 1.0/F[i] + v);
-	  
-	  w[i] = rnorm(mu*var, sqrt(var));
+            /********************************************************************
+             *Update w (spatial random effects)
+             *******************************************************************/
+            // Sites of the same color are conditionally independent given the 
+            // others and are updated in parallel. The residuals of the sites 
+            // that have i as a neighbor are updated along with w[i]; coloring 
+            // keeps them from being touched by two sites of the same color.
+            mkNNResid(J, w, 1, B, 1, nnIndx, nnIndxLU, wResid);
+            for (l = 0; l < nColors; l++) {
+              colorStart = colorLU[l];
+              colorEnd = colorLU[l] + colorLU[J+l];
+              // Sites of a color are in increasing order, so the static 
+              // split gives each thread roughly the sites it first touched.
+    #ifdef _OPENMP
+    #pragma omp parallel for private (i, j, jj, a, v, b, aij, e, mu, var, wNew, threadID) schedule(static)
+    #endif
+              for (ll = colorStart; ll < colorEnd; ll++) {
+                i = colorIndx[ll];
+                a = 0;
+                v = 0;
+                for (j = 0; j < uIndxLU[J+i]; j++){ // how many locations have i as a neighbor
+                  jj = uIndx[uIndxLU[i]+j]; // jj is the index of the jth location who has i as a neighbor
+                  b = B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]];
+                  // residual of jj given its neighbors other than i
+                  aij = wResid[jj] + b*w[i];
+                  a += b*aij/F[jj];
+                  v += b*b/F[jj];
+                }
 
-        } // i 
+                e = w[i] - wResid[i];
 
-        /********************************************************************
-         *Update sigmaSq
-         *******************************************************************/
-	if (!fixedParams[3]) {
-          if (sigmaSqIG) {
-#ifdef _OPENMP
-#pragma omp parallel for private (e, i, b) reduction(+:a, logDet)
-#endif
-            for (j = 0; j < J; j++){
-              if(nnIndxLU[J+j] > 0){
+                mu = (kappaOcc[i] / omegaOcc[i] - XBeta[i] - betaStarSites[i])*omegaOcc[i] + e/F[i] + a;
+
+                var = 1.0/(omegaOcc[i] + 1.0/F[i] + v);
+
+                if (nThreads > 1) {
+    #ifdef _OPENMP
+                  threadID = omp_get_thread_num();
+    #endif
+                  wNew = mu*var + sqrt(var)*normThread(&rngState[threadID]);
+                } else {
+                  wNew = rnorm(mu*var, sqrt(var));
+                }
+                updateNNResid(i, wNew - w[i], J, B, 1, nnIndxLU, uIndx, uIndxLU, uiIndx, wResid);
+                w[i] = wNew;
+              } // ll
+            } // l
+
+            /********************************************************************
+             *Interweave the intercept (ASIS)
+             *******************************************************************/
+            // Redraw the intercept given the centered spatial effects w + beta[0], 
+            // which leaves the linear predictor unchanged. Uses the current B and F. 
+            if (asis && !fixedParams[0]) {
+              a = 0;
+              v = 0;
+    #ifdef _OPENMP
+    #pragma omp parallel for private (e, ee, i) reduction(+:a, v) schedule(static)
+    #endif
+              for (j = 0; j < J; j++) {
                 e = 0;
-                for(i = 0; i < nnIndxLU[J+j]; i++){
-                  e += B[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+                ee = 0;
+                for (i = 0; i < nnIndxLU[J+j]; i++) {
+                  e += B[nnIndxLU[j]+i];
+                  ee += B[nnIndxLU[j]+i]*(w[nnIndx[nnIndxLU[j]+i]] + beta[0]);
                 }
-                b = w[j] - e;
-              }else{
-                b = w[j];
-              }	
-              a += b*b/F[j];
+                a += (1.0 - e)*(w[j] + beta[0] - ee)/F[j];
+                v += (1.0 - e)*(1.0 - e)/F[j];
+              }
+              // Prior for the intercept conditional on the other coefficients. 
+              mu = SigmaBetaInv[0] * muBeta[0];
+              for (k = 1; k < pOcc; k++) {
+                mu -= SigmaBetaInv[k] * (beta[k] - muBeta[k]); 
+              }
+              var = 1.0 / (SigmaBetaInv[0] + v);
+              b = rnorm((mu + a) * var, sqrt(var)); 
+              // The intercept column is all ones
+              for (j = 0; j < J; j++) {
+                w[j] += beta[0] - b; 
+                XBeta[j] += b - beta[0]; 
+              }
+              beta[0] = b; 
             }
 
-	    theta[sigmaSqIndx] = rigamma(sigmaSqA + J / 2.0, sigmaSqB + 0.5 * a * theta[sigmaSqIndx]); 
-	  }
-	}
+            /********************************************************************
+             *Update sigmaSq
+             *******************************************************************/
+            if (!fixedParams[3]) {
+              if (sigmaSqIG) {
+                a = 0;
+    #ifdef _OPENMP
+    #pragma omp parallel for private (e, i, b) reduction(+:a, logDet) schedule(static)
+    #endif
+                for (j = 0; j < J; j++){
+                  if(nnIndxLU[J+j] > 0){
+                    e = 0;
+                    for(i = 0; i < nnIndxLU[J+j]; i++){
+                      e += B[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+                    }
+                    b = w[j] - e;
+                  }else{
+                    b = w[j];
+                  }	
+                  a += b*b/F[j];
+                }
 
-        /********************************************************************
-         *Update phi (and nu if matern)
-         *******************************************************************/
-        // Current
-	if (!fixedParams[2] || !fixedParams[3]) {
-          if (corName == "matern"){ nu = theta[nuIndx]; }
-          updateBF1RE(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], 
-		      theta[phiIndx], nu, covModel, bk, nuB);
-	}
-        
-        a = 0;
-        logDet = 0;
+                theta[sigmaSqIndx] = rigamma(sigmaSqA + J / 2.0, sigmaSqB + 0.5 * a * theta[sigmaSqIndx]); 
+              }
 
-        if (!fixedParams[2]) {
-#ifdef _OPENMP
-#pragma omp parallel for private (e, i, b) reduction(+:a, logDet)
-#endif
-          for (j = 0; j < J; j++){
-            if (nnIndxLU[J+j] > 0){
-              e = 0;
-              for (i = 0; i < nnIndxLU[J+j]; i++){
-                e += B[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+              /******************************
+               *Interweave sigmaSq (ASIS)
+               *****************************/
+              // Redraw sigma given the standardized spatial effects w / sigma with an 
+              // independence proposal from the Gaussian PG-augmented likelihood, so 
+              // only the prior enters the acceptance ratio. 
+              if (asis) {
+                asisSigma = sqrt(theta[sigmaSqIndx]); 
+                a = 0;
+                v = 0;
+                for (j = 0; j < J; j++) {
+                  e = w[j] / asisSigma; 
+                  a += e * (kappaOcc[j] - omegaOcc[j] * (XBeta[j] + betaStarSites[j])); 
+                  v += omegaOcc[j] * e * e; 
+                }
+                asisSigmaCand = rnorm(a / v, sqrt(1.0 / v)); 
+                if (asisSigmaCand > 0.0) {
+                  if (sigmaSqIG) {
+                    logMHRatio = -1.0 * (2.0 * sigmaSqA + 1.0) * log(asisSigmaCand / asisSigma) - 
+                                 sigmaSqB / (asisSigmaCand * asisSigmaCand) + sigmaSqB / theta[sigmaSqIndx]; 
+                  } else if (asisSigmaCand * asisSigmaCand > sigmaSqA && asisSigmaCand * asisSigmaCand < sigmaSqB) {
+                    logMHRatio = log(asisSigmaCand / asisSigma); 
+                  } else {
+                    logMHRatio = R_NegInf; 
+                  }
+                  if (runif(0.0, 1.0) <= exp(logMHRatio)) {
+                    for (j = 0; j < J; j++) {
+                      w[j] *= asisSigmaCand / asisSigma; 
+                    }
+                    theta[sigmaSqIndx] = asisSigmaCand * asisSigmaCand; 
+                  }
+                }
               }
-              b = w[j] - e;
-            } else{
-              b = w[j];
-            }	
-            a += b*b/F[j];
-            logDet += log(F[j]);
-          }
-      
-          logPostCurrent = -0.5*logDet - 0.5*a;
-          logPostCurrent += log(theta[phiIndx] - phiA) + log(phiB - theta[phiIndx]); 
-          if(corName == "matern"){
-          	logPostCurrent += log(theta[nuIndx] - nuA) + log(nuB - theta[nuIndx]); 
-          }
-	  if (sigmaSqIG == 0) {
-            logPostCurrent += log(theta[sigmaSqIndx] - sigmaSqA) + log(sigmaSqB - theta[sigmaSqIndx]);
-	  }
-          
-          // Candidate
-          phiCand = logitInv(rnorm(logit(theta[phiIndx], phiA, phiB), exp(tuning[phiIndx])), phiA, phiB);
-          if (corName == "matern"){
-      	    nuCand = logitInv(rnorm(logit(theta[nuIndx], nuA, nuB), exp(tuning[nuIndx])), nuA, nuB);
-          }
-	  if (sigmaSqIG == 0) {
-	    sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx], sigmaSqA, sigmaSqB), 
-	  			 exp(tuning[sigmaSqIndx])), sigmaSqA, sigmaSqB); 
-	  }
-     
-	  if (sigmaSqIG) { 
-          updateBF1RE(BCand, FCand, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], phiCand, nuCand, covModel, bk, nuB);
-	  } else {
-            updateBF1RE(BCand, FCand, c, C, coords, nnIndx, nnIndxLU, J, m, sigmaSqCand, phiCand, nuCand, covModel, bk, nuB);
-	  }
-      
-          a = 0;
-          logDet = 0;
-      
-#ifdef _OPENMP
-#pragma omp parallel for private (e, i, b) reduction(+:a, logDet)
-#endif
-          for (j = 0; j < J; j++){
-            if (nnIndxLU[J+j] > 0){
-              e = 0;
-              for (i = 0; i < nnIndxLU[J+j]; i++){
-                e += BCand[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+            }
+
+            /********************************************************************
+             *Update phi (and nu if matern)
+             *******************************************************************/
+            // Current
+            if (!fixedParams[2] || !fixedParams[3]) {
+              if (isMatern){ nu = theta[nuIndx]; }
+              if (updateBF1RE(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], 
+                              theta[phiIndx], nu, covModel, bk, nuB)) {
+                occErr = "dpotrf failed";
+              }
+            }
+
+            a = 0;
+            logDet = 0;
+
+            if (!fixedParams[2]) {
+    #ifdef _OPENMP
+    #pragma omp parallel for private (e, i, b) reduction(+:a, logDet) schedule(static)
+    #endif
+              for (j = 0; j < J; j++){
+                if (nnIndxLU[J+j] > 0){
+                  e = 0;
+                  for (i = 0; i < nnIndxLU[J+j]; i++){
+                    e += B[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+                  }
+                  b = w[j] - e;
+                } else{
+                  b = w[j];
+                }	
+                a += b*b/F[j];
+                logDet += log(F[j]);
+              }
+
+              logPostCurrent = -0.5*logDet - 0.5*a;
+              logPostCurrent += log(theta[phiIndx] - phiA) + log(phiB - theta[phiIndx]); 
+              if(isMatern){
+                    logPostCurrent += log(theta[nuIndx] - nuA) + log(nuB - theta[nuIndx]); 
+              }
+              if (sigmaSqIG == 0) {
+                logPostCurrent += log(theta[sigmaSqIndx] - sigmaSqA) + log(sigmaSqB - theta[sigmaSqIndx]);
+              }
+
+              // Candidate
+              for (k = 0; k < amD; k++) {
+                amX[k] = logit(theta[amIndx[k]], amA[k], amB[k]); 
+              }
+              mvrnorm(amXCand, amX, amChol, amD); 
+              for (k = 0; k < amD; k++) {
+                thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[k], amB[k]); 
+              }
+              phiCand = thetaCand[phiIndx];
+              if (isMatern){
+                nuCand = thetaCand[nuIndx];
+              }
+              if (sigmaSqIG == 0) {
+                sigmaSqCand = thetaCand[sigmaSqIndx]; 
+              }
+
+              if (sigmaSqIG) { 
+                sigmaSqCand = theta[sigmaSqIndx];
+              }
+              if (updateBF1RE(BCand, FCand, c, C, coords, nnIndx, nnIndxLU, J, m, sigmaSqCand, phiCand, nuCand, covModel, bk, nuB)) {
+                occErr = "dpotrf failed";
               }
-              b = w[j] - e;
-            } else{
-              b = w[j];
-              }	
-              a += b*b/FCand[j];
-              logDet += log(FCand[j]);
-          }
-          
-          logPostCand = -0.5*logDet - 0.5*a;      
-          logPostCand += log(phiCand - phiA) + log(phiB - phiCand); 
-          if (corName == "matern"){
-            logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
-          }
-	  if (sigmaSqIG == 0) {
-            logPostCand += log(sigmaSqCand - sigmaSqA) + log(sigmaSqB - sigmaSqCand);
-	  }
 
-          if (runif(0.0,1.0) <= exp(logPostCand - logPostCurrent)) {
+              a = 0;
+              logDet = 0;
+
+    #ifdef _OPENMP
+    #pragma omp parallel for private (e, i, b) reduction(+:a, logDet) schedule(static)
+    #endif
+              for (j = 0; j < J; j++){
+                if (nnIndxLU[J+j] > 0){
+                  e = 0;
+                  for (i = 0; i < nnIndxLU[J+j]; i++){
+                    e += BCand[nnIndxLU[j]+i]*w[nnIndx[nnIndxLU[j]+i]];
+                  }
+                  b = w[j] - e;
+                } else{
+                  b = w[j];
+                  }	
+                  a += b*b/FCand[j];
+                  logDet += log(FCand[j]);
+              }
 
-            std::swap(BCand, B);
-            std::swap(FCand, F);
-            
-            theta[phiIndx] = phiCand;
-            accept[phiIndx]++;
-            if(corName == "matern"){
-              theta[nuIndx] = nuCand; 
-              accept[nuIndx]++; 
+              logPostCand = -0.5*logDet - 0.5*a;      
+              logPostCand += log(phiCand - phiA) + log(phiB - phiCand); 
+              if (isMatern){
+                logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
+              }
+              if (sigmaSqIG == 0) {
+                logPostCand += log(sigmaSqCand - sigmaSqA) + log(sigmaSqB - sigmaSqCand);
+              }
+
+              if (runif(0.0,1.0) <= exp(logPostCand - logPostCurrent)) {
+
+                std::swap(BCand, B);
+                std::swap(FCand, F);
+
+                theta[phiIndx] = phiCand;
+                accept[phiIndx]++;
+                if(isMatern){
+                  theta[nuIndx] = nuCand; 
+                  accept[nuIndx]++; 
+                }
+                if (sigmaSqIG == 0) {
+                  theta[sigmaSqIndx] = sigmaSqCand;
+                  accept[sigmaSqIndx]++;
+                }
+                F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
+              }
+              updateAM(amX, amMean, amM2, amN, amD); 
+              amN++; 
             }
-	    if (sigmaSqIG == 0) {
-              theta[sigmaSqIndx] = sigmaSqCand;
-	      accept[sigmaSqIndx]++;
-	    }
           }
-	}
+        } // blocks
+#ifdef _OPENMP
+        if (concurrentDet) {
+          omp_set_max_active_levels(maxActiveLevels);
+        }
+#endif
+        if (detErr != NULL) {error("c++ error: %s\n", detErr);}
+        if (occErr != NULL) {error("c++ error: %s\n", occErr);}
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (q >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
         // Compute detection probability 
         if (nObs == J) {
           for (i = 0; i < nObs; i++) {
-            detProb[i] = logitInv(F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i], zero, one);
-            psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
+            detProb[i] = logitInv(XpAlpha[i] + alphaStarObs[i], zero, one);
+            psi[zLongIndx[i]] = logitInv(XBeta[zLongIndx[i]] + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             piProd[zLongIndx[i]] = pow(1.0 - detProb[i], K[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    }
             ySum[zLongIndx[i]] = y[i]; 	
           } // i
         } else {
           for (i = 0; i < nObs; i++) {
-            detProb[i] = logitInv(F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i], zero, one);
+            detProb[i] = logitInv(XpAlpha[i] + alphaStarObs[i], zero, one);
             if (tmp_J[zLongIndx[i]] == 0) {
-              psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
+              psi[zLongIndx[i]] = logitInv(XBeta[zLongIndx[i]] + w[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             }
             piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    }
             ySum[zLongIndx[i]] += y[i]; 	
             tmp_J[zLongIndx[i]]++;
           } // i
@@ -831,10 +1219,14 @@ extern "C" {
           psiNum = psi[j] * piProd[j]; 
           if (ySum[j] == zero) {
             z[j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j])));          
-            yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j]; 
+	    if (saveIter) {
+	      yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j];
+	    }
           } else {
             z[j] = one; 
-            yWAIC[j] = psi[j] * piProdWAIC[j];
+	    if (saveIter) {
+	      yWAIC[j] = psi[j] * piProdWAIC[j];
+	    }
           }
           piProd[j] = one;
           piProdWAIC[j] = one;
@@ -884,12 +1276,16 @@ extern "C" {
         REAL(acceptSamples_r)[s * nTheta + j] = accept[j]/batchLength; 
         REAL(tuningSamples_r)[s * nTheta + j] = tuning[j]; 
         if (accept[j] / batchLength > acceptRate) {
-          tuning[j] += std::min(0.01, 1.0/sqrt(static_cast<double>(s)));
+          tuning[j] += std::min(0.01, 1.0/sqrt(static_cast<double>(s + batchOffset)));
         } else{
-            tuning[j] -= std::min(0.01, 1.0/sqrt(static_cast<double>(s)));
+            tuning[j] -= std::min(0.01, 1.0/sqrt(static_cast<double>(s + batchOffset)));
           }
         accept[j] = 0;
       }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k]]); 
+      }
+      mkAMChol(amSD, amM2, amN, amD, amChol); 
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -898,7 +1294,7 @@ extern "C" {
 	  Rprintf("Batch: %i of %i, %3.2f%%\n", s, nBatch, 100.0*s/nBatch);
 	  Rprintf("\tParameter\tAcceptance\tTuning\n");	  
 	  Rprintf("\tphi\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + phiIndx], exp(tuning[phiIndx]));
-	  if (corName == "matern") {
+	  if (isMatern) {
 	    Rprintf("\tnu\t\t%3.1f\t\t%1.5f\n", 100.0*REAL(acceptSamples_r)[s * nTheta + nuIndx], exp(tuning[nuIndx]));
 	  }
 	  if (sigmaSqIG == 0) {
@@ -921,9 +1317,20 @@ extern "C" {
     // This is necessary when generating random numbers in C.     
     PutRNGstate();
 
+    // Tuning after the last adjustment and the adaptive state, to continue 
+    // the chain. 
+    SEXP tuneFinal_r, amStateOut_r; 
+    PROTECT(tuneFinal_r = allocVector(REALSXP, nTheta)); nProtect++; 
+    F77_NAME(dcopy)(&nTheta, tuning, &inc, REAL(tuneFinal_r), &inc); 
+    PROTECT(amStateOut_r = allocVector(REALSXP, 2 + amD + amDD)); nProtect++; 
+    REAL(amStateOut_r)[0] = batchOffset + nBatch; 
+    REAL(amStateOut_r)[1] = amN; 
+    F77_NAME(dcopy)(&amD, amMean, &inc, &REAL(amStateOut_r)[2], &inc); 
+    F77_NAME(dcopy)(&amDD, amM2, &inc, &REAL(amStateOut_r)[2 + amD], &inc); 
+
     //make return object (which is a list)
     SEXP result_r, resultName_r;
-    int nResultListObjs = 9;
+    int nResultListObjs = 11;
     if (pDetRE > 0) {
       nResultListObjs += 2; 
     }
@@ -944,15 +1351,17 @@ extern "C" {
     SET_VECTOR_ELT(result_r, 6, tuningSamples_r); 
     SET_VECTOR_ELT(result_r, 7, acceptSamples_r); 
     SET_VECTOR_ELT(result_r, 8, likeSamples_r); 
+    SET_VECTOR_ELT(result_r, 9, tuneFinal_r); 
+    SET_VECTOR_ELT(result_r, 10, amStateOut_r); 
     if (pDetRE > 0) {
-      SET_VECTOR_ELT(result_r, 9, sigmaSqPSamples_r);
-      SET_VECTOR_ELT(result_r, 10, alphaStarSamples_r);
+      SET_VECTOR_ELT(result_r, 11, sigmaSqPSamples_r);
+      SET_VECTOR_ELT(result_r, 12, alphaStarSamples_r);
     }
     if (pOccRE > 0) {
       if (pDetRE > 0) {
-        tmp_0 = 11;
+        tmp_0 = 13;
       } else {
-        tmp_0 = 9;
+        tmp_0 = 11;
       }
       SET_VECTOR_ELT(result_r, tmp_0, sigmaSqPsiSamples_r);
       SET_VECTOR_ELT(result_r, tmp_0 + 1, betaStarSamples_r);
@@ -968,9 +1377,11 @@ extern "C" {
     SET_VECTOR_ELT(resultName_r, 6, mkChar("tune")); 
     SET_VECTOR_ELT(resultName_r, 7, mkChar("accept")); 
     SET_VECTOR_ELT(resultName_r, 8, mkChar("like.samples")); 
+    SET_VECTOR_ELT(resultName_r, 9, mkChar("tune.final")); 
+    SET_VECTOR_ELT(resultName_r, 10, mkChar("am.state")); 
     if (pDetRE > 0) {
-      SET_VECTOR_ELT(resultName_r, 9, mkChar("sigma.sq.p.samples")); 
-      SET_VECTOR_ELT(resultName_r, 10, mkChar("alpha.star.samples")); 
+      SET_VECTOR_ELT(resultName_r, 11, mkChar("sigma.sq.p.samples")); 
+      SET_VECTOR_ELT(resultName_r, 12, mkChar("alpha.star.samples")); 
     }
     if (pOccRE > 0) {
       SET_VECTOR_ELT(resultName_r, tmp_0, mkChar("sigma.sq.psi.samples")); 
@@ -0,0 +1,598 @@
+#define USE_FC_LEN_T
+#include <string>
+#include "util.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <R.h>
+#include <Rmath.h>
+#include <Rinternals.h>
+#include <R_ext/Linpack.h>
+#include <R_ext/Lapack.h>
+#include <R_ext/BLAS.h>
+#ifndef FCONE
+# define FCONE
+#endif
+
+// B and F of the NNGP precision for the correlation (sigmaSq = 1) or
+// covariance. Returns the log determinant sum(log(F)).
+static double updateBFInit(double *B, double *F, double *c, double *C, double *coords, int *nnIndx, int *nnIndxLU, int n, int m, double sigmaSq, double phi, double nu, int covModel, double *bk, double nuUnifb){
+
+  int i, k, l;
+  int info = 0;
+  int inc = 1;
+  double one = 1.0;
+  double zero = 0.0;
+  char lower = 'L';
+  double logDet = 0.0;
+
+  //bk must be 1+(int)floor(alpha) * nthread
+  int nb = 1+static_cast<int>(floor(nuUnifb));
+  int threadID = 0;
+  double e;
+  int mm = m*m;
+
+#ifdef _OPENMP
+#pragma omp parallel for private(k, l, info, threadID, e) reduction(+:logDet)
+#endif
+    for(i = 0; i < n; i++){
+#ifdef _OPENMP
+      threadID = omp_get_thread_num();
+#endif
+      if(i > 0){
+	for(k = 0; k < nnIndxLU[n+i]; k++){
+	  e = dist2(coords[i], coords[n+i], coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]]);
+	  c[m*threadID+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	  for(l = 0; l <= k; l++){
+	    e = dist2(coords[nnIndx[nnIndxLU[i]+k]], coords[n+nnIndx[nnIndxLU[i]+k]], coords[nnIndx[nnIndxLU[i]+l]], coords[n+nnIndx[nnIndxLU[i]+l]]);
+	    C[mm*threadID+l*nnIndxLU[n+i]+k] = sigmaSq*spCor(e, phi, nu, covModel, &bk[threadID*nb]);
+	  }
+	}
+	F77_NAME(dpotrf)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotrf failed\n");}
+	F77_NAME(dpotri)(&lower, &nnIndxLU[n+i], &C[mm*threadID], &nnIndxLU[n+i], &info FCONE); if(info != 0){error("c++ error: dpotri failed\n");}
+	F77_NAME(dsymv)(&lower, &nnIndxLU[n+i], &one, &C[mm*threadID], &nnIndxLU[n+i], &c[m*threadID], &inc, &zero, &B[nnIndxLU[i]], &inc FCONE);
+	F[i] = sigmaSq - F77_NAME(ddot)(&nnIndxLU[n+i], &B[nnIndxLU[i]], &inc, &c[m*threadID], &inc);
+      }else{
+	B[i] = 0;
+	F[i] = sigmaSq;
+      }
+      logDet += log(F[i]);
+    }
+    return(logDet);
+}
+
+// Expected value of a PG(b, c) random variable.
+static double pgMean(double b, double c) {
+  if (fabs(c) < 1e-6) {
+    return(b / 4.0);
+  }
+  return(b * tanh(c / 2.0) / (2.0 * c));
+}
+
+extern "C" {
+  SEXP spPGOccNNGPInit(SEXP y_r, SEXP X_r, SEXP Xp_r, SEXP coords_r,
+		       SEXP XRE_r, SEXP XpRE_r, SEXP consts_r, SEXP K_r,
+		       SEXP nOccRELong_r, SEXP nDetRELong_r, SEXP m_r, SEXP nnIndx_r,
+		       SEXP nnIndxLU_r, SEXP uIndx_r, SEXP uIndxLU_r, SEXP uiIndx_r,
+		       SEXP zLongIndx_r, SEXP betaStarting_r, SEXP alphaStarting_r,
+		       SEXP sigmaSqPsiStarting_r, SEXP sigmaSqPStarting_r,
+		       SEXP betaStarStarting_r, SEXP alphaStarStarting_r,
+		       SEXP phiStarting_r, SEXP sigmaSqStarting_r, SEXP nuStarting_r,
+		       SEXP betaStarIndx_r, SEXP betaLevelIndx_r,
+		       SEXP alphaStarIndx_r, SEXP alphaLevelIndx_r,
+		       SEXP muBeta_r, SEXP muAlpha_r, SEXP SigmaBeta_r, SEXP SigmaAlpha_r,
+		       SEXP phiA_r, SEXP phiB_r, SEXP sigmaSqA_r, SEXP sigmaSqB_r,
+		       SEXP nuB_r, SEXP sigmaSqPsiA_r, SEXP sigmaSqPsiB_r,
+		       SEXP sigmaSqPA_r, SEXP sigmaSqPB_r, SEXP sigmaSqIG_r,
+		       SEXP covModel_r, SEXP nIter_r, SEXP nThreads_r,
+		       SEXP fixedParams_r){
+
+    /**********************************************************************
+     * Initial constants
+     * *******************************************************************/
+    int i, j, jj, l, ll, q, info, nProtect=0;
+    const int inc = 1;
+    const double one = 1.0;
+    const double zero = 0.0;
+    char const *lower = "L";
+    char const *ntran = "N";
+    char const *ytran = "T";
+
+    /**********************************************************************
+     * Get Inputs
+     * *******************************************************************/
+    double *y = REAL(y_r);
+    double *X = REAL(X_r);
+    double *Xp = REAL(Xp_r);
+    double *coords = REAL(coords_r);
+    int *XRE = INTEGER(XRE_r);
+    int *XpRE = INTEGER(XpRE_r);
+    int J = INTEGER(consts_r)[0];
+    int nObs = INTEGER(consts_r)[1];
+    int pOcc = INTEGER(consts_r)[2];
+    int pOccRE = INTEGER(consts_r)[3];
+    int nOccRE = INTEGER(consts_r)[4];
+    int pDet = INTEGER(consts_r)[5];
+    int pDetRE = INTEGER(consts_r)[6];
+    int nDetRE = INTEGER(consts_r)[7];
+    int *nOccRELong = INTEGER(nOccRELong_r);
+    int *nDetRELong = INTEGER(nDetRELong_r);
+    int ppDet = pDet * pDet;
+    int ppOcc = pOcc * pOcc;
+    double *K = REAL(K_r);
+    int m = INTEGER(m_r)[0];
+    int *nnIndx = INTEGER(nnIndx_r);
+    int *nnIndxLU = INTEGER(nnIndxLU_r);
+    int *uIndx = INTEGER(uIndx_r);
+    int *uIndxLU = INTEGER(uIndxLU_r);
+    int *uiIndx = INTEGER(uiIndx_r);
+    int *zLongIndx = INTEGER(zLongIndx_r);
+    int *betaStarIndx = INTEGER(betaStarIndx_r);
+    int *betaLevelIndx = INTEGER(betaLevelIndx_r);
+    int *alphaStarIndx = INTEGER(alphaStarIndx_r);
+    int *alphaLevelIndx = INTEGER(alphaLevelIndx_r);
+    double *muBeta = REAL(muBeta_r);
+    double *muAlpha = REAL(muAlpha_r);
+    double *SigmaBetaInv = (double *) R_alloc(ppOcc, sizeof(double));
+    F77_NAME(dcopy)(&ppOcc, REAL(SigmaBeta_r), &inc, SigmaBetaInv, &inc);
+    double *SigmaAlphaInv = (double *) R_alloc(ppDet, sizeof(double));
+    F77_NAME(dcopy)(&ppDet, REAL(SigmaAlpha_r), &inc, SigmaAlphaInv, &inc);
+    double phiA = REAL(phiA_r)[0];
+    double phiB = REAL(phiB_r)[0];
+    double sigmaSqA = REAL(sigmaSqA_r)[0];
+    double sigmaSqB = REAL(sigmaSqB_r)[0];
+    double nuB = REAL(nuB_r)[0];
+    double *sigmaSqPsiA = REAL(sigmaSqPsiA_r);
+    double *sigmaSqPsiB = REAL(sigmaSqPsiB_r);
+    double *sigmaSqPA = REAL(sigmaSqPA_r);
+    double *sigmaSqPB = REAL(sigmaSqPB_r);
+    int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
+    int covModel = INTEGER(covModel_r)[0];
+    std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
+    int nIter = INTEGER(nIter_r)[0];
+    int nThreads = INTEGER(nThreads_r)[0];
+    int *fixedParams = INTEGER(fixedParams_r);
+
+#ifdef _OPENMP
+    omp_set_num_threads(nThreads);
+#else
+    if(nThreads > 1){
+      warning("n.omp.threads > %i, but source not compiled with OpenMP support.", nThreads);
+      nThreads = 1;
+    }
+#endif
+
+    /**********************************************************************
+     * Parameters
+     * *******************************************************************/
+    double *beta = (double *) R_alloc(pOcc, sizeof(double));
+    F77_NAME(dcopy)(&pOcc, REAL(betaStarting_r), &inc, beta, &inc);
+    double *alpha = (double *) R_alloc(pDet, sizeof(double));
+    F77_NAME(dcopy)(&pDet, REAL(alphaStarting_r), &inc, alpha, &inc);
+    double phi = REAL(phiStarting_r)[0];
+    double sigmaSq = REAL(sigmaSqStarting_r)[0];
+    double nu = REAL(nuStarting_r)[0];
+    double *sigmaSqPsi = (double *) R_alloc(pOccRE, sizeof(double));
+    F77_NAME(dcopy)(&pOccRE, REAL(sigmaSqPsiStarting_r), &inc, sigmaSqPsi, &inc);
+    double *sigmaSqP = (double *) R_alloc(pDetRE, sizeof(double));
+    F77_NAME(dcopy)(&pDetRE, REAL(sigmaSqPStarting_r), &inc, sigmaSqP, &inc);
+    double *betaStar = (double *) R_alloc(nOccRE, sizeof(double));
+    F77_NAME(dcopy)(&nOccRE, REAL(betaStarStarting_r), &inc, betaStar, &inc);
+    double *alphaStar = (double *) R_alloc(nDetRE, sizeof(double));
+    F77_NAME(dcopy)(&nDetRE, REAL(alphaStarStarting_r), &inc, alphaStar, &inc);
+    double *w = (double *) R_alloc(J, sizeof(double)); zeros(w, J);
+    double *wResid = (double *) R_alloc(J, sizeof(double));
+    // Approximate conditional variances of w and of the random effects, 
+    // used in the expected sums of squares of the variance updates.
+    double *wVar = (double *) R_alloc(J, sizeof(double)); zeros(wVar, J);
+    double *betaStarVar = (double *) R_alloc(nOccRE, sizeof(double)); zeros(betaStarVar, nOccRE);
+    double *alphaStarVar = (double *) R_alloc(nDetRE, sizeof(double)); zeros(alphaStarVar, nDetRE);
+    double *z = (double *) R_alloc(J, sizeof(double));
+
+    /**********************************************************************
+     * Prior precisions
+     * *******************************************************************/
+    F77_NAME(dpotrf)(lower, &pOcc, SigmaBetaInv, &pOcc, &info FCONE);
+    if(info != 0){error("c++ error: dpotrf SigmaBetaInv failed\n");}
+    F77_NAME(dpotri)(lower, &pOcc, SigmaBetaInv, &pOcc, &info FCONE);
+    if(info != 0){error("c++ error: dpotri SigmaBetaInv failed\n");}
+    double *SigmaBetaInvMuBeta = (double *) R_alloc(pOcc, sizeof(double));
+    F77_NAME(dsymv)(lower, &pOcc, &one, SigmaBetaInv, &pOcc, muBeta, &inc, &zero,
+        	    SigmaBetaInvMuBeta, &inc FCONE);
+    F77_NAME(dpotrf)(lower, &pDet, SigmaAlphaInv, &pDet, &info FCONE);
+    if(info != 0){error("c++ error: dpotrf SigmaAlphaInv failed\n");}
+    F77_NAME(dpotri)(lower, &pDet, SigmaAlphaInv, &pDet, &info FCONE);
+    if(info != 0){error("c++ error: dpotri SigmaAlphaInv failed\n");}
+    double *SigmaAlphaInvMuAlpha = (double *) R_alloc(pDet, sizeof(double));
+    F77_NAME(dsymv)(lower, &pDet, &one, SigmaAlphaInv, &pDet, muAlpha, &inc, &zero,
+                   SigmaAlphaInvMuAlpha, &inc FCONE);
+
+    /**********************************************************************
+     * Allocate
+     * *******************************************************************/
+    double *eta = (double *) R_alloc(J, sizeof(double));
+    double *omegaOcc = (double *) R_alloc(J, sizeof(double));
+    double *kappaOcc = (double *) R_alloc(J, sizeof(double));
+    double *omegaDet = (double *) R_alloc(nObs, sizeof(double));
+    double *kappaDet = (double *) R_alloc(nObs, sizeof(double));
+    double *detProb = (double *) R_alloc(nObs, sizeof(double));
+    double *piProd = (double *) R_alloc(J, sizeof(double));
+    double *ySum = (double *) R_alloc(J, sizeof(double));
+    double *tmp_J1 = (double *) R_alloc(J, sizeof(double));
+    double *tmp_nObs = (double *) R_alloc(nObs, sizeof(double));
+    double *tmp_JpOcc = (double *) R_alloc(J*pOcc, sizeof(double));
+    double *tmp_nObspDet = (double *) R_alloc(nObs*pDet, sizeof(double));
+    double *tmp_pOcc = (double *) R_alloc(pOcc, sizeof(double));
+    double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double));
+    double *tmp_pDet = (double *) R_alloc(pDet, sizeof(double));
+    double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
+
+    zeros(ySum, J);
+    for (i = 0; i < nObs; i++) {
+      ySum[zLongIndx[i]] += y[i];
+    }
+
+    // Random effect sums at each site and observation, as in spPGOccNNGP.
+    double *betaStarSites = (double *) R_alloc(J, sizeof(double)); zeros(betaStarSites, J);
+    int *betaStarLongIndx = (int *) R_alloc(J*pOccRE, sizeof(int));
+    for (j = 0; j < J; j++) {
+      for (l = 0; l < pOccRE; l++) {
+        betaStarLongIndx[l * J + j] = which(XRE[l * J + j], betaLevelIndx, nOccRE);
+        betaStarSites[j] += betaStar[betaStarLongIndx[l * J + j]];
+      }
+    }
+    double *alphaStarObs = (double *) R_alloc(nObs, sizeof(double)); zeros(alphaStarObs, nObs);
+    int *alphaStarLongIndx = (int *) R_alloc(nObs*pDetRE, sizeof(int));
+    for (i = 0; i < nObs; i++) {
+      for (l = 0; l < pDetRE; l++) {
+        alphaStarLongIndx[l * nObs + i] = which(XpRE[l * nObs + i], alphaLevelIndx, nDetRE);
+        alphaStarObs[i] += alphaStar[alphaStarLongIndx[l * nObs + i]];
+      }
+    }
+    double *XBeta = (double *) R_alloc(J, sizeof(double));
+    double *XpAlpha = (double *) R_alloc(nObs, sizeof(double));
+
+    // For NNGP
+    int nIndx = getNIndx(J, m);
+    double *B = (double *) R_alloc(nIndx, sizeof(double));
+    double *F = (double *) R_alloc(J, sizeof(double));
+    double *c =(double *) R_alloc(m*nThreads, sizeof(double));
+    double *C = (double *) R_alloc(m*m*nThreads, sizeof(double));
+    double *bk = (double *) R_alloc(nThreads*(1.0+static_cast<int>(floor(nuB))), sizeof(double));
+    if (!isMatern) {
+      nu = 0.0;
+    }
+    // Grid of candidate spatial decay values for the profile update.
+    int nGrid = 20;
+    double phiCand, sigmaSqCand, logDet, logPost, logPostMax, a, b, e, v, mu, aij, wNew, tr;
+    updateBFInit(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, sigmaSq, phi, nu, covModel, bk, nuB);
+
+    /**********************************************************************
+     * Start EM passes
+     * *******************************************************************/
+    for (q = 0; q < nIter; q++) {
+
+      /********************************************************************
+       *E-step for latent occupancy
+       *******************************************************************/
+      for (j = 0; j < J; j++) {
+        XBeta[j] = F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc);
+        eta[j] = XBeta[j] + w[j] + betaStarSites[j];
+	piProd[j] = one;
+      } // j
+      for (i = 0; i < nObs; i++) {
+        XpAlpha[i] = F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc);
+        detProb[i] = logitInv(XpAlpha[i] + alphaStarObs[i], zero, one);
+	if (nObs == J) {
+          piProd[zLongIndx[i]] = pow(1.0 - detProb[i], K[i]);
+	} else {
+          piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
+	}
+      } // i
+      for (j = 0; j < J; j++) {
+        if (ySum[j] == zero) {
+          e = logitInv(eta[j], zero, one) * piProd[j];
+          z[j] = e / (e + 1.0 - logitInv(eta[j], zero, one));
+	} else {
+          z[j] = one;
+	}
+      } // j
+
+      /********************************************************************
+       *Update Occupancy Regression Coefficients
+       *******************************************************************/
+      // Polya-Gamma EM: the latent PG variables are replaced by their
+      // conditional expectations and beta is set to the conditional mode.
+      for (j = 0; j < J; j++) {
+        omegaOcc[j] = pgMean(one, eta[j]);
+        kappaOcc[j] = z[j] - 1.0 / 2.0;
+        tmp_J1[j] = kappaOcc[j] - omegaOcc[j] * (w[j] + betaStarSites[j]);
+      } // j
+      if (!fixedParams[0]) {
+        F77_NAME(dgemv)(ytran, &J, &pOcc, &one, X, &J, tmp_J1, &inc, &zero, tmp_pOcc, &inc FCONE);
+        for (j = 0; j < pOcc; j++) {
+          tmp_pOcc[j] += SigmaBetaInvMuBeta[j];
+        } // j
+        for(j = 0; j < J; j++){
+          for(i = 0; i < pOcc; i++){
+            tmp_JpOcc[i*J+j] = X[i*J+j]*omegaOcc[j];
+          }
+        }
+        F77_NAME(dgemm)(ytran, ntran, &pOcc, &pOcc, &J, &one, X, &J, tmp_JpOcc, &J, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
+        for (j = 0; j < ppOcc; j++) {
+          tmp_ppOcc[j] += SigmaBetaInv[j];
+        } // j
+        F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE);
+        if(info != 0){error("c++ error: dpotrf here failed\n");}
+        F77_NAME(dpotrs)(lower, &pOcc, &inc, tmp_ppOcc, &pOcc, tmp_pOcc, &pOcc, &info FCONE);
+        if(info != 0){error("c++ error: dpotrs here failed\n");}
+        F77_NAME(dcopy)(&pOcc, tmp_pOcc, &inc, beta, &inc);
+        for (j = 0; j < J; j++) {
+          XBeta[j] = F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc);
+        } // j
+      }
+
+      /********************************************************************
+       *Update Occupancy random effects and their variances
+       *******************************************************************/
+      if (pOccRE > 0) {
+        for (l = 0; l < nOccRE; l++) {
+          a = 0.0;
+          v = 0.0;
+          for (j = 0; j < J; j++) {
+            if (XRE[betaStarIndx[l] * J + j] == betaLevelIndx[l]) {
+              a += kappaOcc[j] - (XBeta[j] + betaStarSites[j] - betaStar[l] + w[j]) * omegaOcc[j];
+              v += omegaOcc[j];
+            }
+          } // j
+          betaStarVar[l] = 1.0 / (v + 1.0 / sigmaSqPsi[betaStarIndx[l]]);
+          e = betaStarVar[l] * a - betaStar[l];
+          betaStar[l] += e;
+          for (j = 0; j < J; j++) {
+            if (XRE[betaStarIndx[l] * J + j] == betaLevelIndx[l]) {
+              betaStarSites[j] += e;
+            }
+          } // j
+        } // l
+        if (!fixedParams[4]) {
+          for (l = 0; l < pOccRE; l++) {
+            a = 0.0;
+            for (ll = 0; ll < nOccRE; ll++) {
+              if (betaStarIndx[ll] == l) {
+                a += betaStar[ll] * betaStar[ll] + betaStarVar[ll];
+              }
+            } // ll
+            sigmaSqPsi[l] = (sigmaSqPsiB[l] + 0.5 * a) / (sigmaSqPsiA[l] + nOccRELong[l] / 2.0 + 1.0);
+          } // l
+        }
+      }
+
+      /********************************************************************
+       *Update Detection Regression Coefficients
+       *******************************************************************/
+      // Observations are weighted by the expected occupancy state.
+      if (!fixedParams[1]) {
+        for (i = 0; i < nObs; i++) {
+          e = XpAlpha[i] + alphaStarObs[i];
+          if (nObs == J) {
+            omegaDet[i] = pgMean(K[i], e) * z[zLongIndx[i]];
+            kappaDet[i] = (y[i] - K[i]/2.0) * z[zLongIndx[i]];
+	  } else {
+            omegaDet[i] = pgMean(one, e) * z[zLongIndx[i]];
+            kappaDet[i] = (y[i] - 1.0/2.0) * z[zLongIndx[i]];
+	  }
+        } // i
+        for (i = 0; i < nObs; i++) {
+          tmp_nObs[i] = kappaDet[i] - omegaDet[i] * alphaStarObs[i];
+        } // i
+        F77_NAME(dgemv)(ytran, &nObs, &pDet, &one, Xp, &nObs, tmp_nObs, &inc, &zero, tmp_pDet, &inc FCONE);
+        for (j = 0; j < pDet; j++) {
+          tmp_pDet[j] += SigmaAlphaInvMuAlpha[j];
+        } // j
+        for (j = 0; j < nObs; j++) {
+          for (i = 0; i < pDet; i++) {
+            tmp_nObspDet[i*nObs + j] = Xp[i * nObs + j] * omegaDet[j];
+          } // i
+        } // j
+        F77_NAME(dgemm)(ytran, ntran, &pDet, &pDet, &nObs, &one, Xp, &nObs, tmp_nObspDet, &nObs, &zero, tmp_ppDet, &pDet FCONE FCONE);
+        for (j = 0; j < ppDet; j++) {
+          tmp_ppDet[j] += SigmaAlphaInv[j];
+        } // j
+        F77_NAME(dpotrf)(lower, &pDet, tmp_ppDet, &pDet, &info FCONE);
+        if(info != 0){error("c++ error: dpotrf A.alpha failed\n");}
+        F77_NAME(dpotrs)(lower, &pDet, &inc, tmp_ppDet, &pDet, tmp_pDet, &pDet, &info FCONE);
+        if(info != 0){error("c++ error: dpotrs A.alpha failed\n");}
+        F77_NAME(dcopy)(&pDet, tmp_pDet, &inc, alpha, &inc);
+        for (i = 0; i < nObs; i++) {
+          XpAlpha[i] = F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc);
+        } // i
+      }
+
+      /********************************************************************
+       *Update Detection random effects and their variances
+       *******************************************************************/
+      if (pDetRE > 0) {
+        for (l = 0; l < nDetRE; l++) {
+          a = 0.0;
+          v = 0.0;
+          for (i = 0; i < nObs; i++) {
+            if (XpRE[alphaStarIndx[l] * nObs + i] == alphaLevelIndx[l]) {
+              a += kappaDet[i] - (XpAlpha[i] + alphaStarObs[i] - alphaStar[l]) * omegaDet[i];
+              v += omegaDet[i];
+            }
+          } // i
+          alphaStarVar[l] = 1.0 / (v + 1.0 / sigmaSqP[alphaStarIndx[l]]);
+          e = alphaStarVar[l] * a - alphaStar[l];
+          alphaStar[l] += e;
+          for (i = 0; i < nObs; i++) {
+            if (XpRE[alphaStarIndx[l] * nObs + i] == alphaLevelIndx[l]) {
+              alphaStarObs[i] += e;
+            }
+          } // i
+        } // l
+        if (!fixedParams[5]) {
+          for (l = 0; l < pDetRE; l++) {
+            a = 0.0;
+            for (ll = 0; ll < nDetRE; ll++) {
+              if (alphaStarIndx[ll] == l) {
+                a += alphaStar[ll] * alphaStar[ll] + alphaStarVar[ll];
+              }
+            } // ll
+            sigmaSqP[l] = (sigmaSqPB[l] + 0.5 * a) / (sigmaSqPA[l] + nDetRELong[l] / 2.0 + 1.0);
+          } // l
+        }
+      }
+
+      /********************************************************************
+       *Update w (spatial random effects)
+       *******************************************************************/
+      // One Gauss-Seidel sweep towards the conditional mode.
+      mkNNResid(J, w, 1, B, 1, nnIndx, nnIndxLU, wResid);
+      for (i = 0; i < J; i++ ) {
+        a = 0;
+        v = 0;
+        for (j = 0; j < uIndxLU[J+i]; j++){
+          jj = uIndx[uIndxLU[i]+j];
+          b = B[nnIndxLU[jj]+uiIndx[uIndxLU[i]+j]];
+          aij = wResid[jj] + b*w[i];
+          a += b*aij/F[jj];
+          v += b*b/F[jj];
+        }
+        e = w[i] - wResid[i];
+        mu = kappaOcc[i] - (XBeta[i] + betaStarSites[i])*omegaOcc[i] + e/F[i] + a;
+        wVar[i] = 1.0 / (omegaOcc[i] + 1.0/F[i] + v);
+        wNew = mu * wVar[i];
+        updateNNResid(i, wNew - w[i], J, B, 1, nnIndxLU, uIndx, uIndxLU, uiIndx, wResid);
+        w[i] = wNew;
+      } // i
+
+      /********************************************************************
+       *Update phi and sigmaSq
+       *******************************************************************/
+      // Profile search: for each phi on the grid sigmaSq is set to its M-step
+      // value, which uses the expected sum of squares of w (its mode plus the
+      // diagonal approximation of its conditional variance, wVar) rather than
+      // the mode alone, so w is integrated over instead of maximized jointly
+      // with sigmaSq. The pair with the highest expected complete-data log
+      // posterior is kept.
+      if (!fixedParams[2] || !fixedParams[3]) {
+        logPostMax = R_NegInf;
+        for (l = 0; l < nGrid; l++) {
+          if (fixedParams[2]) {
+            phiCand = phi;
+	  } else {
+            phiCand = phiA + (l + 0.5) * (phiB - phiA) / nGrid;
+	  }
+          logDet = updateBFInit(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, one, phiCand, nu, covModel, bk, nuB);
+          a = 0;
+          tr = 0;
+#ifdef _OPENMP
+#pragma omp parallel for private (e, i, b, v) reduction(+:a, tr)
+#endif
+          for (j = 0; j < J; j++) {
+            e = 0;
+            v = wVar[j];
+            for (i = 0; i < nnIndxLU[J+j]; i++) {
+              b = B[nnIndxLU[j]+i];
+              e += b*w[nnIndx[nnIndxLU[j]+i]];
+              v += b*b*wVar[nnIndx[nnIndxLU[j]+i]];
+            }
+            b = w[j] - e;
+            a += b*b/F[j];
+            tr += v/F[j];
+          } // j
+          a += tr;
+          if (fixedParams[3]) {
+            sigmaSqCand = sigmaSq;
+	  } else if (sigmaSqIG) {
+            sigmaSqCand = (sigmaSqB + 0.5 * a) / (sigmaSqA + 0.5 * J + 1.0);
+	  } else {
+            sigmaSqCand = fmin2(fmax2(a / J, sigmaSqA), sigmaSqB);
+	  }
+          logPost = -0.5 * J * log(sigmaSqCand) - 0.5 * logDet - 0.5 * a / sigmaSqCand;
+          if (sigmaSqIG) {
+            logPost += -1.0 * (sigmaSqA + 1.0) * log(sigmaSqCand) - sigmaSqB / sigmaSqCand;
+	  }
+          if (logPost > logPostMax) {
+            logPostMax = logPost;
+	    phi = phiCand;
+	    sigmaSq = sigmaSqCand;
+	  }
+          if (fixedParams[2]) {
+            break;
+	  }
+        } // l
+        updateBFInit(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, sigmaSq, phi, nu, covModel, bk, nuB);
+      }
+
+      R_CheckUserInterrupt();
+    } // q
+
+    // Sites with a posterior occupancy probability above 0.5 start occupied.
+    for (j = 0; j < J; j++) {
+      z[j] = (z[j] > 0.5) ? one : zero;
+    } // j
+
+    /**********************************************************************
+     * Return
+     * *******************************************************************/
+    SEXP beta_r, alpha_r, w_r, phi_r, sigmaSq_r, z_r, betaStar_r, alphaStar_r, sigmaSqPsi_r, sigmaSqP_r;
+    PROTECT(beta_r = allocVector(REALSXP, pOcc)); nProtect++;
+    PROTECT(alpha_r = allocVector(REALSXP, pDet)); nProtect++;
+    PROTECT(w_r = allocVector(REALSXP, J)); nProtect++;
+    PROTECT(phi_r = allocVector(REALSXP, 1)); nProtect++;
+    PROTECT(sigmaSq_r = allocVector(REALSXP, 1)); nProtect++;
+    PROTECT(z_r = allocVector(REALSXP, J)); nProtect++;
+    PROTECT(betaStar_r = allocVector(REALSXP, nOccRE)); nProtect++;
+    PROTECT(alphaStar_r = allocVector(REALSXP, nDetRE)); nProtect++;
+    PROTECT(sigmaSqPsi_r = allocVector(REALSXP, pOccRE)); nProtect++;
+    PROTECT(sigmaSqP_r = allocVector(REALSXP, pDetRE)); nProtect++;
+    F77_NAME(dcopy)(&pOcc, beta, &inc, REAL(beta_r), &inc);
+    F77_NAME(dcopy)(&pDet, alpha, &inc, REAL(alpha_r), &inc);
+    F77_NAME(dcopy)(&J, w, &inc, REAL(w_r), &inc);
+    F77_NAME(dcopy)(&J, z, &inc, REAL(z_r), &inc);
+    F77_NAME(dcopy)(&nOccRE, betaStar, &inc, REAL(betaStar_r), &inc);
+    F77_NAME(dcopy)(&nDetRE, alphaStar, &inc, REAL(alphaStar_r), &inc);
+    F77_NAME(dcopy)(&pOccRE, sigmaSqPsi, &inc, REAL(sigmaSqPsi_r), &inc);
+    F77_NAME(dcopy)(&pDetRE, sigmaSqP, &inc, REAL(sigmaSqP_r), &inc);
+    REAL(phi_r)[0] = phi;
+    REAL(sigmaSq_r)[0] = sigmaSq;
+
+    SEXP result_r, resultName_r;
+    int nResultListObjs = 10;
+
+    PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+    PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
+
+    SET_VECTOR_ELT(result_r, 0, beta_r);
+    SET_VECTOR_ELT(result_r, 1, alpha_r);
+    SET_VECTOR_ELT(result_r, 2, w_r);
+    SET_VECTOR_ELT(result_r, 3, phi_r);
+    SET_VECTOR_ELT(result_r, 4, sigmaSq_r);
+    SET_VECTOR_ELT(result_r, 5, z_r);
+    SET_VECTOR_ELT(result_r, 6, betaStar_r);
+    SET_VECTOR_ELT(result_r, 7, alphaStar_r);
+    SET_VECTOR_ELT(result_r, 8, sigmaSqPsi_r);
+    SET_VECTOR_ELT(result_r, 9, sigmaSqP_r);
+
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("beta"));
+    SET_VECTOR_ELT(resultName_r, 1, mkChar("alpha"));
+    SET_VECTOR_ELT(resultName_r, 2, mkChar("w"));
+    SET_VECTOR_ELT(resultName_r, 3, mkChar("phi"));
+    SET_VECTOR_ELT(resultName_r, 4, mkChar("sigma.sq"));
+    SET_VECTOR_ELT(resultName_r, 5, mkChar("z"));
+    SET_VECTOR_ELT(resultName_r, 6, mkChar("beta.star"));
+    SET_VECTOR_ELT(resultName_r, 7, mkChar("alpha.star"));
+    SET_VECTOR_ELT(resultName_r, 8, mkChar("sigma.sq.psi"));
+    SET_VECTOR_ELT(resultName_r, 9, mkChar("sigma.sq.p"));
+
+    namesgets(result_r, resultName_r);
+
+    UNPROTECT(nProtect);
+
+    return(result_r);
+  }
+}
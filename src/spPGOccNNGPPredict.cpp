@@ -26,7 +26,8 @@ extern "C" {
 			  SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
 			  SEXP nReport_r){
 
-    int i, k, l, s, info, nProtect=0;
+    int i, k, l, info, nProtect=0;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     const double zero = 0.0;
@@ -51,6 +52,7 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
@@ -84,7 +86,7 @@ extern "C" {
     // parameters
     int nTheta, sigmaSqIndx,  phiIndx, nuIndx;
 
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; //sigma^2, phi
       sigmaSqIndx = 0; phiIndx = 1;
       } else{
@@ -96,7 +98,7 @@ extern "C" {
     double nuMax = 0;
     int nb = 0;
     
-    if(corName == "matern"){
+    if(isMatern){
       for(i = 0; i < nSamples; i++){
 	if(theta[i*nTheta+nuIndx] > nuMax){
 	  nuMax = theta[i*nTheta+nuIndx];
@@ -131,14 +133,16 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(q*nSamples, sizeof(double));
+    R_xlen_t vIndx = -1, nWV;
+    nWV = static_cast<R_xlen_t>(q)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < q*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
+    vIndx = -1;
     
     for(i = 0; i < q; i++){
 #ifdef _OPENMP
@@ -149,7 +153,7 @@ extern "C" {
 	threadID = omp_get_thread_num();
 #endif 	
 	phi = theta[s*nTheta+phiIndx];
-	if(corName == "matern"){
+	if(isMatern){
 	  nu = theta[s*nTheta+nuIndx];
 	}
 	sigmaSq = theta[s*nTheta+sigmaSqIndx];
@@ -29,7 +29,8 @@ extern "C" {
     /*****************************************
                 Common variables
     *****************************************/
-    int j, s, info, nProtect= 0;
+    int j, info, nProtect= 0;
+    R_xlen_t s;
     const char *lower = "L";
     const char *ntran = "N";
     const char *ytran = "T";
@@ -171,7 +172,7 @@ extern "C" {
       //report
       if(verbose){
 	if(status == nReport){
-	  Rprintf("Samples: %i of %i, %3.2f%%\n", s, nSamples, 100.0*s/nSamples);
+	  Rprintf("Samples: %i of %i, %3.2f%%\n", static_cast<int>(s), nSamples, 100.0*s/nSamples);
           #ifdef Win32
 	  R_FlushConsole();
           #endif
@@ -185,7 +186,7 @@ extern "C" {
      } //end sample loop
 
      if(verbose){
-       Rprintf("Samples: %i of %i, %3.2f%%\n", s, nSamples, 100.0*s/nSamples);
+       Rprintf("Samples: %i of %i, %3.2f%%\n", static_cast<int>(s), nSamples, 100.0*s/nSamples);
        #ifdef Win32
        R_FlushConsole();
        #endif
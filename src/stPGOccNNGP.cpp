@@ -83,12 +83,12 @@ extern "C" {
 		   SEXP tuning_r, SEXP covModel_r, SEXP nBatch_r, 
 	           SEXP batchLength_r, SEXP acceptRate_r, SEXP nThreads_r, SEXP verbose_r, 
 	           SEXP nReport_r, SEXP nBurn_r, SEXP nThin_r, SEXP nPost_r, 
-		   SEXP currChain_r, SEXP nChain_r, SEXP sigmaSqIG_r){
+		   SEXP currChain_r, SEXP nChain_r, SEXP sigmaSqIG_r, SEXP asis_r){
    
     /**********************************************************************
      * Initial constants
      * *******************************************************************/
-    int i, j, k, s, r, rr, ll, ii, t, info, nProtect=0, l;
+    int i, j, k, s, r, rr, ll, ii, t, jt, info, nProtect=0, l;
     int status = 0; // For AMCMC. 
     const int inc = 1;
     const double one = 1.0;
@@ -151,6 +151,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int *zYearIndx = INTEGER(zYearIndx_r); 
     int *zDatIndx = INTEGER(zDatIndx_r); 
@@ -169,7 +170,7 @@ extern "C" {
     double sigmaSqTB = REAL(ar1Vals_r)[3];
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nThin = INTEGER(nThin_r)[0]; 
     int nBurn = INTEGER(nBurn_r)[0]; 
     int nPost = INTEGER(nPost_r)[0]; 
@@ -180,11 +181,13 @@ extern "C" {
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
+    int asis = INTEGER(asis_r)[0];
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
 
     // Some constants
-    int JnYears = J * nYearsMax;
+    int JnYears = intProd(J, nYearsMax);
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -220,6 +223,9 @@ extern "C" {
        Rprintf("Source not compiled with OpenMP support.\n\n");
 #endif
        Rprintf("Adaptive Metropolis with target acceptance rate: %.1f\n", 100*acceptRate);
+       if (asis) {
+         Rprintf("Interweaving (ASIS) updates for the intercept and sigma.sq.\n");
+       }
      }
      Rprintf("----------------------------------------\n");
      Rprintf("\tChain %i\n", currChain);
@@ -264,11 +270,30 @@ extern "C" {
     // Latent Occurrence
     double *z = (double *) R_alloc(JnYears, sizeof(double));   
     F77_NAME(dcopy)(&JnYears, REAL(zStarting_r), &inc, z, &inc);
+    // Site/year combinations with data, stored in a ragged layout grouped by 
+    // site. The occurrence auxiliary variables and design matrix are only 
+    // needed for these combinations. 
+    int nDat = 0; 
+    for (j = 0; j < JnYears; j++) {
+      nDat += zDatIndx[j]; 
+    }
+    int *siteYearLU = (int *) R_alloc(2 * J, sizeof(int)); 
+    int *datYearIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    int *datCellIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    mkSiteYearIndx(J, nYearsMax, zDatIndx, siteYearLU, datYearIndx, datCellIndx); 
+    int nDatpOcc = intProd(nDat, pOcc); 
+    // X stays padded to all site/year cells and is indexed through 
+    // datCellIndx. XBetaDat holds the occurrence linear predictor of the 
+    // cells with observations for the current beta. 
+    double *XBetaDat = (double *) R_alloc(nDat, sizeof(double)); 
+    for (ii = 0; ii < nDat; ii++) {
+      XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+    }
     // PG auxiliary variables 
     double *omegaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(omegaDet, nObs);
-    double *omegaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(omegaOcc, JnYears);
+    double *omegaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(omegaOcc, nDat);
     double *kappaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(kappaDet, nObs);
-    double *kappaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(kappaOcc, JnYears);
+    double *kappaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(kappaOcc, nDat);
 
     /**********************************************************************
      * Return Stuff
@@ -309,9 +334,9 @@ extern "C" {
      * Other initial starting stuff
      * *******************************************************************/
     int JnYearspOccRE = J * nYearsMax * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
-    int jj, kk;
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
+    int jj;
     int nnYears = nYearsMax * nYearsMax;
     double tmp_0 = 0.0;
     double tmp_02;
@@ -333,10 +358,10 @@ extern "C" {
     zeros(tmp_J1, J);
     double *tmp_nObs = (double *) R_alloc(nObs, sizeof(double));
     zeros(tmp_nObs, nObs);
-    double *tmp_JnYears = (double *) R_alloc(JnYears, sizeof(double));
-    zeros(tmp_JnYears, JnYears);
-    double *tmp_JnYearspOcc = (double *) R_alloc(JnYears * pOcc, sizeof(double));
-    zeros(tmp_JnYearspOcc, JnYears * pOcc);
+    double *tmp_nDat = (double *) R_alloc(nDat, sizeof(double));
+    zeros(tmp_nDat, nDat);
+    double *tmp_nDatpOcc = (double *) R_alloc(nDatpOcc, sizeof(double));
+    zeros(tmp_nDatpOcc, nDatpOcc);
 
     // For latent occupancy
     double psiNum; 
@@ -412,7 +437,7 @@ extern "C" {
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx, sigmaSqTIndx, rhoIndx;
     if (ar1 == 1) { // AR1
-      if (corName != "matern") {
+      if (!isMatern) {
         nTheta = 4; 
         sigmaSqIndx = 0; phiIndx = 1; sigmaSqTIndx = 2; rhoIndx = 3;
       } else {
@@ -420,7 +445,7 @@ extern "C" {
         sigmaSqIndx = 0; phiIndx = 1; nuIndx = 2; sigmaSqTIndx = 3; rhoIndx = 4;
       }
     } else { // No AR1
-      if (corName != "matern") {
+      if (!isMatern) {
         nTheta = 2; 
         sigmaSqIndx = 0; phiIndx = 1;
       } else {
@@ -428,19 +453,47 @@ extern "C" {
         sigmaSqIndx = 0; phiIndx = 1; nuIndx = 2;
       }
     }
-    double a, v, b, e, mu, var, aij; 
+    double a, v, b, e, mu, var, aij, wNew; 
+    // NNGP residuals w_j - B_j w_N(j), kept current through the w sweep
+    double *wResid = (double *) R_alloc(J, sizeof(double)); 
+    // For interweaving (ASIS) updates
+    double ee, asisSigma, asisSigmaCand, logMHRatio; 
     // Initiate spatial values
     double *theta = (double *) R_alloc(nTheta, sizeof(double));
     theta[sigmaSqIndx] = sigmaSq;
     theta[phiIndx] = phi;
-    if (corName == "matern") {
+    if (isMatern) {
       theta[nuIndx] = nu; 
     } 
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale. 
+    int amD = 0, amN = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    double *amA = (double *) R_alloc(nTheta, sizeof(double)); 
+    double *amB = (double *) R_alloc(nTheta, sizeof(double)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amA[amD] = sigmaSqA; amB[amD] = sigmaSqB; amD++; 
+    }
+    amIndx[amD] = phiIndx; amA[amD] = phiA; amB[amD] = phiB; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amA[amD] = nuA; amB[amD] = nuB; amD++; 
+    }
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD, sizeof(double)); zeros(amMean, amD); 
+    double *amM2 = (double *) R_alloc(amD*amD, sizeof(double)); zeros(amM2, amD*amD); 
+    double *amChol = (double *) R_alloc(amD*amD, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (k = 0; k < amD; k++) {
+      amSD[k] = exp(tuning[amIndx[k]]); 
+    }
+    mkAMChol(amSD, amM2, amN, amD, amChol); 
     SEXP thetaSamples_r; 
     PROTECT(thetaSamples_r = allocMatrix(REALSXP, nTheta, nPost)); nProtect++; 
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP
     int mm = m*m;
@@ -453,7 +506,7 @@ extern "C" {
 
     double *bk = (double *) R_alloc(nThreads*(1.0+static_cast<int>(floor(nuB))), sizeof(double));
 
-    if (corName == "matern") {
+    if (isMatern) {
       nu = theta[nuIndx];
     }
     updateBFT(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], theta[phiIndx], nu, covModel, bk, nuB);
@@ -485,6 +538,19 @@ extern "C" {
     // For sigmaSqT sampler
     double aSigmaSqTPost = 0.5 * nYearsMax + sigmaSqTA;
     double bSigmaSqTPost = 0.0;
+    // Adaptive block Metropolis for (rho, sigmaSqT) on the (logit, log) scale. 
+    // sigmaSqT is still Gibbs updated, with the joint move following it. 
+    int arD = 2, arN = 0; 
+    double sigmaSqTCand = 0.0, detCand = 0.0, detCurr = 0.0;
+    double *arX = (double *) R_alloc(arD, sizeof(double)); 
+    double *arXCand = (double *) R_alloc(arD, sizeof(double)); 
+    double *arSD = (double *) R_alloc(arD, sizeof(double)); 
+    double *arMean = (double *) R_alloc(arD, sizeof(double)); zeros(arMean, arD); 
+    double *arM2 = (double *) R_alloc(arD*arD, sizeof(double)); zeros(arM2, arD*arD); 
+    double *arChol = (double *) R_alloc(arD*arD, sizeof(double)); 
+    arSD[0] = exp(tuning[rhoIndx]); 
+    arSD[1] = arSD[0]; 
+    mkAMChol(arSD, arM2, arN, arD, arChol); 
     double *etaTRInv = (double *) R_alloc(nYearsMax, sizeof(double));
 
     /**********************************************************************
@@ -509,80 +575,63 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
-	zeros(tmp_JnYears, JnYears);
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            // Only calculate omegaOcc when there are observations at that 
-	    // site/year combo. Otherwise, you're just wasting time. 
-	    if (zDatIndx[t * J + j] == 1) { 
-              tmp_JnYears[t * J + j] = F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, 
-	         	                      beta, &inc);
-	      omegaOcc[t * J + j] = rpg(1.0, tmp_JnYears[t * J + j] + w[j] + betaStarSites[t * J + j] + eta[t]);
-	      // Update kappa values along the way. 
-              kappaOcc[t * J + j] = z[t * J + j] - 1.0 / 2.0; 
-	    }
-	  } // j 
-	} // t
+	// Only calculate omegaOcc for site/year combos with observations. 
+	for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+	  omegaOcc[ii] = XBetaDat[ii] + w[jt % J] + betaStarSites[jt] + eta[datYearIndx[ii]];
+	  // Update kappa values along the way. 
+          kappaOcc[ii] = z[jt] - 1.0 / 2.0; 
+	} // ii
+        rpgBatch(nDat, &one, 0, omegaOcc, inc, omegaOcc, inc);
 	zeros(kappaDet, nObs);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
 	// Only need to sample locations where z[i] == 1.0; 
-	for (t = 0; t < nYearsMax; t++) {
-          for (i = 0; i < nObs; i++) {
-	    // If current observation is from the current year. 
-            if (zYearIndx[zLongIndx[i]] == t) {
-              // Reset
-	      omegaDet[i] = 0.0;
-              // If the site is occupied and data were collected at that site. 
-              if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
-                omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
-	        // Update kappa values along the way. 
-                kappaDet[i] = (y[i] - 1.0 / 2.0);
-	      }
-	    }
-          } // i
-	} // t
+        for (i = 0; i < nObs; i++) {
+          // Reset
+	  omegaDet[i] = 0.0;
+          // If the site is occupied and data were collected at that site. 
+          if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
+            omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
+	    // Update kappa values along the way. 
+            kappaDet[i] = (y[i] - 1.0 / 2.0);
+	  }
+        } // i
 
         /********************************************************************
          *Update Occupancy Regression Coefficients
          *******************************************************************/
-        zeros(tmp_JnYears, JnYears);
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              tmp_JnYears[t * J + j] = kappaOcc[t * J + j] - omegaOcc[t * J + j] * (w[j] + betaStarSites[t * J + j] + eta[t]); 
-	    }
-	  } // j
-	} // t
+        for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+          tmp_nDat[ii] = kappaOcc[ii] - omegaOcc[ii] * (w[jt % J] + betaStarSites[jt] + eta[datYearIndx[ii]]); 
+	} // ii
         /********************************
          * Compute b.beta
          *******************************/
-	// This is fine, because the elements in tmp_JnYears corresponding
-	// to unobserve site/time locations is set to 0 and not changed. 
-        F77_NAME(dgemv)(ytran, &JnYears, &pOcc, &one, X, &JnYears, 
-			tmp_JnYears, &inc, &zero, tmp_pOcc, &inc FCONE); 	 
+	// Only the site/year combos with observations contribute. 
         for (j = 0; j < pOcc; j++) {
-          tmp_pOcc[j] += SigmaBetaInvMuBeta[j]; 
+          tmp_pOcc[j] = SigmaBetaInvMuBeta[j]; 
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_pOcc[j] += X[j * JnYears + datCellIndx[ii]] * tmp_nDat[ii]; 
+          } // ii
         } // j 
 
         /********************************
          * Compute A.beta
          * *****************************/
-	// This is fine, because omegaOcc == 0 for the site/year combos
-	// that don't have any observations at them, which will cause this
-	// whole product to go to 0.  
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              for(i = 0; i < pOcc; i++){
-                tmp_JnYearspOcc[i * JnYears + t * J + j] = X[i * JnYears + t * J + j] * omegaOcc[t * J + j];
-              } // i
-	    }
-	  } // j
-	} // t
+        // Rows of X for the cells with observations, scaled by sqrt(omegaOcc), 
+        // so X' diag(omegaOcc) X is a single rank-k update (lower triangle). 
+        for (ii = 0; ii < nDat; ii++) {
+          tmp_nDat[ii] = sqrt(omegaOcc[ii]); 
+        } // ii
+        for (i = 0; i < pOcc; i++) {
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_nDatpOcc[i * nDat + ii] = X[i * JnYears + datCellIndx[ii]] * tmp_nDat[ii];
+          } // ii
+        } // i
 
-        F77_NAME(dgemm)(ytran, ntran, &pOcc, &pOcc, &JnYears, &one, X, &JnYears, tmp_JnYearspOcc, &JnYears, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
+        F77_NAME(dsyrk)(lower, ytran, &pOcc, &nDat, &one, tmp_nDatpOcc, &nDat, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
         for (j = 0; j < ppOcc; j++) {
           tmp_ppOcc[j] += SigmaBetaInv[j]; 
         } // j
@@ -596,6 +645,9 @@ extern "C" {
         F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
 	if(info != 0){error("c++ error: dpotrf A.beta2 failed\n");}
         mvrnorm(beta, tmp_pOcc2, tmp_ppOcc, pOcc);
+        for (ii = 0; ii < nDat; ii++) {
+          XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+        } // ii
 
 	/********************************************************************
          *Update Detection covariates
@@ -676,21 +728,18 @@ extern "C" {
             // Only allow information to come from when XRE == betaLevelIndx[l]. 
             // aka information only comes from the sites with any given level 
             // of a random effect. 
-	    for (t = 0; t < nYearsMax; t++) {
-              for (j = 0; j < J; j++) {
-                if (XRE[betaStarIndx[l] * JnYears + t * J + j] == betaLevelIndx[l]) {
-                  if (zDatIndx[t * J + j] == 1) {
-                    tmp_02 = 0.0;
-                    for (rr = 0; rr < pOccRE; rr++) {
-                      tmp_02 += betaStar[betaStarLongIndx[rr * JnYears + t * J + j]];
-	            } 
-                    tmp_one[0] += kappaOcc[t * J + j] - (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + 
-                    	    tmp_02 - betaStar[l] + w[j] + eta[t]) * omegaOcc[t * J + j];
-                    tmp_0 += omegaOcc[t * J + j];
-		  }
-                }
-              }
-	    }
+	    for (ii = 0; ii < nDat; ii++) {
+              jt = datCellIndx[ii];
+              if (XRE[betaStarIndx[l] * JnYears + jt] == betaLevelIndx[l]) {
+                tmp_02 = 0.0;
+                for (rr = 0; rr < pOccRE; rr++) {
+                  tmp_02 += betaStar[betaStarLongIndx[rr * JnYears + jt]];
+                } 
+                tmp_one[0] += kappaOcc[ii] - (XBetaDat[ii] + 
+                	      tmp_02 - betaStar[l] + w[jt % J] + eta[datYearIndx[ii]]) * omegaOcc[ii];
+                tmp_0 += omegaOcc[ii];
+	      }
+	    } // ii
             /********************************
              * Compute A.beta.star
              *******************************/
@@ -751,53 +800,78 @@ extern "C" {
         /********************************************************************
          *Update w (spatial random effects)
          *******************************************************************/
+	mkNNResid(J, w, 1, B, 1, nnIndx, nnIndxLU, wResid);
 	for (ii = 0; ii < J; ii++ ) {
           a = 0;
 	  v = 0;
-	  if (uIndxLU[J + ii] > 0){ // is i a neighbor for anybody
-	    for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
-	      b = 0;
-	      // now the neighbors for the jth location who has ii as a neighbor
-	      jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
-	      for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	        kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	        if(kk != ii){ //if the neighbor of jj is not ii
-	  	b += B[nnIndxLU[jj]+k]*w[kk]; //covariance between jj and kk and the random effect of kk
-	        }
-	      }
-	      aij = w[jj] - b;
-	      a += B[nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]]*aij/F[jj];
-	      v += pow(B[nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]],2)/F[jj];
-	    }
-	  }
-	  e = 0;
-	  for(j = 0; j < nnIndxLU[J+ii]; j++){
-	    e += B[nnIndxLU[ii]+j]*w[nnIndx[nnIndxLU[ii]+j]];
+	  for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
+	    jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
+	    b = B[nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]];
+	    // residual of jj given its neighbors other than ii
+	    aij = wResid[jj] + b*w[ii];
+	    a += b*aij/F[jj];
+	    v += b*b/F[jj];
 	  }
+	  e = w[ii] - wResid[ii];
+	  // Site/year combos with data at site ii. 
 	  mu = 0.0; 
-	  for (t = 0; t < nYearsMax; t++) {
-            if (zDatIndx[t * J + ii] == 1) {
-              mu += (kappaOcc[t * J + ii] / omegaOcc[t * J + ii] - F77_NAME(ddot)(&pOcc, &X[t * J + ii], &JnYears, beta, &inc) - betaStarSites[t * J + ii] - eta[t]) * omegaOcc[t * J + ii];
-	    }
-	  } // t
+	  tmp_0 = 0.0;
+	  for (jt = siteYearLU[ii]; jt < siteYearLU[ii] + siteYearLU[J + ii]; jt++) {
+            mu += (kappaOcc[jt] / omegaOcc[jt] - XBetaDat[jt] - betaStarSites[datCellIndx[jt]] - eta[datYearIndx[jt]]) * omegaOcc[jt];
+            tmp_0 += omegaOcc[jt];
+	  } // jt
 	  mu += e/F[ii] + a;
 	 
-	  tmp_0 = 0.0;
-	  for (t = 0; t < nYearsMax; t++) {
-            if (zDatIndx[t * J + ii] == 1) {
-              tmp_0 += omegaOcc[t * J + ii];
-	    }
-	  } // t
 	  var = 1.0/(tmp_0 + 1.0/F[ii] + v);
 	  
-	  w[ii] = rnorm(mu*var, sqrt(var));
+	  wNew = rnorm(mu*var, sqrt(var));
+	  updateNNResid(ii, wNew - w[ii], J, B, 1, nnIndxLU, uIndx, uIndxLU, uiIndx, wResid);
+	  w[ii] = wNew;
 	
         } // ii (site)
 
+        /********************************************************************
+         *Interweave the intercept (ASIS)
+         *******************************************************************/
+	// Redraw the intercept given the centered spatial effects w + beta[0], 
+	// which leaves the linear predictor unchanged. Uses the current B and F. 
+	if (asis) {
+	  a = 0;
+	  v = 0;
+#ifdef _OPENMP
+#pragma omp parallel for private (e, ee, ii) reduction(+:a, v)
+#endif
+          for (j = 0; j < J; j++) {
+            e = 0;
+	    ee = 0;
+	    for (ii = 0; ii < nnIndxLU[J+j]; ii++) {
+              e += B[nnIndxLU[j]+ii];
+	      ee += B[nnIndxLU[j]+ii]*(w[nnIndx[nnIndxLU[j]+ii]] + beta[0]);
+	    }
+	    a += (1.0 - e)*(w[j] + beta[0] - ee)/F[j];
+	    v += (1.0 - e)*(1.0 - e)/F[j];
+	  }
+	  // Prior for the intercept conditional on the other coefficients. 
+	  mu = SigmaBetaInv[0] * muBeta[0];
+	  for (k = 1; k < pOcc; k++) {
+            mu -= SigmaBetaInv[k] * (beta[k] - muBeta[k]); 
+	  }
+	  var = 1.0 / (SigmaBetaInv[0] + v);
+	  b = rnorm((mu + a) * var, sqrt(var)); 
+	  for (j = 0; j < J; j++) {
+            w[j] += beta[0] - b; 
+	  }
+	  for (ii = 0; ii < nDat; ii++) {
+            XBetaDat[ii] += X[datCellIndx[ii]] * (b - beta[0]); 
+	  } // ii
+	  beta[0] = b; 
+	}
+
         /********************************************************************
          *Update sigmaSq
          *******************************************************************/
         if (sigmaSqIG) {
+	  a = 0;
 #ifdef _OPENMP
 #pragma omp parallel for private (e, ii, b) reduction(+:a, logDet)
 #endif
@@ -815,12 +889,48 @@ extern "C" {
           }
 	  theta[sigmaSqIndx] = rigamma(sigmaSqA + J / 2.0, sigmaSqB + 0.5 * a * theta[sigmaSqIndx]); 
 	}
+	/******************************
+	 *Interweave sigmaSq (ASIS)
+	 *****************************/
+	// Redraw sigma given the standardized spatial effects w / sigma with an 
+	// independence proposal from the Gaussian PG-augmented likelihood, so 
+	// only the prior enters the acceptance ratio. 
+	if (asis) {
+          asisSigma = sqrt(theta[sigmaSqIndx]); 
+	  a = 0;
+	  v = 0;
+	  for (j = 0; j < J; j++) {
+            e = w[j] / asisSigma; 
+	    for (jt = siteYearLU[j]; jt < siteYearLU[j] + siteYearLU[J + j]; jt++) {
+	      a += e * (kappaOcc[jt] - omegaOcc[jt] * (XBetaDat[jt] + 
+		   betaStarSites[datCellIndx[jt]] + eta[datYearIndx[jt]])); 
+	      v += omegaOcc[jt] * e * e; 
+	    } // jt
+	  }
+	  asisSigmaCand = rnorm(a / v, sqrt(1.0 / v)); 
+	  if (asisSigmaCand > 0.0) {
+	    if (sigmaSqIG) {
+              logMHRatio = -1.0 * (2.0 * sigmaSqA + 1.0) * log(asisSigmaCand / asisSigma) - 
+	  		   sigmaSqB / (asisSigmaCand * asisSigmaCand) + sigmaSqB / theta[sigmaSqIndx]; 
+	    } else if (asisSigmaCand * asisSigmaCand > sigmaSqA && asisSigmaCand * asisSigmaCand < sigmaSqB) {
+              logMHRatio = log(asisSigmaCand / asisSigma); 
+	    } else {
+              logMHRatio = R_NegInf; 
+	    }
+	    if (runif(0.0, 1.0) <= exp(logMHRatio)) {
+              for (j = 0; j < J; j++) {
+                w[j] *= asisSigmaCand / asisSigma; 
+	      }
+	      theta[sigmaSqIndx] = asisSigmaCand * asisSigmaCand; 
+	    }
+	  }
+	}
 
         /********************************************************************
          *Update phi (and nu if matern)
          *******************************************************************/
         // Current
-        if (corName == "matern"){ 
+        if (isMatern){ 
 	  nu = theta[nuIndx];
        	}
         updateBFT(B, F, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], 
@@ -847,7 +957,7 @@ extern "C" {
       
         logPostCurr = -0.5*logDet - 0.5*a;
         logPostCurr += log(theta[phiIndx] - phiA) + log(phiB - theta[phiIndx]); 
-        if(corName == "matern"){
+        if(isMatern){
         	logPostCurr += log(theta[nuIndx] - nuA) + log(nuB - theta[nuIndx]); 
         }
 	if (sigmaSqIG == 0) {
@@ -855,14 +965,20 @@ extern "C" {
 	}
         
         // Candidate
-        phiCand = logitInv(rnorm(logit(theta[phiIndx], phiA, phiB), exp(tuning[phiIndx])), phiA, phiB);
-        if (corName == "matern"){
-      	  nuCand = logitInv(rnorm(logit(theta[nuIndx], nuA, nuB), exp(tuning[nuIndx])), nuA, nuB);
+        for (k = 0; k < amD; k++) {
+          amX[k] = logit(theta[amIndx[k]], amA[k], amB[k]); 
+        }
+        mvrnorm(amXCand, amX, amChol, amD); 
+        for (k = 0; k < amD; k++) {
+          thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[k], amB[k]); 
+        }
+        phiCand = thetaCand[phiIndx];
+        if (isMatern){
+          nuCand = thetaCand[nuIndx];
+        }
+        if (sigmaSqIG == 0) {
+          sigmaSqCand = thetaCand[sigmaSqIndx]; 
         }
-	if (sigmaSqIG == 0) {
-	  sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx], sigmaSqA, sigmaSqB), 
-				 exp(tuning[sigmaSqIndx])), sigmaSqA, sigmaSqB); 
-	}
 	if (sigmaSqIG) { 
           updateBFT(BCand, FCand, c, C, coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx], phiCand, nuCand, covModel, bk, nuB);
 	} else {
@@ -891,7 +1007,7 @@ extern "C" {
         
         logPostCand = -0.5*logDet - 0.5*a;      
         logPostCand += log(phiCand - phiA) + log(phiB - phiCand); 
-        if (corName == "matern"){
+        if (isMatern){
           logPostCand += log(nuCand - nuA) + log(nuB - nuCand); 
         }
 	if (sigmaSqIG == 0) {
@@ -904,7 +1020,7 @@ extern "C" {
           std::swap(FCand, F);
           theta[phiIndx] = phiCand;
           accept[phiIndx]++;
-          if(corName == "matern"){
+          if(isMatern){
             theta[nuIndx] = nuCand; 
             accept[nuIndx]++; 
           }
@@ -912,7 +1028,10 @@ extern "C" {
             theta[sigmaSqIndx] = sigmaSqCand;
 	    accept[sigmaSqIndx]++;
 	  }
+          F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
         }
+        updateAM(amX, amMean, amM2, amN, amD); 
+        amN++; 
 	if (ar1) {
           /********************************************************************
            *Update sigmaSqT
@@ -936,62 +1055,72 @@ extern "C" {
 	  theta[sigmaSqTIndx] = rigamma(aSigmaSqTPost, bSigmaSqTPost);
           
           /********************************************************************
-           *Update rho
+           *Update rho and sigmaSqT
            *******************************************************************/
 	  rho = theta[rhoIndx];
 	  sigmaSqT = theta[sigmaSqTIndx];
-	  rhoCand = logitInv(rnorm(logit(rho, rhoA, rhoB), exp(tuning[rhoIndx])), rhoA, rhoB); 
-	  theta[rhoIndx] = rhoCand; 
+	  arX[0] = logit(rho, rhoA, rhoB); 
+	  arX[1] = log(sigmaSqT); 
+	  mvrnorm(arXCand, arX, arChol, arD); 
+	  rhoCand = logitInv(arXCand[0], rhoA, rhoB); 
+	  sigmaSqTCand = exp(arXCand[1]); 
 
 	  // Construct proposal covariance matrix. 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEtaCand);
+          AR1(nYearsMax, rhoCand, sigmaSqTCand, SigmaEtaCand);
 	  clearUT(SigmaEtaCand, nYearsMax);
 
           /********************************
            * Proposal
            *******************************/
 	  // Invert SigmaEtaCand and log det cov. 
-          logPostCand = 0.0;
+          detCand = 0.0;
 	  F77_NAME(dpotrf)(lower, &nYearsMax, SigmaEtaCand, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky failed in proposal covariance matrix\n");}
 	  // Get log of the determinant of the covariance matrix. 
 	  for (k = 0; k < nYearsMax; k++) {
-	    logPostCand += 2.0 * log(SigmaEtaCand[k*nYearsMax+k]);
+	    detCand += 2.0 * log(SigmaEtaCand[k*nYearsMax+k]);
 	  } // k
 	  F77_NAME(dpotri)(lower, &nYearsMax, SigmaEtaCand, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky inverse failed in proposal covariance matrix\n");}
           logPostCand = 0.0; 
 	  // Jacobian and Uniform prior. 
 	  logPostCand += log(rhoCand - rhoA) + log(rhoB - rhoCand); 
+	  // Jacobian and IG prior. 
+	  logPostCand += -1.0 * sigmaSqTA * log(sigmaSqTCand) - sigmaSqTB / sigmaSqTCand; 
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one,  SigmaEtaCand, &nYearsMax, eta, &inc, &zero, tmp_nYearsMax, &inc FCONE);
-	  logPostCand += -0.5*logPostCand-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
+	  logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
           /********************************
            * Current
            *******************************/
-	  theta[rhoIndx] = rho; 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEta);
+          AR1(nYearsMax, rho, sigmaSqT, SigmaEta);
 	  clearUT(SigmaEta, nYearsMax);
-          logPostCurr = 0.0;
+          detCurr = 0.0;
 	  F77_NAME(dpotrf)(lower, &nYearsMax, SigmaEta, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky failed in covariance matrix\n");}
 	  for (k = 0; k < nYearsMax; k++) {
-	    logPostCurr += 2.0 * log(SigmaEta[k*nYearsMax+k]);
+	    detCurr += 2.0 * log(SigmaEta[k*nYearsMax+k]);
 	  } // k
 	  F77_NAME(dpotri)(lower, &nYearsMax, SigmaEta, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky inverse failed in covariance matrix\n");}
           logPostCurr = 0.0; 
 	  logPostCurr += log(rho - rhoA) + log(rhoB - rho); 
+	  logPostCurr += -1.0 * sigmaSqTA * log(sigmaSqT) - sigmaSqTB / sigmaSqT; 
 	  // (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one, SigmaEta, &nYearsMax, eta, &inc, &zero, 
 	  		tmp_nYearsMax, &inc FCONE);
-	  logPostCurr += -0.5*logPostCurr-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
+	  logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
 
 	  // MH Accept/Reject
 	  if (runif(0.0, 1.0) <= exp(logPostCand - logPostCurr)) {
             theta[rhoIndx] = rhoCand;
+            theta[sigmaSqTIndx] = sigmaSqTCand;
             accept[rhoIndx]++;
 	    F77_NAME(dcopy)(&nnYears, SigmaEtaCand, &inc, SigmaEta, &inc); 
+	    F77_NAME(dcopy)(&arD, arXCand, &inc, arX, &inc); 
           }
+          updateAM(arX, arMean, arM2, arN, arD); 
+          arN++; 
+          
           /********************************************************************
            *Update eta 
            *******************************************************************/
@@ -999,25 +1128,19 @@ extern "C" {
            * Compute b.w
            *******************************/
 	  zeros(tmp_nYearsMax, nYearsMax);
-          for (j = 0; j < J; j++) {
-            for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nYearsMax[t] += kappaOcc[t * J + j] - omegaOcc[t * J + j] * (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + betaStarSites[t * J + j] + w[j]);
-	      }
-	    }
-          }
+          for (ii = 0; ii < nDat; ii++) {
+            jt = datCellIndx[ii];
+            tmp_nYearsMax[datYearIndx[ii]] += kappaOcc[ii] - omegaOcc[ii] * (XBetaDat[ii] + betaStarSites[jt] + w[jt % J]);
+          } // ii
           /********************************
            * Compute A.w
            *******************************/
 	  // Copy inverse covariance matrix into tmp_JJ
 	  F77_NAME(dcopy)(&nnYears, SigmaEta, &inc, tmp_nnYears, &inc); 
-          for (j = 0; j < J; j++) {
-	    for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nnYears[t * nYearsMax + t] += omegaOcc[t * J + j];
-	      }
-	    } // t
-	  } // j
+          for (ii = 0; ii < nDat; ii++) {
+            t = datYearIndx[ii];
+            tmp_nnYears[t * nYearsMax + t] += omegaOcc[ii];
+          } // ii
 
           // Cholesky of A.eta
           F77_NAME(dpotrf)(lower, &nYearsMax, tmp_nnYears, &nYearsMax, &info FCONE); 
@@ -1034,6 +1157,8 @@ extern "C" {
           mvrnorm(eta, tmp_nYearsMax2, tmp_nnYears, nYearsMax);
 	}
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (ll >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -1048,8 +1173,10 @@ extern "C" {
 				         zero, one); 
           }
           piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  if (saveIter) {
+	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  }
           ySum[zLongIndx[i]] += y[i]; 	
           tmp_JnYearsInt[zLongIndx[i]]++;
         } // i
@@ -1061,10 +1188,14 @@ extern "C" {
 	    if (zDatIndx[t * J + j] == 1) {
               if (ySum[t * J + j] == zero) {
                 z[t * J + j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[t * J + j])));
-	        yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];	
+		if (saveIter) {
+		  yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               } else {
                 z[t * J + j] = one; 
-                yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		if (saveIter) {
+		  yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               }
 	    } else {
               psi[t * J + j] = logitInv(F77_NAME(ddot)(&pOcc, &X[t * J + j], 
@@ -1129,6 +1260,17 @@ extern "C" {
           }
         accept[k] = 0;
       }
+      for (k = 0; k < amD; k++) {
+        amSD[k] = exp(tuning[amIndx[k]]); 
+      }
+      mkAMChol(amSD, amM2, amN, amD, amChol); 
+      if (ar1) {
+        arSD[0] = exp(tuning[rhoIndx]); 
+        if (arN > 1) {
+          arSD[1] = 2.38 / sqrt(2.0) * sqrt(arM2[3] / (arN - 1.0)); 
+        }
+        mkAMChol(arSD, arM2, arN, arD, arChol); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -1137,7 +1279,7 @@ extern "C" {
 	  Rprintf("Batch: %i of %i, %3.2f%%\n", s, nBatch, 100.0*s/nBatch);
 	  Rprintf("\tParameter\tAcceptance\tTuning\n");	  
 	  Rprintf("\tphi\t\t%3.1f\t\t%1.5f\n", 100.0*accept2[phiIndx], exp(tuning[phiIndx]));
-	  if (corName == "matern") {
+	  if (isMatern) {
 	    Rprintf("\tnu\t\t%3.1f\t\t%1.5f\n", 100.0*accept2[nuIndx], exp(tuning[nuIndx]));
 	  }
 	  if (sigmaSqIG == 0) {
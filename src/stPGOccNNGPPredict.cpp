@@ -1,5 +1,6 @@
 #define USE_FC_LEN_T
 #include <string>
+#include <algorithm>
 #include "util.h"
 
 #ifdef _OPENMP
@@ -24,13 +25,15 @@ extern "C" {
 			  SEXP thetaSamples_r, SEXP wSamples_r, 
 			  SEXP betaStarSiteSamples_r, SEXP etaSamples_r, SEXP nSamples_r, 
 			  SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
-			  SEXP nReport_r){
+			  SEXP nReport_r, SEXP summaryOnly_r){
 
-    int i, k, l, s, t, info, nProtect=0;
+    int i, k, l, t, r, info, nProtect=0;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     const double zero = 0.0;
     char const *lower = "L";
+    char const *ntran = "N";
     
     double *coords = REAL(coords_r);
     int J = INTEGER(J_r)[0];
@@ -42,7 +45,7 @@ extern "C" {
     int q = INTEGER(q_r)[0];
     int m = INTEGER(m_r)[0]; 
     int mm = m * m; 
-    int qnYears = q * nYears;
+    int qnYears = intProd(q, nYears);
 
     int *nnIndx0 = INTEGER(nnIndx0_r);        
     double *beta = REAL(betaSamples_r);
@@ -54,9 +57,11 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
+    int summaryOnly = INTEGER(summaryOnly_r)[0];
     
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -87,7 +92,7 @@ extern "C" {
     // parameters
     int nTheta, sigmaSqIndx,  phiIndx, nuIndx;
 
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; //sigma^2, phi
       sigmaSqIndx = 0; phiIndx = 1;
       } else{
@@ -99,7 +104,7 @@ extern "C" {
     double nuMax = 0;
     int nb = 0;
     
-    if(corName == "matern"){
+    if(isMatern){
       for(i = 0; i < nSamples; i++){
 	if(theta[i*nTheta+nuIndx] > nuMax){
 	  nuMax = theta[i*nTheta+nuIndx];
@@ -117,13 +122,27 @@ extern "C" {
     double phi = 0, nu = 0, sigmaSq = 0, d;
     int threadID = 0, status = 0;
 
-    SEXP z0_r, w0_r, psi0_r;
-    PROTECT(z0_r = allocMatrix(REALSXP, qnYears, nSamples)); nProtect++; 
-    PROTECT(psi0_r = allocMatrix(REALSXP, qnYears, nSamples)); nProtect++; 
+    SEXP z0_r = R_NilValue, w0_r, psi0_r;
     PROTECT(w0_r = allocMatrix(REALSXP, q, nSamples)); nProtect++;
-    double *z0 = REAL(z0_r);
-    double *psi0 = REAL(psi0_r); 
     double *w0 = REAL(w0_r);
+    double *z0 = NULL, *psi0 = NULL;
+    // With summaryOnly, the columns of psi0_r are the posterior mean and SD 
+    // of psi and the posterior mean of z at each site/year.
+    SEXP psiYear_r = R_NilValue, zYear_r = R_NilValue;
+    double *psiYear = NULL, *zYear = NULL;
+    if (summaryOnly) {
+      PROTECT(psi0_r = allocMatrix(REALSXP, qnYears, 3)); nProtect++; 
+      PROTECT(psiYear_r = allocMatrix(REALSXP, nYears, nSamples)); nProtect++; 
+      PROTECT(zYear_r = allocMatrix(REALSXP, nYears, nSamples)); nProtect++; 
+      psiYear = REAL(psiYear_r);
+      zYear = REAL(zYear_r);
+      zeros(REAL(psi0_r), 3 * qnYears);
+    } else {
+      PROTECT(z0_r = allocMatrix(REALSXP, qnYears, nSamples)); nProtect++; 
+      PROTECT(psi0_r = allocMatrix(REALSXP, qnYears, nSamples)); nProtect++; 
+      z0 = REAL(z0_r);
+      psi0 = REAL(psi0_r); 
+    }
  
     if (verbose) {
       Rprintf("-------------------------------------------------\n");
@@ -134,13 +153,14 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(q*nSamples, sizeof(double));
+    R_xlen_t vIndx, nWV;
+    nWV = static_cast<R_xlen_t>(q)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < q*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
     
     for(i = 0; i < q; i++){
@@ -152,7 +172,7 @@ extern "C" {
 	threadID = omp_get_thread_num();
 #endif 	
 	phi = theta[s*nTheta+phiIndx];
-	if(corName == "matern"){
+	if(isMatern){
 	  nu = theta[s*nTheta+nuIndx];
 	}
 	sigmaSq = theta[s*nTheta+sigmaSqIndx];
@@ -178,12 +198,7 @@ extern "C" {
 	  d += tmp_m[threadID*m+k]*w[s*J+nnIndx0[i+q*k]];
 	}
 
-	#ifdef _OPENMP
-        #pragma omp atomic
-        #endif   
-	vIndx++;
-	
-	w0[s*q+i] = sqrt(sigmaSq - F77_NAME(ddot)(&m, &tmp_m[threadID*m], &inc, &c[threadID*m], &inc))*wV[vIndx] + d;
+	w0[s*q+i] = sqrt(sigmaSq - F77_NAME(ddot)(&m, &tmp_m[threadID*m], &inc, &c[threadID*m], &inc))*wV[static_cast<R_xlen_t>(i)*nSamples+s] + d;
 
       }
       
@@ -207,38 +222,130 @@ extern "C" {
       #endif
     }
 
-    // Generate latent occurrence state after the fact.
-    // Temporary fix. Will embed this in the above loop at some point.
+    // Occurrence probabilities and latent states, one block of samples at a 
+    // time. The fixed effects of every site/year in the block are a single 
+    // GEMM of X0 (qnYears x pOcc) with the block's beta samples; the spatial, 
+    // site, and year effects, the inverse logit, and the draws of z are then 
+    // done in parallel over site/years, with one RNG stream per thread. With 
+    // summaryOnly the block is kept in a buffer and only the running site/year 
+    // moments and the per-year sums over sites of each sample are kept.
     if (verbose) {
       Rprintf("Generating latent occupancy state\n");
     }
-    for(i = 0; i < q; i++){
-      for (t = 0; t < nYears; t++) {
-        for(s = 0; s < nSamples; s++){
-          psi0[s * qnYears + t * q + i] = logitInv(F77_NAME(ddot)(&pOcc, &X0[t * q + i], &qnYears, &beta[s*pOcc], &inc) + w0[s * q + i] + betaStarSite[s * qnYears + t * q + i] + eta[s * nYears + t], zero, one);
-          z0[s * qnYears + t * q + i] = rbinom(one, psi0[s * qnYears + t * q + i]);
-        } // s
-      } // t
-    } // i
+    int sBlock = 64;
+    if (summaryOnly && qnYears > 0) {
+      sBlock = std::max(1, std::min(sBlock, 4194304 / qnYears));
+    }
+    int nBlock;
+    R_xlen_t s0;
+    double *psiBlock = NULL, *yearBlock = NULL;
+    double *psiMean = NULL, *psiSS = NULL, *zMean = NULL;
+    if (summaryOnly) {
+      psiBlock = (double *) R_alloc(static_cast<R_xlen_t>(qnYears) * sBlock, sizeof(double));
+      yearBlock = (double *) R_alloc(static_cast<R_xlen_t>(nThreads) * 2 * nYears * sBlock, sizeof(double));
+      psiMean = REAL(psi0_r);
+      psiSS = &psiMean[qnYears];
+      zMean = &psiMean[2 * qnYears];
+    }
+    unsigned long long *rngState = (unsigned long long *) R_alloc(nThreads, sizeof(unsigned long long));
+    if (nThreads > 1) {
+      seedThreadRNG(rngState, nThreads);
+    }
+
+    for (s0 = 0; s0 < nSamples; s0 += sBlock) {
+      nBlock = static_cast<int>(std::min(static_cast<R_xlen_t>(sBlock), nSamples - s0));
+      double *P = summaryOnly ? psiBlock : &psi0[s0 * qnYears];
+      F77_NAME(dgemm)(ntran, ntran, &qnYears, &nBlock, &pOcc, &one, X0, &qnYears, 
+		      &beta[s0 * pOcc], &pOcc, &zero, P, &qnYears FCONE FCONE);
+      if (summaryOnly) {
+        zeros(yearBlock, nThreads * 2 * nYears * sBlock);
+      }
+#ifdef _OPENMP
+#pragma omp parallel for private(i, t, s, threadID)
+#endif
+      for (r = 0; r < qnYears; r++) {
+#ifdef _OPENMP
+	threadID = omp_get_thread_num();
+#endif
+	i = r % q;
+	t = r / q;
+	double psi, u, z, dlt;
+	double *yb = summaryOnly ? &yearBlock[threadID * 2 * nYears * sBlock] : NULL;
+	for (s = 0; s < nBlock; s++) {
+	  psi = logitInv(P[s * qnYears + r] + w0[(s0 + s) * q + i] + 
+			 betaStarSite[(s0 + s) * qnYears + r] + 
+			 eta[(s0 + s) * nYears + t], zero, one);
+	  if (nThreads > 1) {
+	    u = unifThread(&rngState[threadID]);
+	  } else {
+	    u = unif_rand();
+	  }
+	  z = u < psi ? one : zero;
+	  if (summaryOnly) {
+	    // Welford update of the site/year moments.
+	    dlt = psi - psiMean[r];
+	    psiMean[r] += dlt / (s0 + s + 1);
+	    psiSS[r] += dlt * (psi - psiMean[r]);
+	    zMean[r] += z;
+	    yb[2 * (s * nYears + t)] += psi;
+	    yb[2 * (s * nYears + t) + 1] += z;
+	  } else {
+	    P[s * qnYears + r] = psi;
+	    z0[(s0 + s) * qnYears + r] = z;
+	  }
+	} // s
+      } // r
+      if (summaryOnly) {
+        for (s = 0; s < nBlock; s++) {
+          for (t = 0; t < nYears; t++) {
+	    psiYear[(s0 + s) * nYears + t] = 0.0;
+	    zYear[(s0 + s) * nYears + t] = 0.0;
+	    for (k = 0; k < nThreads; k++) {
+	      psiYear[(s0 + s) * nYears + t] += yearBlock[k * 2 * nYears * sBlock + 2 * (s * nYears + t)];
+	      zYear[(s0 + s) * nYears + t] += yearBlock[k * 2 * nYears * sBlock + 2 * (s * nYears + t) + 1];
+	    }
+	  }
+	}
+      }
+      R_CheckUserInterrupt();
+    } // s0
+
+    if (summaryOnly) {
+      for (r = 0; r < qnYears; r++) {
+        psiSS[r] = nSamples > 1 ? sqrt(psiSS[r] / (nSamples - 1)) : NA_REAL;
+        zMean[r] /= nSamples;
+      }
+    }
 
     PutRNGstate();
     
 
     //make return object
     SEXP result_r, resultName_r;
-    int nResultListObjs = 3;
+    int nResultListObjs = summaryOnly ? 4 : 3;
 
     PROTECT(result_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
     PROTECT(resultName_r = allocVector(VECSXP, nResultListObjs)); nProtect++;
 
-    SET_VECTOR_ELT(result_r, 0, z0_r);
-    SET_VECTOR_ELT(resultName_r, 0, mkChar("z.0.samples")); 
-    
-    SET_VECTOR_ELT(result_r, 1, w0_r);
-    SET_VECTOR_ELT(resultName_r, 1, mkChar("w.0.samples"));
+    SET_VECTOR_ELT(result_r, 0, w0_r);
+    SET_VECTOR_ELT(resultName_r, 0, mkChar("w.0.samples"));
+
+    if (summaryOnly) {
+      SET_VECTOR_ELT(result_r, 1, psi0_r);
+      SET_VECTOR_ELT(resultName_r, 1, mkChar("psi.0.summary")); 
 
-    SET_VECTOR_ELT(result_r, 2, psi0_r);
-    SET_VECTOR_ELT(resultName_r, 2, mkChar("psi.0.samples")); 
+      SET_VECTOR_ELT(result_r, 2, psiYear_r);
+      SET_VECTOR_ELT(resultName_r, 2, mkChar("psi.0.year.sum")); 
+
+      SET_VECTOR_ELT(result_r, 3, zYear_r);
+      SET_VECTOR_ELT(resultName_r, 3, mkChar("z.0.year.sum")); 
+    } else {
+      SET_VECTOR_ELT(result_r, 1, z0_r);
+      SET_VECTOR_ELT(resultName_r, 1, mkChar("z.0.samples")); 
+
+      SET_VECTOR_ELT(result_r, 2, psi0_r);
+      SET_VECTOR_ELT(resultName_r, 2, mkChar("psi.0.samples")); 
+    }
 
     namesgets(result_r, resultName_r);
     
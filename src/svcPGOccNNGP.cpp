@@ -117,7 +117,7 @@ extern "C" {
     int ppDet = pDet * pDet;
     int ppOcc = pOcc * pOcc; 
     int ppTilde = pTilde * pTilde;
-    int JpTilde = J * pTilde;
+    int JpTilde = intProd(J, pTilde);
     // Priors
     double *muBeta = (double *) R_alloc(pOcc, sizeof(double));   
     F77_NAME(dcopy)(&pOcc, REAL(muBeta_r), &inc, muBeta, &inc);
@@ -148,6 +148,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     double *K = REAL(K_r); 
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int *alphaStarIndx = INTEGER(alphaStarIndx_r); 
@@ -156,7 +157,7 @@ extern "C" {
     int *betaLevelIndx = INTEGER(betaLevelIndx_r);
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nBurn = INTEGER(samplesInfo_r)[0]; 
     int nThin = INTEGER(samplesInfo_r)[1];
     int nPost = INTEGER(samplesInfo_r)[2]; 
@@ -169,7 +170,8 @@ extern "C" {
     int *fixedParams = INTEGER(fixedParams_r);
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -287,12 +289,11 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int JJ = J * J; 
-    int JpOccRE = J * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
-    int jj, kk;
+    int JpOcc = intProd(J, pOcc); 
+    int JpOccRE = intProd(J, pOccRE); 
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
+    int jj;
     double tmp_0, tmp_02; 
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
     double *tmp_ppOcc = (double *) R_alloc(ppOcc, sizeof(double)); 
@@ -382,7 +383,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -407,18 +408,57 @@ extern "C" {
     double *mu = (double *) R_alloc(pTilde, sizeof(double));
     double *var = (double *) R_alloc(ppTilde, sizeof(double)); zeros(var, ppTilde);
     double *ff = (double *) R_alloc(pTilde, sizeof(double));
+    // NNGP residuals w_j - B_j w_N(j) of each process, kept current through the w sweep
+    double *wResid = (double *) R_alloc(JpTilde, sizeof(double));
+    double *wNew = (double *) R_alloc(pTilde, sizeof(double));
     double *gg = (double *) R_alloc(pTilde, sizeof(double));
     // Initiate spatial values
     for (i = 0; i < pTilde; i++) {
       theta[sigmaSqIndx * pTilde + i] = sigmaSq[i]; 
       theta[phiIndx * pTilde + i] = phi[i]; 
-      if (corName == "matern") {
+      if (isMatern) {
         theta[nuIndx * pTilde + i] = nu[i]; 
       } 
     } // i
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale, one block per spatially-varying coefficient. 
+    int amD = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amD++; 
+    }
+    amIndx[amD] = phiIndx; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amD++; 
+    }
+    int amDD = amD * amD; 
+    int *amN = (int *) R_alloc(pTilde, sizeof(int)); 
+    double *amA = (double *) R_alloc(amD * pTilde, sizeof(double)); 
+    double *amB = (double *) R_alloc(amD * pTilde, sizeof(double)); 
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD * pTilde, sizeof(double)); zeros(amMean, amD * pTilde); 
+    double *amM2 = (double *) R_alloc(amDD * pTilde, sizeof(double)); zeros(amM2, amDD * pTilde); 
+    double *amChol = (double *) R_alloc(amDD * pTilde, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (ll = 0; ll < pTilde; ll++) {
+      amN[ll] = 0; 
+      for (k = 0; k < amD; k++) {
+        if (amIndx[k] == sigmaSqIndx) {
+          amA[ll * amD + k] = sigmaSqA[ll]; amB[ll * amD + k] = sigmaSqB[ll]; 
+        } else if (amIndx[k] == phiIndx) {
+          amA[ll * amD + k] = phiA[ll]; amB[ll * amD + k] = phiB[ll]; 
+        } else {
+          amA[ll * amD + k] = nuA[ll]; amB[ll * amD + k] = nuB[ll]; 
+        }
+        amSD[k] = exp(tuning[amIndx[k] * pTilde + ll]); 
+      }
+      mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+    }
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP
     int mm = m*m;
@@ -455,9 +495,12 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
+        // Linear predictors for all sites, then the PG draws in one batch. 
+        F77_NAME(dgemv)(ntran, &J, &pOcc, &one, X, &J, beta, &inc, &zero, omegaOcc, &inc FCONE);
         for (j = 0; j < J; j++) {
-          omegaOcc[j] = rpg(1.0, F77_NAME(ddot)(&pOcc, &X[j], &J, beta, &inc) + wSites[j] + betaStarSites[j]);
+          omegaOcc[j] += wSites[j] + betaStarSites[j];
         } // j
+        rpgBatch(J, &one, 0, omegaOcc, inc, omegaOcc, inc);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
@@ -677,6 +720,9 @@ extern "C" {
 	//       	&bk[ll * sizeBK], nuB[ll]);
         // }
 
+	for (ll = 0; ll < pTilde; ll++) {
+	  mkNNResid(J, &w[ll], pTilde, &B[ll * nIndx], 1, nnIndx, nnIndxLU, &wResid[ll * J]);
+	} // ll
 	for (ii = 0; ii < J; ii++) {
 
           for (ll = 0; ll < pTilde; ll++) { // row
@@ -691,27 +737,16 @@ extern "C" {
             a[ll] = 0; 
 	    v[ll] = 0; 
 
-	    if (uIndxLU[J + ii] > 0){ // is ii a neighbor for anybody
-	      for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
-	        b = 0;
-	        // now the neighbors for the jth location who has ii as a neighbor
-	        jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
-	        for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	          kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	          if(kk != ii){ //if the neighbor of jj is not ii
-	    	    b += B[ll*nIndx + nnIndxLU[jj]+k]*w[kk * pTilde + ll]; //covariance between jj and kk and the random effect of kk
-	          }
-	        } // k
-	        aij = w[jj * pTilde + ll] - b;
-	        a[ll] += B[ll*nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]]*aij/F[ll*J + jj];
-	        v[ll] += pow(B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]],2)/F[ll * J + jj];
-	      } // j
-	    }
+	    for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
+	      jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
+	      b = B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]];
+	      // residual of jj given its neighbors other than ii
+	      aij = wResid[ll * J + jj] + b*w[ii * pTilde + ll];
+	      a[ll] += b*aij/F[ll * J + jj];
+	      v[ll] += b*b/F[ll * J + jj];
+	    } // j
 	    
-	    e = 0;
-	    for(j = 0; j < nnIndxLU[J+ii]; j++){
-	      e += B[ll * nIndx + nnIndxLU[ii]+j]*w[nnIndx[nnIndxLU[ii]+j] * pTilde + ll];
-	    }
+	    e = w[ii * pTilde + ll] - wResid[ll * J + ii];
 
 	    ff[ll] = 1.0 / F[ll * J + ii];
 	    gg[ll] = e / F[ll * J + ii];
@@ -737,7 +772,11 @@ extern "C" {
 	  F77_NAME(dpotrf)(lower, &pTilde, var, &pTilde, &info FCONE); 
           if(info != 0){error("c++ error: dpotrf var 2 failed\n");}
 
-	  mvrnorm(&w[ii * pTilde], tmp_pTilde, var, pTilde);
+	  mvrnorm(wNew, tmp_pTilde, var, pTilde);
+	  for (ll = 0; ll < pTilde; ll++) {
+	    updateNNResid(ii, wNew[ll] - w[ii * pTilde + ll], J, &B[ll * nIndx], 1, nnIndxLU, uIndx, uIndxLU, uiIndx, &wResid[ll * J]);
+	    w[ii * pTilde + ll] = wNew[ll];
+	  } // ll
 
         } // ii
 	
@@ -788,7 +827,7 @@ extern "C" {
            *****************************************************************/
           // Current
 	  if (!fixedParams[2] || !fixedParams[3]) {
-            if (corName == "matern"){ 
+            if (isMatern){ 
 	      nu[ll] = theta[nuIndx * pTilde + ll];
        	    }
             updateBFSVC(&B[ll * nIndx], &F[ll*J], &c[ll * m*nThreads], &C[ll * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * pTilde + ll], theta[phiIndx * pTilde + ll], nu[ll], covModel, &bk[ll * sizeBK], nuB[ll]);
@@ -816,7 +855,7 @@ extern "C" {
       
             logPostCurr = -0.5 * logDet - 0.5 * aa;
             logPostCurr += log(theta[phiIndx * pTilde + ll] - phiA[ll]) + log(phiB[ll] - theta[phiIndx * pTilde + ll]); 
-            if(corName == "matern"){
+            if(isMatern){
        	      logPostCurr += log(theta[nuIndx * pTilde + ll] - nuA[ll]) + log(nuB[ll] - theta[nuIndx * pTilde + ll]); 
             }
 	    if (sigmaSqIG == 0) {
@@ -825,13 +864,19 @@ extern "C" {
 	    }
             
             // Candidate
-            phiCand = logitInv(rnorm(logit(theta[phiIndx * pTilde + ll], phiA[ll], phiB[ll]), exp(tuning[phiIndx * pTilde + ll])), phiA[ll], phiB[ll]);
-            if (corName == "matern"){
-      	      nuCand = logitInv(rnorm(logit(theta[nuIndx * pTilde + ll], nuA[ll], nuB[ll]), exp(tuning[nuIndx * pTilde + ll])), nuA[ll], nuB[ll]);
+            for (k = 0; k < amD; k++) {
+              amX[k] = logit(theta[amIndx[k] * pTilde + ll], amA[ll * amD + k], amB[ll * amD + k]); 
+            }
+            mvrnorm(amXCand, amX, &amChol[ll * amDD], amD); 
+            for (k = 0; k < amD; k++) {
+              thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[ll * amD + k], amB[ll * amD + k]); 
+            }
+            phiCand = thetaCand[phiIndx];
+            if (isMatern){
+              nuCand = thetaCand[nuIndx];
             }
 	  if (sigmaSqIG == 0) {
-            sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx * pTilde + ll], sigmaSqA[ll], sigmaSqB[ll]),
-				         exp(tuning[sigmaSqIndx * pTilde + ll])), sigmaSqA[ll], sigmaSqB[ll]);
+	    sigmaSqCand = thetaCand[sigmaSqIndx]; 
 	  }
      
 	  if (sigmaSqIG) { 
@@ -862,7 +907,7 @@ extern "C" {
             
             logPostCand = -0.5*logDet - 0.5*aa;      
             logPostCand += log(phiCand - phiA[ll]) + log(phiB[ll] - phiCand); 
-            if (corName == "matern"){
+            if (isMatern){
               logPostCand += log(nuCand - nuA[ll]) + log(nuB[ll] - nuCand); 
             }
 	    if (sigmaSqIG == 0) {
@@ -876,7 +921,7 @@ extern "C" {
               
 	      theta[phiIndx * pTilde + ll] = phiCand;
               accept[phiIndx * pTilde + ll]++;
-              if (corName == "matern") {
+              if (isMatern) {
                 nu[ll] = nuCand; 
 	        theta[nuIndx * pTilde + ll] = nu[ll]; 
                 accept[nuIndx * pTilde + ll]++; 
@@ -885,10 +930,15 @@ extern "C" {
                 theta[sigmaSqIndx * pTilde + ll] = sigmaSqCand;
 	        accept[sigmaSqIndx * pTilde + ll]++;
 	      }
+              F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
             }
+            updateAM(amX, &amMean[ll * amD], &amM2[ll * amDD], amN[ll], amD); 
+            amN[ll]++; 
 	  }
 	} // ll
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (q >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -898,8 +948,10 @@ extern "C" {
             detProb[i] = logitInv(F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i], zero, one);
             psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + wSites[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             piProd[zLongIndx[i]] = pow(1.0 - detProb[i], K[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], K[i] - y[i]);
+	    }
             ySum[zLongIndx[i]] = y[i]; 	
           } // i
         } else {
@@ -909,8 +961,10 @@ extern "C" {
               psi[zLongIndx[i]] = logitInv(F77_NAME(ddot)(&pOcc, &X[zLongIndx[i]], &J, beta, &inc) + wSites[zLongIndx[i]] + betaStarSites[zLongIndx[i]], zero, one); 
             }
             piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    if (saveIter) {
+	      piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	      piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	    }
             ySum[zLongIndx[i]] += y[i]; 	
             tmp_J[zLongIndx[i]]++;
           } // i
@@ -920,10 +974,14 @@ extern "C" {
           psiNum = psi[j] * piProd[j]; 
           if (ySum[j] == zero) {
             z[j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[j])));          
-            yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j]; 
+	    if (saveIter) {
+	      yWAIC[j] = (1.0 - psi[j]) + psi[j] * piProdWAIC[j];
+	    }
           } else {
             z[j] = one; 
-            yWAIC[j] = psi[j] * piProdWAIC[j];
+	    if (saveIter) {
+	      yWAIC[j] = psi[j] * piProdWAIC[j];
+	    }
           }
           piProd[j] = one;
           piProdWAIC[j] = one;
@@ -981,6 +1039,12 @@ extern "C" {
           accept[j * pTilde + ll] = 0;
         } // j
       } // ll
+      for (ll = 0; ll < pTilde; ll++) {
+        for (k = 0; k < amD; k++) {
+          amSD[k] = exp(tuning[amIndx[k] * pTilde + ll]); 
+        }
+        mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -990,7 +1054,7 @@ extern "C" {
           Rprintf("\tCoefficient\tParameter\tAcceptance\tTuning\n");	  
           for (ll = 0; ll < pTilde; ll++) {
             Rprintf("\t%i\t\tphi\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*REAL(acceptSamples_r)[s * nThetapTilde + phiIndx * pTilde + ll], exp(tuning[phiIndx * pTilde + ll]));
-	    if (corName == "matern") {
+	    if (isMatern) {
               Rprintf("\t%i\t\tnu\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*REAL(acceptSamples_r)[s * nThetapTilde + nuIndx * pTilde + ll], exp(tuning[nuIndx * pTilde + ll]));
 	    }
 	    if (sigmaSqIG == 0) {
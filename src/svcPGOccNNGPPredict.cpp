@@ -27,7 +27,8 @@ extern "C" {
 			   SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
 			   SEXP nReport_r){
 
-    int i, j, ll, k, l, s, info, nProtect=0;
+    int j, ll, k, l, info, nProtect=0;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     const double zero = 0.0;
@@ -45,8 +46,8 @@ extern "C" {
     int JStr = INTEGER(JStr_r)[0];
     int m = INTEGER(m_r)[0]; 
     int mm = m * m; 
-    int JpTilde = J * pTilde;
-    int JStrpTilde = JStr * pTilde; 
+    int JpTilde = intProd(J, pTilde);
+    int JStrpTilde = intProd(JStr, pTilde); 
 
     int *nnIndx0 = INTEGER(nnIndx0_r);        
     double *beta = REAL(betaSamples_r);
@@ -57,6 +58,7 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
@@ -91,7 +93,7 @@ extern "C" {
     // parameters
     int nTheta, sigmaSqIndx,  phiIndx, nuIndx;
 
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; //sigma^2, phi
       sigmaSqIndx = 0; phiIndx = 1;
       } else{
@@ -109,7 +111,7 @@ extern "C" {
       nb[ll] = 0; 
     }
     
-    if(corName == "matern"){
+    if(isMatern){
       for (ll = 0; ll < pTilde; ll++) {
         for(s = 0; s < nSamples; s++){
           if(theta[s*nThetapTilde + nuIndx * pTilde + ll] > nuMax[ll]){
@@ -153,14 +155,16 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(JStrpTilde*nSamples, sizeof(double));
+    R_xlen_t vIndx = -1, nWV;
+    nWV = static_cast<R_xlen_t>(JStrpTilde)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < JStrpTilde*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
+    vIndx = -1;
     
     for(j = 0; j < JStr; j++){
       for (ll = 0; ll < pTilde; ll++) {
@@ -172,7 +176,7 @@ extern "C" {
 	  threadID = omp_get_thread_num();
 #endif 	
 	  phi = theta[s * nThetapTilde + phiIndx * pTilde + ll];
-	  if(corName == "matern"){
+	  if(isMatern){
 	    nu = theta[s * nThetapTilde + nuIndx * pTilde + ll];
 	  }
 	  sigmaSq = theta[s * nThetapTilde + sigmaSqIndx * pTilde + ll];
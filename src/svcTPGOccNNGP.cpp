@@ -88,7 +88,7 @@ extern "C" {
     /**********************************************************************
      * Initial constants
      * *******************************************************************/
-    int i, j, k, s, r, ll, rr, ii, t, info, nProtect=0, l;
+    int i, j, k, s, r, ll, rr, ii, t, jt, info, nProtect=0, l;
     int status = 0; // For AMCMC. 
     const int inc = 1;
     const double one = 1.0;
@@ -123,7 +123,7 @@ extern "C" {
     int ppDet = pDet * pDet;
     int ppOcc = pOcc * pOcc;
     int ppTilde = pTilde * pTilde;
-    int JpTilde = J * pTilde;
+    int JpTilde = intProd(J, pTilde);
     /**********************************
      * Priors
      * *******************************/
@@ -156,6 +156,7 @@ extern "C" {
     int *uiIndx = INTEGER(uiIndx_r);
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int *zLongIndx = INTEGER(zLongIndx_r); 
     int *zYearIndx = INTEGER(zYearIndx_r); 
     int *zDatIndx = INTEGER(zDatIndx_r); 
@@ -174,7 +175,7 @@ extern "C" {
     int sigmaSqIG = INTEGER(sigmaSqIG_r)[0];
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     int nThin = INTEGER(nThin_r)[0]; 
     int nBurn = INTEGER(nBurn_r)[0]; 
     int nPost = INTEGER(nPost_r)[0]; 
@@ -185,10 +186,11 @@ extern "C" {
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
 
     // Some constants
-    int JnYears = J * nYearsMax;
+    int JnYears = intProd(J, nYearsMax);
     int nnYears = nYearsMax * nYearsMax;
 
 #ifdef _OPENMP
@@ -273,12 +275,31 @@ extern "C" {
     // Latent Occurrence
     double *z = (double *) R_alloc(JnYears, sizeof(double));   
     F77_NAME(dcopy)(&JnYears, REAL(zStarting_r), &inc, z, &inc);
+    // Site/year combinations with data, stored in a ragged layout grouped by 
+    // site. The occurrence auxiliary variables and design matrix are only 
+    // needed for these combinations. 
+    int nDat = 0; 
+    for (j = 0; j < JnYears; j++) {
+      nDat += zDatIndx[j]; 
+    }
+    int *siteYearLU = (int *) R_alloc(2 * J, sizeof(int)); 
+    int *datYearIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    int *datCellIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    mkSiteYearIndx(J, nYearsMax, zDatIndx, siteYearLU, datYearIndx, datCellIndx); 
+    int nDatpOcc = intProd(nDat, pOcc); 
+    // X stays padded to all site/year cells and is indexed through 
+    // datCellIndx. XBetaDat holds the occurrence linear predictor of the 
+    // cells with observations for the current beta. 
+    double *XBetaDat = (double *) R_alloc(nDat, sizeof(double)); 
+    for (ii = 0; ii < nDat; ii++) {
+      XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+    }
     // PG auxiliary variables 
     double *omegaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(omegaDet, nObs);
-    double *omegaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(omegaOcc, JnYears);
+    double *omegaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(omegaOcc, nDat);
     double *kappaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(kappaDet, nObs);
-    double *kappaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(kappaOcc, JnYears);
-    double *zStar = (double *) R_alloc(JnYears, sizeof(double)); zeros(zStar, JnYears);
+    double *kappaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(kappaOcc, nDat);
+    double *zStar = (double *) R_alloc(nDat, sizeof(double)); zeros(zStar, nDat);
 
     /**********************************************************************
      * Return Stuff
@@ -319,9 +340,9 @@ extern "C" {
      * Other initial starting stuff
      * *******************************************************************/
     int JnYearspOccRE = J * nYearsMax * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
-    int jj, kk;
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
+    int jj;
     double tmp_0 = 0.0;
     double tmp_02;
     double *tmp_ppDet = (double *) R_alloc(ppDet, sizeof(double));
@@ -342,10 +363,10 @@ extern "C" {
     zeros(tmp_J1, J);
     double *tmp_nObs = (double *) R_alloc(nObs, sizeof(double));
     zeros(tmp_nObs, nObs);
-    double *tmp_JnYears = (double *) R_alloc(JnYears, sizeof(double));
-    zeros(tmp_JnYears, JnYears);
-    double *tmp_JnYearspOcc = (double *) R_alloc(JnYears * pOcc, sizeof(double));
-    zeros(tmp_JnYearspOcc, JnYears * pOcc);
+    double *tmp_nDat = (double *) R_alloc(nDat, sizeof(double));
+    zeros(tmp_nDat, nDat);
+    double *tmp_nDatpOcc = (double *) R_alloc(nDatpOcc, sizeof(double));
+    zeros(tmp_nDatpOcc, nDatpOcc);
     double *tmp_pTilde = (double *) R_alloc(pTilde, sizeof(double));
     zeros(tmp_pTilde, pTilde);
     double * tmp_ppTilde = (double *) R_alloc(ppTilde, sizeof(double));
@@ -424,7 +445,7 @@ extern "C" {
      * Set up spatial stuff and MH stuff
      * *******************************************************************/
     int nTheta, sigmaSqIndx, phiIndx, nuIndx, sigmaSqTIndx, rhoIndx;
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; // sigma^2, phi 
       sigmaSqIndx = 0; phiIndx = 1; 
     } else {
@@ -455,18 +476,57 @@ extern "C" {
     double *mu = (double *) R_alloc(pTilde, sizeof(double));
     double *var = (double *) R_alloc(ppTilde, sizeof(double)); zeros(var, ppTilde);
     double *ff = (double *) R_alloc(pTilde, sizeof(double));
+    // NNGP residuals w_j - B_j w_N(j) of each process, kept current through the w sweep
+    double *wResid = (double *) R_alloc(JpTilde, sizeof(double));
+    double *wNew = (double *) R_alloc(pTilde, sizeof(double));
     double *gg = (double *) R_alloc(pTilde, sizeof(double));
     // Initiate spatial values
     for (i = 0; i < pTilde; i++) {
       theta[sigmaSqIndx * pTilde + i] = sigmaSq[i]; 
       theta[phiIndx * pTilde + i] = phi[i]; 
-      if (corName == "matern") {
+      if (isMatern) {
         theta[nuIndx * pTilde + i] = nu[i]; 
       } 
     } // i
+    // Adaptive block Metropolis for the covariance parameters updated with MH, 
+    // all of which are proposed jointly on the logit scale, one block per spatially-varying coefficient. 
+    int amD = 0; 
+    int *amIndx = (int *) R_alloc(nTheta, sizeof(int)); 
+    if (sigmaSqIG == 0) {
+      amIndx[amD] = sigmaSqIndx; amD++; 
+    }
+    amIndx[amD] = phiIndx; amD++; 
+    if (isMatern) {
+      amIndx[amD] = nuIndx; amD++; 
+    }
+    int amDD = amD * amD; 
+    int *amN = (int *) R_alloc(pTilde, sizeof(int)); 
+    double *amA = (double *) R_alloc(amD * pTilde, sizeof(double)); 
+    double *amB = (double *) R_alloc(amD * pTilde, sizeof(double)); 
+    double *amX = (double *) R_alloc(amD, sizeof(double)); 
+    double *amXCand = (double *) R_alloc(amD, sizeof(double)); 
+    double *amSD = (double *) R_alloc(amD, sizeof(double)); 
+    double *amMean = (double *) R_alloc(amD * pTilde, sizeof(double)); zeros(amMean, amD * pTilde); 
+    double *amM2 = (double *) R_alloc(amDD * pTilde, sizeof(double)); zeros(amM2, amDD * pTilde); 
+    double *amChol = (double *) R_alloc(amDD * pTilde, sizeof(double)); 
+    double *thetaCand = (double *) R_alloc(nTheta, sizeof(double)); 
+    for (ll = 0; ll < pTilde; ll++) {
+      amN[ll] = 0; 
+      for (k = 0; k < amD; k++) {
+        if (amIndx[k] == sigmaSqIndx) {
+          amA[ll * amD + k] = sigmaSqA[ll]; amB[ll * amD + k] = sigmaSqB[ll]; 
+        } else if (amIndx[k] == phiIndx) {
+          amA[ll * amD + k] = phiA[ll]; amB[ll * amD + k] = phiB[ll]; 
+        } else {
+          amA[ll * amD + k] = nuA[ll]; amB[ll * amD + k] = nuB[ll]; 
+        }
+        amSD[k] = exp(tuning[amIndx[k] * pTilde + ll]); 
+      }
+      mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+    }
     // Allocate for the U index vector that keep track of which locations have 
     // the i-th location as a neighbor
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(J-m-1)*m);
+    int nIndx = getNIndx(J, m);
 
     // For NNGP
     int mm = m*m;
@@ -521,6 +581,19 @@ extern "C" {
     // For sigmaSqT sampler
     double aSigmaSqTPost = 0.5 * nYearsMax + sigmaSqTA;
     double bSigmaSqTPost = 0.0;
+    // Adaptive block Metropolis for (rho, sigmaSqT) on the (logit, log) scale. 
+    // sigmaSqT is still Gibbs updated, with the joint move following it. 
+    int arD = 2, arN = 0; 
+    double sigmaSqTCand = 0.0, detCand = 0.0, detCurr = 0.0;
+    double *arX = (double *) R_alloc(arD, sizeof(double)); 
+    double *arXCand = (double *) R_alloc(arD, sizeof(double)); 
+    double *arSD = (double *) R_alloc(arD, sizeof(double)); 
+    double *arMean = (double *) R_alloc(arD, sizeof(double)); zeros(arMean, arD); 
+    double *arM2 = (double *) R_alloc(arD*arD, sizeof(double)); zeros(arM2, arD*arD); 
+    double *arChol = (double *) R_alloc(arD*arD, sizeof(double)); 
+    arSD[0] = exp(tuning[rhoIndx]); 
+    arSD[1] = arSD[0]; 
+    mkAMChol(arSD, arM2, arN, arD, arChol); 
     double *etaTRInv = (double *) R_alloc(nYearsMax, sizeof(double));
 
     GetRNGstate();
@@ -534,82 +607,67 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
-	zeros(tmp_JnYears, JnYears);
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            // Only calculate omegaOcc when there are observations at that 
-	    // site/year combo. Otherwise, you're just wasting time. 
-	    if (zDatIndx[t * J + j] == 1) { 
-              tmp_JnYears[t * J + j] = F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, 
-	         	                      beta, &inc);
-	      omegaOcc[t * J + j] = rpg(1.0, tmp_JnYears[t * J + j] + wSites[t * J + j] + betaStarSites[t * J + j] + eta[t]);
-	      // Update kappa values along the way. 
-              kappaOcc[t * J + j] = z[t * J + j] - 1.0 / 2.0; 
-	      zStar[t * J + j] = kappaOcc[t * J + j] / omegaOcc[t * J + j];
-	    }
-	  } // j 
-	} // t
+	// Only calculate omegaOcc for site/year combos with observations. 
+	for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+	  omegaOcc[ii] = XBetaDat[ii] + wSites[jt] + betaStarSites[jt] + eta[datYearIndx[ii]];
+	  // Update kappa values along the way. 
+          kappaOcc[ii] = z[jt] - 1.0 / 2.0; 
+	} // ii
+        rpgBatch(nDat, &one, 0, omegaOcc, inc, omegaOcc, inc);
+	for (ii = 0; ii < nDat; ii++) {
+	  zStar[ii] = kappaOcc[ii] / omegaOcc[ii];
+	} // ii
 	zeros(kappaDet, nObs);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
 	// Only need to sample locations where z[i] == 1.0; 
-	for (t = 0; t < nYearsMax; t++) {
-          for (i = 0; i < nObs; i++) {
-	    // If current observation is from the current year. 
-            if (zYearIndx[zLongIndx[i]] == t) {
-              // Reset
-	      omegaDet[i] = 0.0;
-	      kappaDet[i] = 0.0;
-              // If the site is occupied and data were collected at that site. 
-              if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
-                omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
-	        // Update kappa values along the way. 
-                kappaDet[i] = (y[i] - 1.0 / 2.0);
-	      }
-	    }
-          } // i
-	} // t
+        for (i = 0; i < nObs; i++) {
+          // Reset
+	  omegaDet[i] = 0.0;
+	  kappaDet[i] = 0.0;
+          // If the site is occupied and data were collected at that site. 
+          if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
+            omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
+	    // Update kappa values along the way. 
+            kappaDet[i] = (y[i] - 1.0 / 2.0);
+	  }
+        } // i
 
         /********************************************************************
          *Update Occupancy Regression Coefficients
          *******************************************************************/
-        zeros(tmp_JnYears, JnYears);
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              tmp_JnYears[t * J + j] = kappaOcc[t * J + j] - omegaOcc[t * J + j] * (wSites[t * J + j] + betaStarSites[t * J + j] + eta[t]); 
-	    }
-	  } // j
-	} // t
+        for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+          tmp_nDat[ii] = kappaOcc[ii] - omegaOcc[ii] * (wSites[jt] + betaStarSites[jt] + eta[datYearIndx[ii]]); 
+	} // ii
         /********************************
          * Compute b.beta
          *******************************/
-	// This is fine, because the elements in tmp_JnYears corresponding
-	// to unobserve site/time locations is set to 0 and not changed. 
-        F77_NAME(dgemv)(ytran, &JnYears, &pOcc, &one, X, &JnYears, 
-			tmp_JnYears, &inc, &zero, tmp_pOcc, &inc FCONE); 	 
+	// Only the site/year combos with observations contribute. 
         for (j = 0; j < pOcc; j++) {
-          tmp_pOcc[j] += SigmaBetaInvMuBeta[j]; 
+          tmp_pOcc[j] = SigmaBetaInvMuBeta[j]; 
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_pOcc[j] += X[j * JnYears + datCellIndx[ii]] * tmp_nDat[ii]; 
+          } // ii
         } // j 
 
         /********************************
          * Compute A.beta
          * *****************************/
-	// This is fine, because omegaOcc == 0 for the site/year combos
-	// that don't have any observations at them, which will cause this
-	// whole product to go to 0.  
-	for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              for(i = 0; i < pOcc; i++){
-                tmp_JnYearspOcc[i * JnYears + t * J + j] = X[i * JnYears + t * J + j] * omegaOcc[t * J + j];
-              } // i
-	    }
-	  } // j
-	} // t
+        // Rows of X for the cells with observations, scaled by sqrt(omegaOcc), 
+        // so X' diag(omegaOcc) X is a single rank-k update (lower triangle). 
+        for (ii = 0; ii < nDat; ii++) {
+          tmp_nDat[ii] = sqrt(omegaOcc[ii]); 
+        } // ii
+        for (i = 0; i < pOcc; i++) {
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_nDatpOcc[i * nDat + ii] = X[i * JnYears + datCellIndx[ii]] * tmp_nDat[ii];
+          } // ii
+        } // i
 
-        F77_NAME(dgemm)(ytran, ntran, &pOcc, &pOcc, &JnYears, &one, X, &JnYears, tmp_JnYearspOcc, &JnYears, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
+        F77_NAME(dsyrk)(lower, ytran, &pOcc, &nDat, &one, tmp_nDatpOcc, &nDat, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
         for (j = 0; j < ppOcc; j++) {
           tmp_ppOcc[j] += SigmaBetaInv[j]; 
         } // j
@@ -623,6 +681,9 @@ extern "C" {
         F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
 	if(info != 0){error("c++ error: dpotrf A.beta2 failed\n");}
         mvrnorm(beta, tmp_pOcc2, tmp_ppOcc, pOcc);
+        for (ii = 0; ii < nDat; ii++) {
+          XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+        } // ii
 
 	/********************************************************************
          *Update Detection covariates
@@ -703,21 +764,18 @@ extern "C" {
             // Only allow information to come from when XRE == betaLevelIndx[l]. 
             // aka information only comes from the sites with any given level 
             // of a random effect. 
-	    for (t = 0; t < nYearsMax; t++) {
-              for (j = 0; j < J; j++) {
-                if (XRE[betaStarIndx[l] * JnYears + t * J + j] == betaLevelIndx[l]) {
-                   if (zDatIndx[t * J + j] == 1) {
-                    tmp_02 = 0.0;
-                    for (ll = 0; ll < pOccRE; ll++) {
-                      tmp_02 += betaStar[betaStarLongIndx[ll * JnYears + t * J + j]];
-	            } 
-                    tmp_one[0] += kappaOcc[t * J + j] - (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + 
-                  	          tmp_02 - betaStar[l] + wSites[t * J + j] + eta[t]) * omegaOcc[t * J + j];
-                    tmp_0 += omegaOcc[t * J + j];
-		  }
-                }
-              }
-	    }
+	    for (ii = 0; ii < nDat; ii++) {
+              jt = datCellIndx[ii];
+              if (XRE[betaStarIndx[l] * JnYears + jt] == betaLevelIndx[l]) {
+                tmp_02 = 0.0;
+                for (ll = 0; ll < pOccRE; ll++) {
+                  tmp_02 += betaStar[betaStarLongIndx[ll * JnYears + jt]];
+                } 
+                tmp_one[0] += kappaOcc[ii] - (XBetaDat[ii] + 
+                	      tmp_02 - betaStar[l] + wSites[jt] + eta[datYearIndx[ii]]) * omegaOcc[ii];
+                tmp_0 += omegaOcc[ii];
+	      }
+	    } // ii
             /********************************
              * Compute A.beta.star
              *******************************/
@@ -778,39 +836,31 @@ extern "C" {
         /********************************************************************
          *Update w (spatial random effects)
          *******************************************************************/
+	for (ll = 0; ll < pTilde; ll++) {
+	  mkNNResid(J, &w[ll], pTilde, &B[ll * nIndx], 1, nnIndx, nnIndxLU, &wResid[ll * J]);
+	} // ll
 	for (ii = 0; ii < J; ii++ ) {
           zeros(tmp_ppTilde, ppTilde);
           for (ll = 0; ll < pTilde; ll++) {
-            for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + ii] == 1) {
-                tmp_0 = Xw[ll * JnYears + t * J + ii] * omegaOcc[t * J + ii];
-	        for (k = 0; k < pTilde; k++) {
-                  tmp_ppTilde[ll * pTilde + k] += tmp_0 * Xw[k * JnYears + t * J + ii];
-	        }
+            // Site/year combos with data at site ii. 
+            for (jt = siteYearLU[ii]; jt < siteYearLU[ii] + siteYearLU[J + ii]; jt++) {
+              tmp_0 = Xw[ll * JnYears + datCellIndx[jt]] * omegaOcc[jt];
+	      for (k = 0; k < pTilde; k++) {
+                tmp_ppTilde[ll * pTilde + k] += tmp_0 * Xw[k * JnYears + datCellIndx[jt]];
 	      }
-	    } // t
+	    } // jt
             a[ll] = 0.0;
 	    v[ll] = 0.0;
-	    if (uIndxLU[J + ii] > 0){ // is i a neighbor for anybody
-	      for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
-	        b = 0.0;
-	        // now the neighbors for the jth location who has ii as a neighbor
-	        jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
-	        for(k = 0; k < nnIndxLU[J+jj]; k++){ // these are the neighbors of the jjth location
-	          kk = nnIndx[nnIndxLU[jj]+k]; // kk is the index for the jth locations neighbors
-	          if(kk != ii){ //if the neighbor of jj is not ii
-	    	    b += B[ll * nIndx + nnIndxLU[jj]+k]*w[kk * pTilde + ll]; //covariance between jj and kk and the random effect of kk
-	          }
-	        }
-	        aij = w[jj * pTilde + ll] - b;
-	        a[ll] += B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]]*aij/F[ll * J + jj];
-	        v[ll] += pow(B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]],2)/F[ll * J + jj];
-	      }
-	    }
-	    e = 0.0;
-	    for(j = 0; j < nnIndxLU[J+ii]; j++){
-	      e += B[ll * nIndx + nnIndxLU[ii]+j]*w[nnIndx[nnIndxLU[ii]+j] * pTilde + ll];
-	    }
+	    for (j = 0; j < uIndxLU[J+ii]; j++){ // how many locations have ii as a neighbor
+	      jj = uIndx[uIndxLU[ii]+j]; // jj is the index of the jth location who has ii as a neighbor
+	      b = B[ll * nIndx + nnIndxLU[jj]+uiIndx[uIndxLU[ii]+j]];
+	      // residual of jj given its neighbors other than ii
+	      aij = wResid[ll * J + jj] + b*w[ii * pTilde + ll];
+	      a[ll] += b*aij/F[ll * J + jj];
+	      v[ll] += b*b/F[ll * J + jj];
+	    } // j
+	    
+	    e = w[ii * pTilde + ll] - wResid[ll * J + ii];
 	    ff[ll] = 1.0 / F[ll * J + ii];
 	    gg[ll] = e / F[ll * J + ii];
 	  } // ll (svc)
@@ -828,11 +878,9 @@ extern "C" {
 	  // mu
 	  for (k = 0; k < pTilde; k++) {
             mu[k] = 0.0;
-	    for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + ii] == 1) {
-                mu[k] += (zStar[t * J + ii] - F77_NAME(ddot)(&pOcc, &X[t * J + ii], &JnYears, beta, &inc) - betaStarSites[t * J + ii] - eta[t]) * omegaOcc[t * J + ii] * Xw[k * JnYears + t * J + ii];
-	      }
-	    } // t
+	    for (jt = siteYearLU[ii]; jt < siteYearLU[ii] + siteYearLU[J + ii]; jt++) {
+              mu[k] += (zStar[jt] - XBetaDat[jt] - betaStarSites[datCellIndx[jt]] - eta[datYearIndx[jt]]) * omegaOcc[jt] * Xw[k * JnYears + datCellIndx[jt]];
+	    } // jt
 	    mu[k] += gg[k] + a[k];
 	  } // k
 	  F77_NAME(dsymv)(lower, &pTilde, &one, var, &pTilde, mu, &inc, &zero, tmp_pTilde, &inc FCONE);
@@ -840,7 +888,11 @@ extern "C" {
 	  F77_NAME(dpotrf)(lower, &pTilde, var, &pTilde, &info FCONE); 
           if(info != 0){error("c++ error: dpotrf var 2 failed\n");}
 
-	  mvrnorm(&w[ii * pTilde], tmp_pTilde, var, pTilde);
+	  mvrnorm(wNew, tmp_pTilde, var, pTilde);
+	  for (ll = 0; ll < pTilde; ll++) {
+	    updateNNResid(ii, wNew[ll] - w[ii * pTilde + ll], J, &B[ll * nIndx], 1, nnIndxLU, uIndx, uIndxLU, uiIndx, &wResid[ll * J]);
+	    w[ii * pTilde + ll] = wNew[ll];
+	  } // ll
         } // ii (site)
 
 	// Compute wSites. 
@@ -885,7 +937,7 @@ extern "C" {
            *Update phi (and nu if matern)
            *****************************************************************/
           // Current
-          if (corName == "matern"){ 
+          if (isMatern){ 
 	    nu[ll] = theta[nuIndx * pTilde + ll];
        	  }
           updateBFSVCT(&B[ll * nIndx], &F[ll*J], &c[ll * m*nThreads], &C[ll * mm * nThreads], coords, nnIndx, nnIndxLU, J, m, theta[sigmaSqIndx * pTilde + ll], theta[phiIndx * pTilde + ll], nu[ll], covModel, &bk[ll * sizeBK], nuB[ll]);
@@ -911,7 +963,7 @@ extern "C" {
       
           logPostCurr = -0.5 * logDet - 0.5 * aa;
           logPostCurr += log(theta[phiIndx * pTilde + ll] - phiA[ll]) + log(phiB[ll] - theta[phiIndx * pTilde + ll]); 
-          if(corName == "matern"){
+          if(isMatern){
        	    logPostCurr += log(theta[nuIndx * pTilde + ll] - nuA[ll]) + log(nuB[ll] - theta[nuIndx * pTilde + ll]); 
           }
 	  if (sigmaSqIG == 0) {
@@ -920,15 +972,19 @@ extern "C" {
 	  }
           
           // Candidate
-          phiCand = logitInv(rnorm(logit(theta[phiIndx * pTilde + ll], phiA[ll], phiB[ll]), exp(tuning[phiIndx * pTilde + ll])), phiA[ll], phiB[ll]);
-	  // Rprintf("SVC: %i, phiCand: %f\n", ll, phiCand);
-	  // Rprintf("SVC: %i, tuning: %f\n", ll, exp(tuning[phiIndx * pTilde + ll]));
-          if (corName == "matern"){
-      	    nuCand = logitInv(rnorm(logit(theta[nuIndx * pTilde + ll], nuA[ll], nuB[ll]), exp(tuning[nuIndx * pTilde + ll])), nuA[ll], nuB[ll]);
+          for (k = 0; k < amD; k++) {
+            amX[k] = logit(theta[amIndx[k] * pTilde + ll], amA[ll * amD + k], amB[ll * amD + k]); 
+          }
+          mvrnorm(amXCand, amX, &amChol[ll * amDD], amD); 
+          for (k = 0; k < amD; k++) {
+            thetaCand[amIndx[k]] = logitInv(amXCand[k], amA[ll * amD + k], amB[ll * amD + k]); 
+          }
+          phiCand = thetaCand[phiIndx];
+          if (isMatern){
+            nuCand = thetaCand[nuIndx];
           }
 	  if (sigmaSqIG == 0) {
-            sigmaSqCand = logitInv(rnorm(logit(theta[sigmaSqIndx * pTilde + ll], sigmaSqA[ll], sigmaSqB[ll]),
-				         exp(tuning[sigmaSqIndx * pTilde + ll])), sigmaSqA[ll], sigmaSqB[ll]);
+	    sigmaSqCand = thetaCand[sigmaSqIndx]; 
 	  }
      
 	  if (sigmaSqIG) { 
@@ -959,7 +1015,7 @@ extern "C" {
           
           logPostCand = -0.5*logDet - 0.5*aa;      
           logPostCand += log(phiCand - phiA[ll]) + log(phiB[ll] - phiCand); 
-          if (corName == "matern"){
+          if (isMatern){
             logPostCand += log(nuCand - nuA[ll]) + log(nuB[ll] - nuCand); 
           }
 	  if (sigmaSqIG == 0) {
@@ -973,7 +1029,7 @@ extern "C" {
             
 	    theta[phiIndx * pTilde + ll] = phiCand;
             accept[phiIndx * pTilde + ll]++;
-            if (corName == "matern") {
+            if (isMatern) {
               nu[ll] = nuCand; 
 	      theta[nuIndx * pTilde + ll] = nu[ll]; 
               accept[nuIndx * pTilde + ll]++; 
@@ -982,7 +1038,10 @@ extern "C" {
               theta[sigmaSqIndx * pTilde + ll] = sigmaSqCand;
 	      accept[sigmaSqIndx * pTilde + ll]++;
 	    }
+            F77_NAME(dcopy)(&amD, amXCand, &inc, amX, &inc); 
           }
+          updateAM(amX, &amMean[ll * amD], &amM2[ll * amDD], amN[ll], amD); 
+          amN[ll]++; 
 	} // ll
 	if (ar1) {
           /********************************************************************
@@ -1007,62 +1066,72 @@ extern "C" {
 	  theta[sigmaSqTIndx] = rigamma(aSigmaSqTPost, bSigmaSqTPost);
           
           /********************************************************************
-           *Update rho
+           *Update rho and sigmaSqT
            *******************************************************************/
 	  rho = theta[rhoIndx];
 	  sigmaSqT = theta[sigmaSqTIndx];
-	  rhoCand = logitInv(rnorm(logit(rho, rhoA, rhoB), exp(tuning[rhoIndx])), rhoA, rhoB); 
-	  theta[rhoIndx] = rhoCand; 
+	  arX[0] = logit(rho, rhoA, rhoB); 
+	  arX[1] = log(sigmaSqT); 
+	  mvrnorm(arXCand, arX, arChol, arD); 
+	  rhoCand = logitInv(arXCand[0], rhoA, rhoB); 
+	  sigmaSqTCand = exp(arXCand[1]); 
 
 	  // Construct proposal covariance matrix. 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEtaCand);
+          AR1(nYearsMax, rhoCand, sigmaSqTCand, SigmaEtaCand);
 	  clearUT(SigmaEtaCand, nYearsMax);
 
           /********************************
            * Proposal
            *******************************/
 	  // Invert SigmaEtaCand and log det cov. 
-          logPostCand = 0.0;
+          detCand = 0.0;
 	  F77_NAME(dpotrf)(lower, &nYearsMax, SigmaEtaCand, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky failed in proposal covariance matrix\n");}
 	  // Get log of the determinant of the covariance matrix. 
 	  for (k = 0; k < nYearsMax; k++) {
-	    logPostCand += 2.0 * log(SigmaEtaCand[k*nYearsMax+k]);
+	    detCand += 2.0 * log(SigmaEtaCand[k*nYearsMax+k]);
 	  } // k
 	  F77_NAME(dpotri)(lower, &nYearsMax, SigmaEtaCand, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky inverse failed in proposal covariance matrix\n");}
           logPostCand = 0.0; 
 	  // Jacobian and Uniform prior. 
 	  logPostCand += log(rhoCand - rhoA) + log(rhoB - rhoCand); 
+	  // Jacobian and IG prior. 
+	  logPostCand += -1.0 * sigmaSqTA * log(sigmaSqTCand) - sigmaSqTB / sigmaSqTCand; 
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one,  SigmaEtaCand, &nYearsMax, eta, &inc, &zero, tmp_nYearsMax, &inc FCONE);
-	  logPostCand += -0.5*logPostCand-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
+	  logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
           /********************************
            * Current
            *******************************/
-	  theta[rhoIndx] = rho; 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEta);
+          AR1(nYearsMax, rho, sigmaSqT, SigmaEta);
 	  clearUT(SigmaEta, nYearsMax);
-          logPostCurr = 0.0;
+          detCurr = 0.0;
 	  F77_NAME(dpotrf)(lower, &nYearsMax, SigmaEta, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky failed in covariance matrix\n");}
 	  for (k = 0; k < nYearsMax; k++) {
-	    logPostCurr += 2.0 * log(SigmaEta[k*nYearsMax+k]);
+	    detCurr += 2.0 * log(SigmaEta[k*nYearsMax+k]);
 	  } // k
 	  F77_NAME(dpotri)(lower, &nYearsMax, SigmaEta, &nYearsMax, &info FCONE); 
 	  if(info != 0){error("c++ error: Cholesky inverse failed in covariance matrix\n");}
           logPostCurr = 0.0; 
 	  logPostCurr += log(rho - rhoA) + log(rhoB - rho); 
+	  logPostCurr += -1.0 * sigmaSqTA * log(sigmaSqT) - sigmaSqTB / sigmaSqT; 
 	  // (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one, SigmaEta, &nYearsMax, eta, &inc, &zero, 
 	  		tmp_nYearsMax, &inc FCONE);
-	  logPostCurr += -0.5*logPostCurr-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
+	  logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
 
 	  // MH Accept/Reject
 	  if (runif(0.0, 1.0) <= exp(logPostCand - logPostCurr)) {
             theta[rhoIndx] = rhoCand;
+            theta[sigmaSqTIndx] = sigmaSqTCand;
             accept[rhoIndx]++;
 	    F77_NAME(dcopy)(&nnYears, SigmaEtaCand, &inc, SigmaEta, &inc); 
+	    F77_NAME(dcopy)(&arD, arXCand, &inc, arX, &inc); 
           }
+          updateAM(arX, arMean, arM2, arN, arD); 
+          arN++; 
+          
           /********************************************************************
            *Update eta 
            *******************************************************************/
@@ -1070,25 +1139,19 @@ extern "C" {
            * Compute b.w
            *******************************/
 	  zeros(tmp_nYearsMax, nYearsMax);
-          for (j = 0; j < J; j++) {
-            for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nYearsMax[t] += kappaOcc[t * J + j] - omegaOcc[t * J + j] * (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + betaStarSites[t * J + j] + wSites[t * J + j]);
-	      }
-	    }
-          }
+          for (ii = 0; ii < nDat; ii++) {
+            jt = datCellIndx[ii];
+            tmp_nYearsMax[datYearIndx[ii]] += kappaOcc[ii] - omegaOcc[ii] * (XBetaDat[ii] + betaStarSites[jt] + wSites[jt]);
+          } // ii
           /********************************
            * Compute A.w
            *******************************/
 	  // Copy inverse covariance matrix into tmp_JJ
 	  F77_NAME(dcopy)(&nnYears, SigmaEta, &inc, tmp_nnYears, &inc); 
-          for (j = 0; j < J; j++) {
-	    for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nnYears[t * nYearsMax + t] += omegaOcc[t * J + j];
-	      }
-	    } // t
-	  } // j
+          for (ii = 0; ii < nDat; ii++) {
+            t = datYearIndx[ii];
+            tmp_nnYears[t * nYearsMax + t] += omegaOcc[ii];
+          } // ii
 
           // Cholesky of A.eta
           F77_NAME(dpotrf)(lower, &nYearsMax, tmp_nnYears, &nYearsMax, &info FCONE); 
@@ -1105,6 +1168,8 @@ extern "C" {
           mvrnorm(eta, tmp_nYearsMax2, tmp_nnYears, nYearsMax);
 	}
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (rr >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -1119,8 +1184,10 @@ extern "C" {
 				         zero, one); 
           }
           piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-	  piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  if (saveIter) {
+	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  }
           ySum[zLongIndx[i]] += y[i]; 	
           tmp_JnYearsInt[zLongIndx[i]]++;
         } // i
@@ -1132,10 +1199,14 @@ extern "C" {
 	    if (zDatIndx[t * J + j] == 1) {
               if (ySum[t * J + j] == zero) {
                 z[t * J + j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[t * J + j])));
-	        yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];	
+		if (saveIter) {
+		  yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               } else {
                 z[t * J + j] = one; 
-                yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		if (saveIter) {
+		  yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               }
 	    } else {
               psi[t * J + j] = logitInv(F77_NAME(ddot)(&pOcc, &X[t * J + j], 
@@ -1217,6 +1288,19 @@ extern "C" {
           }
         accept[rhoIndx] = 0;
       }
+      if (ar1) {
+        arSD[0] = exp(tuning[rhoIndx]); 
+        if (arN > 1) {
+          arSD[1] = 2.38 / sqrt(2.0) * sqrt(arM2[3] / (arN - 1.0)); 
+        }
+        mkAMChol(arSD, arM2, arN, arD, arChol); 
+      }
+      for (ll = 0; ll < pTilde; ll++) {
+        for (k = 0; k < amD; k++) {
+          amSD[k] = exp(tuning[amIndx[k] * pTilde + ll]); 
+        }
+        mkAMChol(amSD, &amM2[ll * amDD], amN[ll], amD, &amChol[ll * amDD]); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
@@ -1226,7 +1310,7 @@ extern "C" {
           Rprintf("\tCoefficient\tParameter\tAcceptance\tTuning\n");	  
           for (ll = 0; ll < pTilde; ll++) {
             Rprintf("\t%i\t\tphi\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*REAL(acceptSamples_r)[s * nThetapTilde + phiIndx * pTilde + ll], exp(tuning[phiIndx * pTilde + ll]));
-	    if (corName == "matern") {
+	    if (isMatern) {
               Rprintf("\t%i\t\tnu\t\t%3.1f\t\t%1.5f\n", ll + 1, 100.0*REAL(acceptSamples_r)[s * nThetapTilde + nuIndx * pTilde + ll], exp(tuning[nuIndx * pTilde + ll]));
 	    }
 	    if (sigmaSqIG == 0) {
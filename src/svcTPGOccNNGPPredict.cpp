@@ -27,7 +27,8 @@ extern "C" {
 			    SEXP covModel_r, SEXP nThreads_r, SEXP verbose_r, 
 			    SEXP nReport_r){
 
-    int i, j, k, l, ll, s, t, info, nProtect=0;
+    int i, j, k, l, ll, t, info, nProtect=0;
+    R_xlen_t s;
     const int inc = 1;
     const double one = 1.0;
     const double zero = 0.0;
@@ -46,9 +47,9 @@ extern "C" {
     int q = INTEGER(q_r)[0];
     int m = INTEGER(m_r)[0]; 
     int mm = m * m; 
-    int qnYears = q * nYears;
-    int JpTilde = J * pTilde;
-    int qpTilde = q * pTilde;
+    int qnYears = intProd(q, nYears);
+    int JpTilde = intProd(J, pTilde);
+    int qpTilde = intProd(q, pTilde);
 
     int *nnIndx0 = INTEGER(nnIndx0_r);        
     double *beta = REAL(betaSamples_r);
@@ -60,6 +61,7 @@ extern "C" {
     int nSamples = INTEGER(nSamples_r)[0];
     int covModel = INTEGER(covModel_r)[0];
     std::string corName = getCorName(covModel);
+    bool isMatern = (corName == "matern");
     int nThreads = INTEGER(nThreads_r)[0];
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
@@ -93,7 +95,7 @@ extern "C" {
     // parameters
     int nTheta, sigmaSqIndx,  phiIndx, nuIndx;
 
-    if (corName != "matern") {
+    if (!isMatern) {
       nTheta = 2; //sigma^2, phi
       sigmaSqIndx = 0; phiIndx = 1;
       } else{
@@ -111,7 +113,7 @@ extern "C" {
       nb[ll] = 0; 
     }
 
-    if(corName == "matern"){
+    if(isMatern){
       for (ll = 0; ll < pTilde; ll++) {
         for(s = 0; s < nSamples; s++){
           if(theta[s*nThetapTilde + nuIndx * pTilde + ll] > nuMax[ll]){
@@ -144,7 +146,7 @@ extern "C" {
     double *z0 = REAL(z0_r);
     double *psi0 = REAL(psi0_r); 
     double *w0 = REAL(w0_r);
-    zeros(w0, qpTilde * nSamples);
+    zeros(w0, static_cast<R_xlen_t>(qpTilde) * nSamples);
     double wSites = 0.0; 
  
     if (verbose) {
@@ -156,14 +158,16 @@ extern "C" {
       #endif
     }
 
-    int vIndx = -1;
-    double *wV = (double *) R_alloc(qpTilde*nSamples, sizeof(double));
+    R_xlen_t vIndx = -1, nWV;
+    nWV = static_cast<R_xlen_t>(qpTilde)*nSamples;
+    double *wV = (double *) R_alloc(nWV, sizeof(double));
 
     GetRNGstate();
     
-    for(i = 0; i < qpTilde*nSamples; i++){
-      wV[i] = rnorm(0.0,1.0);
+    for(vIndx = 0; vIndx < nWV; vIndx++){
+      wV[vIndx] = rnorm(0.0,1.0);
     }
+    vIndx = -1;
     
     for(j = 0; j < q; j++){
       for (ll = 0; ll < pTilde; ll++) {
@@ -175,7 +179,7 @@ extern "C" {
 	  threadID = omp_get_thread_num();
 #endif 	
 	  phi = theta[s * nThetapTilde + phiIndx * pTilde + ll];
-	  if(corName == "matern"){
+	  if(isMatern){
 	    nu = theta[s * nThetapTilde + nuIndx * pTilde + ll];
 	  }
 	  sigmaSq = theta[s * nThetapTilde + sigmaSqIndx * pTilde + ll];
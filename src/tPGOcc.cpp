@@ -104,7 +104,7 @@ extern "C" {
     double sigmaSqTB = REAL(ar1Vals_r)[3];
     int nBatch = INTEGER(nBatch_r)[0]; 
     int batchLength = INTEGER(batchLength_r)[0]; 
-    int nSamples = nBatch * batchLength; 
+    int nSamples = intProd(nBatch, batchLength); 
     double acceptRate = REAL(acceptRate_r)[0];
     double *tuning = REAL(tuning_r); 
     int nThin = INTEGER(nThin_r)[0]; 
@@ -116,13 +116,14 @@ extern "C" {
     int verbose = INTEGER(verbose_r)[0];
     int nReport = INTEGER(nReport_r)[0];
     int thinIndx = 0; 
-    int sPost = 0; 
+    int saveIter = 0;
+    R_xlen_t sPost = 0; 
     int status = 0;
 
     // Some constants
     int pOccnYears = pOcc * nYearsMax;
     int pDetnYears = pDet * nYearsMax;
-    int JnYears = J * nYearsMax;
+    int JnYears = intProd(J, nYearsMax);
 
 #ifdef _OPENMP
     omp_set_num_threads(nThreads);
@@ -189,11 +190,30 @@ extern "C" {
     // Latent Occurrence
     double *z = (double *) R_alloc(JnYears, sizeof(double));   
     F77_NAME(dcopy)(&JnYears, REAL(zStarting_r), &inc, z, &inc);
+    // Site/year combinations with data, stored in a ragged layout grouped by 
+    // site. The occurrence auxiliary variables and design matrix are only 
+    // needed for these combinations. 
+    int nDat = 0; 
+    for (j = 0; j < JnYears; j++) {
+      nDat += zDatIndx[j]; 
+    }
+    int *siteYearLU = (int *) R_alloc(2 * J, sizeof(int)); 
+    int *datYearIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    int *datCellIndx = (int *) R_alloc(nDat, sizeof(int)); 
+    mkSiteYearIndx(J, nYearsMax, zDatIndx, siteYearLU, datYearIndx, datCellIndx); 
+    int nDatpOcc = intProd(nDat, pOcc); 
+    // X stays padded to all site/year cells and is indexed through 
+    // datCellIndx. XBetaDat holds the occurrence linear predictor of the 
+    // cells with observations for the current beta. 
+    double *XBetaDat = (double *) R_alloc(nDat, sizeof(double)); 
+    for (ii = 0; ii < nDat; ii++) {
+      XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+    }
     // PG auxiliary variables 
     double *omegaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(omegaDet, nObs);
-    double *omegaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(omegaOcc, JnYears);
+    double *omegaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(omegaOcc, nDat);
     double *kappaDet = (double *) R_alloc(nObs, sizeof(double)); zeros(kappaDet, nObs);
-    double *kappaOcc = (double *) R_alloc(JnYears, sizeof(double)); zeros(kappaOcc, JnYears);
+    double *kappaOcc = (double *) R_alloc(nDat, sizeof(double)); zeros(kappaOcc, nDat);
 
     /**********************************************************************
      * Return Stuff
@@ -231,11 +251,10 @@ extern "C" {
     /**********************************************************************
      * Other initial starting stuff
      * *******************************************************************/
-    int JpOcc = J * pOcc; 
-    int JJ = J * J; 
+    int JpOcc = intProd(J, pOcc); 
     int JnYearspOccRE = J * nYearsMax * pOccRE; 
-    int nObspDet = nObs * pDet;
-    int nObspDetRE = nObs * pDetRE;
+    int nObspDet = intProd(nObs, pDet);
+    int nObspDetRE = intProd(nObs, pDetRE);
     int nnYears = nYearsMax * nYearsMax;
     int jj, kk;
     double tmp_0 = 0.0;
@@ -264,10 +283,10 @@ extern "C" {
     zeros(tmp_J1, J);
     double *tmp_nObs = (double *) R_alloc(nObs, sizeof(double));
     zeros(tmp_nObs, nObs);
-    double *tmp_JnYears = (double *) R_alloc(JnYears, sizeof(double));
-    zeros(tmp_JnYears, JnYears);
-    double *tmp_JnYearspOcc = (double *) R_alloc(JnYears * pOcc, sizeof(double));
-    zeros(tmp_JnYearspOcc, JnYears * pOcc);
+    double *tmp_nDat = (double *) R_alloc(nDat, sizeof(double));
+    zeros(tmp_nDat, nDat);
+    double *tmp_nDatpOcc = (double *) R_alloc(nDatpOcc, sizeof(double));
+    zeros(tmp_nDatpOcc, nDatpOcc);
     double *tmp_JnYears1 = (double *) R_alloc(JnYears, sizeof(double));
     int indx = 0;
 
@@ -350,7 +369,7 @@ extern "C" {
     double *accept2 = (double *) R_alloc(nTheta, sizeof(double)); 
     zeros(accept2, nTheta); 
     double *theta = (double *) R_alloc(nTheta, sizeof(double));
-    double logMHRatio, logPostCurr = 0.0, logPostCand = 0.0, detCand = 0.0, detCurr = 0.0;
+    double logPostCurr = 0.0, logPostCand = 0.0, detCand = 0.0, detCurr = 0.0;
     double rhoCand = 0.0; 
     SEXP thetaSamples_r; 
     if (ar1) {
@@ -378,6 +397,19 @@ extern "C" {
     // For sigmaSqT sampler
     double aSigmaSqTPost = 0.5 * nYearsMax + sigmaSqTA;
     double bSigmaSqTPost = 0.0;
+    // Adaptive block Metropolis for (rho, sigmaSqT) on the (logit, log) scale. 
+    // sigmaSqT is still Gibbs updated, with the joint move following it. 
+    int arD = 2, arN = 0; 
+    double sigmaSqTCand = 0.0;
+    double *arX = (double *) R_alloc(arD, sizeof(double)); 
+    double *arXCand = (double *) R_alloc(arD, sizeof(double)); 
+    double *arSD = (double *) R_alloc(arD, sizeof(double)); 
+    double *arMean = (double *) R_alloc(arD, sizeof(double)); zeros(arMean, arD); 
+    double *arM2 = (double *) R_alloc(arD*arD, sizeof(double)); zeros(arM2, arD*arD); 
+    double *arChol = (double *) R_alloc(arD*arD, sizeof(double)); 
+    arSD[0] = exp(tuning[rhoIndx]); 
+    arSD[1] = arSD[0]; 
+    mkAMChol(arSD, arM2, arN, arD, arChol); 
     double *etaTRInv = (double *) R_alloc(nYearsMax, sizeof(double));
 
     GetRNGstate();
@@ -390,81 +422,63 @@ extern "C" {
         /********************************************************************
          *Update Occupancy Auxiliary Variables 
          *******************************************************************/
-        zeros(tmp_JnYears, JnYears);
-        for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            // Only calculate omegaOcc when there are observations at that 
-            // site/year combo. Otherwise, you're just wasting time. 
-            if (zDatIndx[t * J + j] == 1) { 
-              tmp_JnYears[t * J + j] = F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, 
-                 	                      beta, &inc);
-              omegaOcc[t * J + j] = rpg(1.0, tmp_JnYears[t * J + j] + betaStarSites[t * J + j] + 
-			                     eta[t]);
-              // Update kappa values along the way. 
-              kappaOcc[t * J + j] = z[t * J + j] - 1.0 / 2.0; 
-            }
-          } // j 
-        } // t
+        // Only calculate omegaOcc for site/year combos with observations. 
+        for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+          omegaOcc[ii] = XBetaDat[ii] + betaStarSites[jt] + eta[datYearIndx[ii]];
+          // Update kappa values along the way. 
+          kappaOcc[ii] = z[jt] - 1.0 / 2.0; 
+        } // ii
+        rpgBatch(nDat, &one, 0, omegaOcc, inc, omegaOcc, inc);
         zeros(kappaDet, nObs);
         /********************************************************************
          *Update Detection Auxiliary Variables 
          *******************************************************************/
         // Only need to sample locations where z[i] == 1.0; 
-        for (t = 0; t < nYearsMax; t++) {
-          for (i = 0; i < nObs; i++) {
-            // If current observation is from the current year. 
-            if (zYearIndx[zLongIndx[i]] == t) {
-              // Reset
-              omegaDet[i] = 0.0;
-              // If the site is occupied and data were collected at that site. 
-              if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
-                omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
-                // Update kappa values along the way. 
-                kappaDet[i] = (y[i] - 1.0 / 2.0);
-              }
-            }
-          } // i
-        } // t
+        for (i = 0; i < nObs; i++) {
+          // Reset
+          omegaDet[i] = 0.0;
+          // If the site is occupied and data were collected at that site. 
+          if ((z[zLongIndx[i]] == 1.0) && (zDatIndx[zLongIndx[i]] == 1)) {
+            omegaDet[i] = rpg(1.0, F77_NAME(ddot)(&pDet, &Xp[i], &nObs, alpha, &inc) + alphaStarObs[i]);
+            // Update kappa values along the way. 
+            kappaDet[i] = (y[i] - 1.0 / 2.0);
+          }
+        } // i
 
         /********************************************************************
          *Update Occupancy Regression Coefficients
          *******************************************************************/
-        zeros(tmp_JnYears, JnYears);
-        for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              tmp_JnYears[t * J + j] = kappaOcc[t * J + j] - omegaOcc[t * J + j] * (betaStarSites[t * J + j] + eta[t]); 
-            }
-          } // j
-        } // t
+        for (ii = 0; ii < nDat; ii++) {
+          jt = datCellIndx[ii];
+          tmp_nDat[ii] = kappaOcc[ii] - omegaOcc[ii] * (betaStarSites[jt] + eta[datYearIndx[ii]]); 
+        } // ii
         /********************************
          * Compute b.beta
          *******************************/
-        // This is fine, because the elements in tmp_JnYears corresponding
-        // to unobserve site/time locations is set to 0 and not changed. 
-        F77_NAME(dgemv)(ytran, &JnYears, &pOcc, &one, X, &JnYears, 
-        		tmp_JnYears, &inc, &zero, tmp_pOcc, &inc FCONE); 	 
+        // Only the site/year combos with observations contribute. 
         for (j = 0; j < pOcc; j++) {
-          tmp_pOcc[j] += SigmaBetaInvMuBeta[j]; 
+          tmp_pOcc[j] = SigmaBetaInvMuBeta[j]; 
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_pOcc[j] += X[j * JnYears + datCellIndx[ii]] * tmp_nDat[ii]; 
+          } // ii
         } // j 
 
         /********************************
          * Compute A.beta
          * *****************************/
-        // This is fine, because omegaOcc == 0 for the site/year combos
-        // that don't have any observations at them, which will cause this
-        // whole product to go to 0.  
-        for (t = 0; t < nYearsMax; t++) {
-          for (j = 0; j < J; j++) {
-            if (zDatIndx[t * J + j] == 1) {
-              for(i = 0; i < pOcc; i++){
-                tmp_JnYearspOcc[i * JnYears + t * J + j] = X[i * JnYears + t * J + j] * omegaOcc[t * J + j];
-              } // i
-            }
-          } // j
-        } // t
+        // Rows of X for the cells with observations, scaled by sqrt(omegaOcc), 
+        // so X' diag(omegaOcc) X is a single rank-k update (lower triangle). 
+        for (ii = 0; ii < nDat; ii++) {
+          tmp_nDat[ii] = sqrt(omegaOcc[ii]); 
+        } // ii
+        for (i = 0; i < pOcc; i++) {
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_nDatpOcc[i * nDat + ii] = X[i * JnYears + datCellIndx[ii]] * tmp_nDat[ii];
+          } // ii
+        } // i
 
-        F77_NAME(dgemm)(ytran, ntran, &pOcc, &pOcc, &JnYears, &one, X, &JnYears, tmp_JnYearspOcc, &JnYears, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
+        F77_NAME(dsyrk)(lower, ytran, &pOcc, &nDat, &one, tmp_nDatpOcc, &nDat, &zero, tmp_ppOcc, &pOcc FCONE FCONE);
         for (j = 0; j < ppOcc; j++) {
           tmp_ppOcc[j] += SigmaBetaInv[j]; 
         } // j
@@ -478,6 +492,9 @@ extern "C" {
         F77_NAME(dpotrf)(lower, &pOcc, tmp_ppOcc, &pOcc, &info FCONE); 
         if(info != 0){error("c++ error: dpotrf A.beta2 failed\n");}
         mvrnorm(beta, tmp_pOcc2, tmp_ppOcc, pOcc);
+        for (ii = 0; ii < nDat; ii++) {
+          XBetaDat[ii] = F77_NAME(ddot)(&pOcc, &X[datCellIndx[ii]], &JnYears, beta, &inc); 
+        } // ii
 
         /********************************************************************
          *Update Detection covariates
@@ -558,21 +575,18 @@ extern "C" {
             // Only allow information to come from when XRE == betaLevelIndx[l]. 
             // aka information only comes from the sites with any given level 
             // of a random effect. 
-            for (t = 0; t < nYearsMax; t++) {
-              for (j = 0; j < J; j++) {
-                if (XRE[betaStarIndx[l] * JnYears + t * J + j] == betaLevelIndx[l]) {
-                  if (zDatIndx[t * J + j] == 1) {
-                    tmp_02 = 0.0;
-                    for (rr = 0; rr < pOccRE; rr++) {
-                      tmp_02 += betaStar[betaStarLongIndx[rr * JnYears + t * J + j]];
-	            } 
-                    tmp_one[0] += kappaOcc[t * J + j] - (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + 
-                    	    tmp_02 - betaStar[l] + eta[t]) * omegaOcc[t * J + j];
-                    tmp_0 += omegaOcc[t * J + j];
-		  }
-                }
+            for (ii = 0; ii < nDat; ii++) {
+              jt = datCellIndx[ii];
+              if (XRE[betaStarIndx[l] * JnYears + jt] == betaLevelIndx[l]) {
+                tmp_02 = 0.0;
+                for (rr = 0; rr < pOccRE; rr++) {
+                  tmp_02 += betaStar[betaStarLongIndx[rr * JnYears + jt]];
+                } 
+                tmp_one[0] += kappaOcc[ii] - (XBetaDat[ii] + 
+                	      tmp_02 - betaStar[l] + eta[datYearIndx[ii]]) * omegaOcc[ii];
+                tmp_0 += omegaOcc[ii];
               }
-            }
+            } // ii
             /********************************
              * Compute A.beta.star
              *******************************/
@@ -652,15 +666,18 @@ extern "C" {
 	  theta[sigmaSqTIndx] = rigamma(aSigmaSqTPost, bSigmaSqTPost);
           
           /********************************************************************
-           *Update rho
+           *Update rho and sigmaSqT
            *******************************************************************/
 	  rho = theta[rhoIndx];
 	  sigmaSqT = theta[sigmaSqTIndx];
-	  rhoCand = logitInv(rnorm(logit(rho, rhoA, rhoB), exp(tuning[rhoIndx])), rhoA, rhoB); 
-	  theta[rhoIndx] = rhoCand; 
+	  arX[0] = logit(rho, rhoA, rhoB); 
+	  arX[1] = log(sigmaSqT); 
+	  mvrnorm(arXCand, arX, arChol, arD); 
+	  rhoCand = logitInv(arXCand[0], rhoA, rhoB); 
+	  sigmaSqTCand = exp(arXCand[1]); 
 
 	  // Construct proposal covariance matrix. 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEtaCand);
+          AR1(nYearsMax, rhoCand, sigmaSqTCand, SigmaEtaCand);
 	  clearUT(SigmaEtaCand, nYearsMax);
 
           /********************************
@@ -679,13 +696,14 @@ extern "C" {
           logPostCand = 0.0; 
 	  // Jacobian and Uniform prior. 
 	  logPostCand += log(rhoCand - rhoA) + log(rhoB - rhoCand); 
+	  // Jacobian and IG prior. 
+	  logPostCand += -1.0 * sigmaSqTA * log(sigmaSqTCand) - sigmaSqTB / sigmaSqTCand; 
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one,  SigmaEtaCand, &nYearsMax, eta, &inc, &zero, tmp_nYearsMax, &inc FCONE);
 	  logPostCand += -0.5*detCand-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
           /********************************
            * Current
            *******************************/
-	  theta[rhoIndx] = rho; 
-          AR1(nYearsMax, theta[rhoIndx], theta[sigmaSqTIndx], SigmaEta);
+          AR1(nYearsMax, rho, sigmaSqT, SigmaEta);
 	  clearUT(SigmaEta, nYearsMax);
           detCurr = 0.0;
 	  F77_NAME(dpotrf)(lower, &nYearsMax, SigmaEta, &nYearsMax, &info FCONE); 
@@ -697,18 +715,22 @@ extern "C" {
 	  if(info != 0){error("c++ error: Cholesky inverse failed in covariance matrix\n");}
           logPostCurr = 0.0; 
 	  logPostCurr += log(rho - rhoA) + log(rhoB - rho); 
+	  logPostCurr += -1.0 * sigmaSqTA * log(sigmaSqT) - sigmaSqTB / sigmaSqT; 
 	  // (-1/2) * tmp_JD` *  C^-1 * tmp_JD
 	  F77_NAME(dsymv)(lower, &nYearsMax, &one, SigmaEta, &nYearsMax, eta, &inc, &zero, 
 	  		tmp_nYearsMax, &inc FCONE);
 	  logPostCurr += -0.5*detCurr-0.5*F77_NAME(ddot)(&nYearsMax, eta, &inc, tmp_nYearsMax, &inc);
 
 	  // MH Accept/Reject
-	  logMHRatio = logPostCand - logPostCurr; 
-	  if (runif(0.0, 1.0) <= exp(logMHRatio)) {
+	  if (runif(0.0, 1.0) <= exp(logPostCand - logPostCurr)) {
             theta[rhoIndx] = rhoCand;
+            theta[sigmaSqTIndx] = sigmaSqTCand;
             accept[rhoIndx]++;
 	    F77_NAME(dcopy)(&nnYears, SigmaEtaCand, &inc, SigmaEta, &inc); 
+	    F77_NAME(dcopy)(&arD, arXCand, &inc, arX, &inc); 
           }
+          updateAM(arX, arMean, arM2, arN, arD); 
+          arN++; 
           
           /********************************************************************
            *Update eta 
@@ -717,25 +739,18 @@ extern "C" {
            * Compute b.w
            *******************************/
 	  zeros(tmp_nYearsMax, nYearsMax);
-          for (j = 0; j < J; j++) {
-            for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nYearsMax[t] += kappaOcc[t * J + j] - omegaOcc[t * J + j] * (F77_NAME(ddot)(&pOcc, &X[t * J + j], &JnYears, beta, &inc) + betaStarSites[t * J + j]);
-	      }
-	    }
-          }
+          for (ii = 0; ii < nDat; ii++) {
+            tmp_nYearsMax[datYearIndx[ii]] += kappaOcc[ii] - omegaOcc[ii] * (XBetaDat[ii] + betaStarSites[datCellIndx[ii]]);
+          } // ii
           /********************************
            * Compute A.w
            *******************************/
 	  // Copy inverse covariance matrix into tmp_JJ
 	  F77_NAME(dcopy)(&nnYears, SigmaEta, &inc, tmp_nnYears, &inc); 
-          for (j = 0; j < J; j++) {
-	    for (t = 0; t < nYearsMax; t++) {
-              if (zDatIndx[t * J + j] == 1) {
-                tmp_nnYears[t * nYearsMax + t] += omegaOcc[t * J + j];
-	      }
-	    } // t
-	  } // j
+          for (ii = 0; ii < nDat; ii++) {
+            t = datYearIndx[ii];
+            tmp_nnYears[t * nYearsMax + t] += omegaOcc[ii];
+          } // ii
 
           // Cholesky of A.eta
           F77_NAME(dpotrf)(lower, &nYearsMax, tmp_nnYears, &nYearsMax, &info FCONE); 
@@ -752,6 +767,8 @@ extern "C" {
           mvrnorm(eta, tmp_nYearsMax2, tmp_nnYears, nYearsMax);
 	}
 
+        // Likelihood values for WAIC are only needed on iterations that are saved.
+        saveIter = (ll >= nBurn) && (thinIndx + 1 == nThin);
         /********************************************************************
          *Update Latent Occupancy
          *******************************************************************/
@@ -765,8 +782,10 @@ extern "C" {
         			         zero, one); 
           }
           piProd[zLongIndx[i]] *= (1.0 - detProb[i]);
-          piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
-          piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  if (saveIter) {
+	    piProdWAIC[zLongIndx[i]] *= pow(detProb[i], y[i]);
+	    piProdWAIC[zLongIndx[i]] *= pow(1.0 - detProb[i], 1 - y[i]);
+	  }
           ySum[zLongIndx[i]] += y[i]; 	
           tmp_JnYearsInt[zLongIndx[i]]++;
         } // i
@@ -778,10 +797,14 @@ extern "C" {
             if (zDatIndx[t * J + j] == 1) {
               if (ySum[t * J + j] == zero) {
                 z[t * J + j] = rbinom(one, psiNum / (psiNum + (1.0 - psi[t * J + j])));
-                yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];	
+		if (saveIter) {
+		  yWAIC[t * J + j] = (1.0 - psi[t * J + j]) + psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               } else {
                 z[t * J + j] = one; 
-                yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		if (saveIter) {
+		  yWAIC[t * J + j] = psi[t * J + j] * piProdWAIC[t * J + j];
+		}
               }
             } else {
               psi[t * J + j] = logitInv(F77_NAME(ddot)(&pOcc, &X[t * J + j], 
@@ -844,6 +867,13 @@ extern "C" {
           accept[k] = 0;
         }
       }
+      if (ar1) {
+        arSD[0] = exp(tuning[rhoIndx]); 
+        if (arN > 1) {
+          arSD[1] = 2.38 / sqrt(2.0) * sqrt(arM2[3] / (arN - 1.0)); 
+        }
+        mkAMChol(arSD, arM2, arN, arD, arChol); 
+      }
       /********************************************************************
        *Report 
        *******************************************************************/
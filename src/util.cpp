@@ -1,6 +1,7 @@
 #define USE_FC_LEN_T
 #include <string>
 #include <limits>
+#include <climits>
 #include "util.h"
 
 #ifdef _OPENMP
@@ -11,18 +12,19 @@
 #include <Rmath.h>
 #include <Rinternals.h>
 #include <R_ext/BLAS.h>
+#include <R_ext/Lapack.h>
 #include <R_ext/Utils.h>
 #ifndef FCONE
 # define FCONE
 #endif
 
-  void zeros(double *a, int n){
-    for(int i = 0; i < n; i++)
+  void zeros(double *a, ptrdiff_t n){
+    for(ptrdiff_t i = 0; i < n; i++)
       a[i] = 0.0;
   }
 
-  void ones(double *a, int n){
-    for(int i = 0; i < n; i++)
+  void ones(double *a, ptrdiff_t n){
+    for(ptrdiff_t i = 0; i < n; i++)
       a[i] = 1.0;
   }
   
@@ -115,7 +117,7 @@
   void mkUIndx2(int n, int m, int* nnIndx, int *nnIndxLU, int* uIndx, int* uIndxLU){ 
   
     int i, k;
-    int nIndx = static_cast<int>(static_cast<double>(1+m)/2*m+(n-m-1)*m);
+    int nIndx = getNIndx(n, m);
     
     //int *j_A = new int[nIndx]; is nnIndx
     int *i_nnIndx = new int[n+1];
@@ -527,3 +529,476 @@ void AR1(int n, double rho, double sigmaSq, double *C){
     }
   }
 }
+
+//Description: one-pass update of the running mean and cross-product matrix of a 
+//d-dimensional block of transformed (e.g., logit) covariance parameters. n is the 
+//number of draws already included in mean and M2.
+void updateAM(double *x, double *mean, double *M2, int n, int d){
+
+  int i, j;
+  double wt = static_cast<double>(n) / (n + 1.0);
+
+  for(j = 0; j < d; j++){
+    for(i = 0; i < d; i++){
+      M2[j*d+i] += wt*(x[i]-mean[i])*(x[j]-mean[j]);
+    }
+  }
+  for(i = 0; i < d; i++){
+    mean[i] += (x[i]-mean[i])/(n + 1.0);
+  }
+}
+
+//Description: lower Cholesky factor of the adaptive block Metropolis proposal covariance 
+//D*R*D, where D = diag(sd) holds the batch-adapted proposal standard deviations and R is 
+//the correlation matrix estimated from M2 (see updateAM), shrunk toward the identity. 
+//Until 100*d draws are available, or if the shrunken estimate is not positive definite, 
+//the proposal reverts to D^2 (i.e., independent random walks).
+void mkAMChol(double *sd, double *M2, int n, int d, double *chol){
+
+  int i, j, info = 0;
+  double lambda;
+
+  zeros(chol, d*d);
+
+  if(d > 1 && n >= 100*d){
+    lambda = fmin2(1.0, 0.05 + 10.0*d/n);
+    for(j = 0; j < d; j++){
+      chol[j*d+j] = sd[j]*sd[j];
+      for(i = j+1; i < d; i++){
+        if(M2[i*d+i] > 0.0 && M2[j*d+j] > 0.0){
+          chol[j*d+i] = (1.0-lambda)*M2[j*d+i]/sqrt(M2[i*d+i]*M2[j*d+j])*sd[i]*sd[j];
+        }
+      }
+    }
+    F77_NAME(dpotrf)("L", &d, chol, &d, &info FCONE);
+    if(info == 0){
+      return;
+    }
+    zeros(chol, d*d);
+  }
+
+  for(i = 0; i < d; i++){
+    chol[i*d+i] = sd[i];
+  }
+}
+
+//Description: greedy coloring of the NNGP Markov random field. Two locations share a 
+//color only if neither is in the other's Markov blanket (its neighbors, the locations 
+//that have it as a neighbor, and their neighbors), so all locations of one color are 
+//conditionally independent and can be updated in parallel. colorIndx (length n) holds 
+//the location indexes grouped by color and colorLU (length 2n) holds the start in 
+//colorIndx and the number of locations of each color (same layout as nnIndxLU). 
+//Returns the number of colors.
+int mkColorIndx(int n, int *nnIndx, int *nnIndxLU, int *uIndx, int *uIndxLU, int *colorIndx, int *colorLU){
+
+  int i, j, k, jj, c, nColors = 0;
+  int *color = (int *) R_alloc(n, sizeof(int));
+  int *used = (int *) R_alloc(n, sizeof(int));
+
+  for(i = 0; i < n; i++){
+    color[i] = -1;
+    used[i] = -1;
+  }
+
+  for(i = 0; i < n; i++){
+    for(k = 0; k < nnIndxLU[n+i]; k++){
+      c = color[nnIndx[nnIndxLU[i]+k]];
+      if(c >= 0){used[c] = i;}
+    }
+    for(j = 0; j < uIndxLU[n+i]; j++){
+      jj = uIndx[uIndxLU[i]+j];
+      c = color[jj];
+      if(c >= 0){used[c] = i;}
+      for(k = 0; k < nnIndxLU[n+jj]; k++){
+        c = color[nnIndx[nnIndxLU[jj]+k]];
+        if(c >= 0){used[c] = i;}
+      }
+    }
+    c = 0;
+    while(used[c] == i){
+      c++;
+    }
+    color[i] = c;
+    if(c + 1 > nColors){
+      nColors = c + 1;
+    }
+  }
+
+  for(c = 0; c < 2*n; c++){
+    colorLU[c] = 0;
+  }
+  for(i = 0; i < n; i++){
+    colorLU[n+color[i]]++;
+  }
+  for(c = 1; c < nColors; c++){
+    colorLU[c] = colorLU[c-1] + colorLU[n+c-1];
+  }
+  for(c = 0; c < nColors; c++){
+    used[c] = colorLU[c];
+  }
+  for(i = 0; i < n; i++){
+    colorIndx[used[color[i]]] = i;
+    used[color[i]]++;
+  }
+
+  return(nColors);
+}
+
+//Description: ragged (CSR) index of the site/year combinations with data in a multi-season 
+//model. datIndx (length J*nYears, year-major) is 1 when site j was sampled in year t. The 
+//sampled combinations are numbered by site and then by year: siteYearLU (length 2J) holds 
+//the start and the number of sampled years of each site (same layout as nnIndxLU), yearIndx 
+//the year and cellIndx the position t*J+j of each combination in the padded J x nYears arrays. 
+//Returns the number of sampled combinations.
+int mkSiteYearIndx(int J, int nYears, int *datIndx, int *siteYearLU, int *yearIndx, int *cellIndx){
+
+  int j, t, k = 0;
+
+  for(j = 0; j < J; j++){
+    siteYearLU[j] = k;
+    for(t = 0; t < nYears; t++){
+      if(datIndx[t*J+j] == 1){
+        yearIndx[k] = t;
+        cellIndx[k] = t*J+j;
+        k++;
+      }
+    }
+    siteYearLU[J+j] = k - siteYearLU[j];
+  }
+
+  return(k);
+}
+
+//Description: per-thread random number streams for use inside OpenMP regions, where 
+//R's generator cannot be called. Each thread owns one xorshift64* state in 
+//state[threadID]. The states are seeded from R's generator, so set.seed() reproduces 
+//results for a given number of threads.
+void seedThreadRNG(unsigned long long *state, int nThreads){
+
+  int i;
+
+  for(i = 0; i < nThreads; i++){
+    state[i] = (static_cast<unsigned long long>(unif_rand()*4294967296.0) << 32) ^ 
+               static_cast<unsigned long long>(unif_rand()*4294967296.0);
+    if(state[i] == 0){
+      state[i] = 0x9E3779B97F4A7C15ULL;
+    }
+  }
+}
+
+double unifThread(unsigned long long *state){
+
+  unsigned long long x = *state;
+
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  // Upper 53 bits mapped to the open interval (0, 1).
+  return((static_cast<double>((x * 0x2545F4914F6CDD1DULL) >> 11) + 0.5) / 9007199254740992.0);
+}
+
+double normThread(unsigned long long *state){
+
+  double u1 = unifThread(state);
+  double u2 = unifThread(state);
+
+  return(sqrt(-2.0*log(u1))*cos(2.0*M_PI*u2));
+}
+
+//Description: inverse gamma draw with shape a and scale b from a per-thread stream, using 
+//the Marsaglia and Tsang (2000) squeeze method for the underlying gamma draw.
+double rigammaThread(double a, double b, unsigned long long *state){
+
+  double d, c, x, v, u, boost = 1.0;
+
+  if(a < 1.0){
+    boost = pow(unifThread(state), 1.0/a);
+    a += 1.0;
+  }
+  d = a - 1.0/3.0;
+  c = 1.0/sqrt(9.0*d);
+  while(1){
+    do{
+      x = normThread(state);
+      v = 1.0 + c*x;
+    }while(v <= 0.0);
+    v = v*v*v;
+    u = unifThread(state);
+    if(u < 1.0 - 0.0331*x*x*x*x){
+      break;
+    }
+    if(log(u) < 0.5*x*x + d*(1.0 - v + log(v))){
+      break;
+    }
+  }
+
+  return(b/(d*v*boost));
+}
+
+//Description: mvrnorm using a per-thread stream.
+void mvrnormThread(double *des, double *mu, double *cholCov, int dim, unsigned long long *state){
+    
+  int i;
+  int inc = 1;
+  double one = 1.0;
+    
+  for(i = 0; i < dim; i++){
+    des[i] = normThread(state);
+  }
+   
+  F77_NAME(dtrmv)("L", "N", "N", &dim, cholCov, &dim, des, &inc FCONE FCONE FCONE);
+  F77_NAME(daxpy)(&dim, &one, mu, &inc, des, &inc);
+}
+
+//Description: product of two array extents that is used as a matrix dimension or passed 
+//to BLAS/LAPACK, and so must fit in an int. Stops with an error rather than overflowing.
+int intProd(int a, int b){
+
+  if(static_cast<double>(a)*b > INT_MAX){
+    error("c++ error: array dimension %i x %i exceeds the maximum integer size\n", a, b);
+  }
+  return(a*b);
+}
+
+//Description: length of the nearest neighbor index vector nnIndx for n locations and m 
+//neighbors, i.e., (1+m)/2*m+(n-m-1)*m, with a check that it can be indexed by an int.
+int getNIndx(int n, int m){
+
+  double nIndx = static_cast<double>(1+m)/2*m+(static_cast<double>(n)-m-1)*m;
+
+  if(nIndx > INT_MAX){
+    error("c++ error: the neighbor index for %i locations and %i neighbors exceeds the maximum integer size\n", n, m);
+  }
+  return(static_cast<int>(nIndx));
+}
+
+//Description: compressed row copy of the n x p column-major design matrix A when at most 
+//maxDensity of its elements are nonzero (e.g., many indicator columns for factor levels). 
+int mkCSR(int n, int p, double *A, double maxDensity, int **rowPtr, int **colIndx, double **val){
+
+  int i, k, l;
+  R_xlen_t nnz = 0;
+
+  for(k = 0; k < p; k++){
+    for(i = 0; i < n; i++){
+      if(A[static_cast<R_xlen_t>(k)*n+i] != 0.0){
+	nnz++;
+      }
+    }
+  }
+  if(n == 0 || p == 0 || nnz > maxDensity*n*p){
+    *rowPtr = NULL;
+    *colIndx = NULL;
+    *val = NULL;
+    return(0);
+  }
+
+  *rowPtr = (int *) R_alloc(n+1, sizeof(int));
+  *colIndx = (int *) R_alloc(nnz, sizeof(int));
+  *val = (double *) R_alloc(nnz, sizeof(double));
+
+  for(i = 0, l = 0; i < n; i++){
+    (*rowPtr)[i] = l;
+    for(k = 0; k < p; k++){
+      if(A[static_cast<R_xlen_t>(k)*n+i] != 0.0){
+	(*colIndx)[l] = k;
+	(*val)[l] = A[static_cast<R_xlen_t>(k)*n+i];
+	l++;
+      }
+    }
+  }
+  (*rowPtr)[n] = l;
+
+  return(1);
+}
+
+void designMv(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *x, double *y){
+
+  int i, l, inc = 1;
+  double one = 1.0, zero = 0.0;
+  char const *ntran = "N";
+
+  if(rowPtr == NULL){
+    F77_NAME(dgemv)(ntran, &n, &p, &one, A, &n, x, &inc, &zero, y, &inc FCONE);
+    return;
+  }
+  for(i = 0; i < n; i++){
+    y[i] = 0.0;
+    for(l = rowPtr[i]; l < rowPtr[i+1]; l++){
+      y[i] += val[l]*x[colIndx[l]];
+    }
+  }
+}
+
+void designTMv(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *x, double *y){
+
+  int i, l, inc = 1;
+  double one = 1.0, zero = 0.0;
+  char const *ytran = "T";
+
+  if(rowPtr == NULL){
+    F77_NAME(dgemv)(ytran, &n, &p, &one, A, &n, x, &inc, &zero, y, &inc FCONE);
+    return;
+  }
+  for(i = 0; i < p; i++){
+    y[i] = 0.0;
+  }
+  for(i = 0; i < n; i++){
+    for(l = rowPtr[i]; l < rowPtr[i+1]; l++){
+      y[colIndx[l]] += val[l]*x[i];
+    }
+  }
+}
+
+void designCrossprod(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *w, double *tmp_np, double *C){
+
+  int i, k, l, ll;
+  double one = 1.0, zero = 0.0, a;
+  char const *ntran = "N";
+  char const *ytran = "T";
+
+  if(rowPtr == NULL){
+    for(k = 0; k < p; k++){
+      for(i = 0; i < n; i++){
+	tmp_np[static_cast<R_xlen_t>(k)*n+i] = A[static_cast<R_xlen_t>(k)*n+i]*w[i];
+      }
+    }
+    F77_NAME(dgemm)(ytran, ntran, &p, &p, &n, &one, A, &n, tmp_np, &n, &zero, C, &p FCONE FCONE);
+    return;
+  }
+  for(i = 0; i < p*p; i++){
+    C[i] = 0.0;
+  }
+  //lower triangle, one outer product per row
+  for(i = 0; i < n; i++){
+    if(w[i] == 0.0){
+      continue;
+    }
+    for(l = rowPtr[i]; l < rowPtr[i+1]; l++){
+      a = val[l]*w[i];
+      for(ll = rowPtr[i]; ll <= l; ll++){
+	C[colIndx[ll]*p+colIndx[l]] += a*val[ll];
+      }
+    }
+  }
+  for(k = 0; k < p; k++){
+    for(i = k+1; i < p; i++){
+      C[i*p+k] = C[k*p+i];
+    }
+  }
+}
+
+//NNGP residuals wResid[i] = w_i - sum_k B_ik w_N(i)k of the n locations for the w sweeps.
+//w[i] is stored at w[i*incw] and B[l] at B[l*incB], so a single process of a multivariate 
+//w or an interleaved B can be used directly.
+void mkNNResid(int n, double *w, int incw, double *B, int incB, int *nnIndx, int *nnIndxLU, double *wResid){
+
+  int i, k;
+
+#ifdef _OPENMP
+#pragma omp parallel for private(k) schedule(static)
+#endif
+  for(i = 0; i < n; i++){
+    wResid[i] = w[static_cast<R_xlen_t>(i)*incw];
+    for(k = 0; k < nnIndxLU[n+i]; k++){
+      wResid[i] -= B[static_cast<R_xlen_t>(nnIndxLU[i]+k)*incB]*w[static_cast<R_xlen_t>(nnIndx[nnIndxLU[i]+k])*incw];
+    }
+  }
+}
+
+//Keeps the residuals current after w_i changes by delta: the residual of i itself and 
+//those of the locations that have i as a neighbor.
+void updateNNResid(int i, double delta, int n, double *B, int incB, int *nnIndxLU, int *uIndx, int *uIndxLU, int *uiIndx, double *wResid){
+
+  int j, jj;
+
+  wResid[i] += delta;
+  for(j = 0; j < uIndxLU[n+i]; j++){
+    jj = uIndx[uIndxLU[i]+j];
+    wResid[jj] -= B[static_cast<R_xlen_t>(nnIndxLU[jj]+uiIndx[uIndxLU[i]+j])*incB]*delta;
+  }
+}
+
+//NUMA placement policy for zerosFirstTouch*: 0 places each page with the thread that works 
+//on it in the static site partition, 1 interleaves pages over the threads.
+int numaPolicy(){
+
+  SEXP opt = GetOption1(install("spOccupancy.numa"));
+
+  if(isString(opt) && length(opt) > 0 && std::string(CHAR(STRING_ELT(opt, 0))) == "interleave"){
+    return 1;
+  }
+  return 0;
+}
+
+//Zero-fills a[0..n) in parallel so its pages are first touched by the threads that use them.
+void zerosFirstTouch(double *a, ptrdiff_t n, int nThreads, int policy){
+
+  ptrdiff_t i;
+  const int page = 4096 / sizeof(double);
+
+  if(nThreads < 2){
+    zeros(a, n);
+    return;
+  }
+  if(policy == 1){
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, page) num_threads(nThreads)
+#endif
+    for(i = 0; i < n; i++){
+      a[i] = 0.0;
+    }
+  }else{
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) num_threads(nThreads)
+#endif
+    for(i = 0; i < n; i++){
+      a[i] = 0.0;
+    }
+  }
+}
+
+//Column-major nRow x nCol version, e.g., the site by sample matrices: the rows of every 
+//column are split the same way, so each thread's sites stay on its node.
+void zerosFirstTouchCols(double *a, int nRow, int nCol, int nThreads, int policy){
+
+  int i, j;
+
+  if(nThreads < 2 || policy == 1){
+    zerosFirstTouch(a, static_cast<ptrdiff_t>(nRow)*nCol, nThreads, policy);
+    return;
+  }
+#ifdef _OPENMP
+#pragma omp parallel private(j) num_threads(nThreads)
+#endif
+  {
+    for(j = 0; j < nCol; j++){
+#ifdef _OPENMP
+#pragma omp for schedule(static) nowait
+#endif
+      for(i = 0; i < nRow; i++){
+	a[static_cast<ptrdiff_t>(j)*nRow+i] = 0.0;
+      }
+    }
+  }
+}
+
+//Neighbor weights B (nnIndx layout) split by site like updateBF.
+void zerosFirstTouchNN(double *B, int *nnIndxLU, int n, int nThreads, int policy){
+
+  int i, k;
+
+  if(nThreads < 2 || policy == 1){
+    zerosFirstTouch(B, static_cast<ptrdiff_t>(nnIndxLU[n-1])+nnIndxLU[2*n-1], nThreads, policy);
+    return;
+  }
+#ifdef _OPENMP
+#pragma omp parallel for private(k) schedule(static) num_threads(nThreads)
+#endif
+  for(i = 0; i < n; i++){
+    for(k = 0; k < nnIndxLU[n+i]; k++){
+      B[nnIndxLU[i]+k] = 0.0;
+    }
+  }
+}
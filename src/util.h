@@ -1,9 +1,10 @@
 #include <string>
+#include <cstddef>
 
 
-  void zeros(double *a, int n);
+  void zeros(double *a, ptrdiff_t n);
 
-  void ones(double *a, int n); 
+  void ones(double *a, ptrdiff_t n); 
   
   void mvrnorm(double *des, double *mu, double *cholCov, int dim);
   
@@ -50,3 +51,57 @@
   void clearUT(double *m, int n);
   void AR1(int n, double rho, double sigmaSq, double *C);
 
+  //Description: adaptive block Metropolis for correlated covariance parameters 
+  //(Haario et al. 2001). updateAM updates the running moments of the transformed block 
+  //and mkAMChol forms the Cholesky factor of the proposal covariance for use in mvrnorm.
+  void updateAM(double *x, double *mean, double *M2, int n, int d);
+  void mkAMChol(double *sd, double *M2, int n, int d, double *chol);
+
+  //Description: greedy coloring of the NNGP Markov random field for parallel updates of 
+  //conditionally independent locations. colorLU must be of length 2n. Returns the number of colors.
+  int mkColorIndx(int n, int *nnIndx, int *nnIndxLU, int *uIndx, int *uIndxLU, int *colorIndx, int *colorLU);
+
+  //Description: ragged index of the sampled site/year combinations of a multi-season model, 
+  //grouped by site. siteYearLU must be of length 2J. Returns the number of sampled combinations.
+  int mkSiteYearIndx(int J, int nYears, int *datIndx, int *siteYearLU, int *yearIndx, int *cellIndx);
+
+  //Description: per-thread uniform and standard normal draws for use inside OpenMP regions.
+  void seedThreadRNG(unsigned long long *state, int nThreads);
+  double unifThread(unsigned long long *state);
+  double normThread(unsigned long long *state);
+  double rigammaThread(double a, double b, unsigned long long *state);
+  void mvrnormThread(double *des, double *mu, double *cholCov, int dim, unsigned long long *state);
+
+  //Description: checked int product of two array extents and length of nnIndx for n locations 
+  //and m neighbors. Both stop with an error if the result does not fit in an int.
+  int intProd(int a, int b);
+  int getNIndx(int n, int m);
+
+  //Description: compressed row copies of sparse n x p design matrices and the products used 
+  //by the regression coefficient updates. mkCSR fills rowPtr (length n+1), colIndx and val 
+  //(R_alloc'd, length nnz) and returns 1 if the share of nonzero elements of A is at most 
+  //maxDensity, and 0 (nothing allocated) otherwise. The product functions use the compressed 
+  //copy when rowPtr is not NULL and the dense column-major A otherwise.
+  int mkCSR(int n, int p, double *A, double maxDensity, int **rowPtr, int **colIndx, double **val);
+  //y = A x
+  void designMv(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *x, double *y);
+  //y = t(A) x
+  void designTMv(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *x, double *y);
+  //C = t(A) diag(w) A; tmp_np is n x p work space, only used for the dense A
+  void designCrossprod(int n, int p, double *A, int *rowPtr, int *colIndx, double *val, double *w, double *tmp_np, double *C);
+
+  //Description: NNGP residuals w_i - B_i w_N(i) of the n locations (w and B with strides incw 
+  //and incB), and their O(neighbors) update after w_i changes by delta. The w sweeps use them 
+  //in place of rebuilding the conditional mean of every location that has i as a neighbor.
+  void mkNNResid(int n, double *w, int incw, double *B, int incB, int *nnIndx, int *nnIndxLU, double *wResid);
+  void updateNNResid(int i, double delta, int n, double *B, int incB, int *nnIndxLU, int *uIndx, int *uIndxLU, int *uiIndx, double *wResid);
+
+  //Description: NUMA placement of large work and sample arrays. A page lands on the node of 
+  //the thread that first writes it, so these zero-fill in parallel: with the static partition 
+  //over the n sites (or the rows of each column) that the parallel site loops use (policy 0), 
+  //or a page at a time round-robin over the threads (policy 1, interleaved). numaPolicy() 
+  //reads the option spOccupancy.numa ("local", the default, or "interleave").
+  int numaPolicy();
+  void zerosFirstTouch(double *a, ptrdiff_t n, int nThreads, int policy);
+  void zerosFirstTouchCols(double *a, int nRow, int nCol, int nThreads, int policy);
+  void zerosFirstTouchNN(double *B, int *nnIndxLU, int n, int nThreads, int policy);